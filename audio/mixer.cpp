@@ -505,8 +505,11 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(mixer);
 	assert(stream);
 
-	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	// Get a rate converter instance. The medium quality filters the common
+	// conversions like 22050 to 44100 or 48000 Hz, at about the cost of
+	// linear interpolation.
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo,
+	                               kRateConverterQualityMedium);
 }
 
 Channel::~Channel() {
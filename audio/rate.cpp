@@ -31,10 +31,14 @@
 #include "audio/audiostream.h"
 #include "audio/rate.h"
 #include "audio/mixer.h"
+#include "common/algorithm.h"
+#include "common/endian.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#include "math/simd.h"
+
 namespace Audio {
 
 
@@ -277,6 +281,350 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 #pragma mark -
 
 
+enum {
+	/** Fractional bits of the polyphase filter coefficients. */
+	POLYPHASE_COEFF_BITS = 15,
+	/** Limits the size of the coefficient table, which has phases * taps entries. */
+	POLYPHASE_MAX_PHASES = 1024,
+	POLYPHASE_MAX_TAPS = 64
+};
+
+/**
+ * Zeroth order modified Bessel function of the first kind, used for the
+ * Kaiser window.
+ */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/**
+ * Return the sums of the products of the n 16 bit values in x0 (and x1 in
+ * the stereo case) with those in c. n must be a multiple of 8 and c must be
+ * 16 byte aligned. The SSE2 version is part of outputSample().
+ */
+template<bool stereo>
+static inline void dotProducts(const int16 *x0, const int16 *x1, const int16 *c, int n, int32 &out0, int32 &out1) {
+#if defined(MATH_USE_NEON)
+	int32x4_t acc0 = vdupq_n_s32(0);
+	int32x4_t acc1 = vdupq_n_s32(0);
+	for (int i = 0; i < n; i += 8) {
+		int16x8_t y = vld1q_s16(c + i);
+		int16x8_t x = vld1q_s16(x0 + i);
+		acc0 = vmlal_s16(acc0, vget_low_s16(x), vget_low_s16(y));
+		acc0 = vmlal_s16(acc0, vget_high_s16(x), vget_high_s16(y));
+		if (stereo) {
+			x = vld1q_s16(x1 + i);
+			acc1 = vmlal_s16(acc1, vget_low_s16(x), vget_low_s16(y));
+			acc1 = vmlal_s16(acc1, vget_high_s16(x), vget_high_s16(y));
+		}
+	}
+	int32x2_t sum = vpadd_s32(vadd_s32(vget_low_s32(acc0), vget_high_s32(acc0)),
+	                          vadd_s32(vget_low_s32(acc1), vget_high_s32(acc1)));
+	out0 = vget_lane_s32(sum, 0);
+	out1 = vget_lane_s32(sum, 1);
+#else
+	int32 acc0 = 0, acc1 = 0;
+	for (int i = 0; i < n; i++) {
+		acc0 += x0[i] * c[i];
+		if (stereo)
+			acc1 += x1[i] * c[i];
+	}
+	out0 = acc0;
+	out1 = acc1;
+#endif
+}
+
+/**
+ * Audio rate converter based on band-limited interpolation with a windowed
+ * sinc filter.
+ *
+ * The output rate must be a reasonably small multiple L of the input rate
+ * divided by some M. Then every output sample lies at one of L distinct
+ * positions (phases) between two input samples, and the filter
+ * coefficients of all of them are computed up front. Every output sample
+ * then costs a single dot product of the coefficients of its phase with
+ * the most recent input samples.
+ *
+ * Unlike the converters above, this one adds a latency of half the filter
+ * length, i.e. 8 or 16 input samples. drain() returns the output for
+ * these once the input has ended.
+ */
+template<bool stereo, bool reverseStereo>
+class PolyphaseRateConverter : public RateConverter {
+protected:
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	/** number of phases, i.e. output samples per _step input samples */
+	uint _phases;
+	/** how much the phase advances per output sample */
+	uint _step;
+	/** phase of the next output sample, counts up to _phases per input sample */
+	uint _phase;
+
+	int _taps;
+	/** _phases tables of _taps coefficients each, ordered oldest sample first */
+	int16 *_coeffs;
+	byte *_coeffsAlloc;
+
+	/**
+	 * The input samples of each channel, read a block at a time. The filter
+	 * runs over the _taps samples starting at _histPos, and the samples up
+	 * to _histLen are the ones read ahead. Reading whole blocks means the
+	 * dot products don't load samples which were just stored one by one,
+	 * which stalls the loads.
+	 */
+	int16 *_history[2];
+	int _histPos;
+	int _histLen;
+
+	/** number of silent samples drain() still has to feed in to flush the history */
+	int _drainLeft;
+
+	void compactHistory();
+	void outputSample(st_sample_t *obuf, st_volume_t vol_l, st_volume_t vol_r);
+
+public:
+	PolyphaseRateConverter(uint phases, uint step, int taps, double cutoff, double beta);
+	~PolyphaseRateConverter();
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol);
+};
+
+/*
+ * Prepare processing.
+ */
+template<bool stereo, bool reverseStereo>
+PolyphaseRateConverter<stereo, reverseStereo>::PolyphaseRateConverter(uint phases, uint step, int taps, double cutoff, double beta) {
+	assert(taps % 8 == 0);
+
+	_phases = phases;
+	_step = step;
+	_taps = taps;
+
+	// Read the first input sample before producing output
+	_phase = phases;
+
+	// The SIMD code needs the coefficients to be aligned
+	_coeffsAlloc = (byte *)malloc(phases * taps * sizeof(int16) + 15);
+	_coeffs = (int16 *)(((size_t)_coeffsAlloc + 15) & ~(size_t)15);
+
+	const double center = taps / 2 - 1;
+	const double i0Beta = besselI0(beta);
+	double *h = new double[taps];
+
+	for (uint p = 0; p < phases; p++) {
+		// The output sample lies between the samples at center and center + 1
+		const double t = center + (double)p / phases;
+		double sum = 0.0;
+		for (int k = 0; k < taps; k++) {
+			const double x = k - t;
+			const double w = x / (taps / 2);
+			double v = cutoff;
+			if (x != 0.0)
+				v = sin(M_PI * cutoff * x) / (M_PI * x);
+			v *= (w > -1.0 && w < 1.0) ? besselI0(beta * sqrt(1.0 - w * w)) / i0Beta : 0.0;
+			h[k] = v;
+			sum += v;
+		}
+
+		// Normalize each phase to unity gain, and put the rounding error
+		// into the largest coefficient so it stays exact
+		int16 *c = _coeffs + p * taps;
+		int total = 0, largest = 0;
+		for (int k = 0; k < taps; k++) {
+			c[k] = (int16)floor(h[k] / sum * (1 << POLYPHASE_COEFF_BITS) + 0.5);
+			total += c[k];
+			if (ABS(c[k]) > ABS(c[largest]))
+				largest = k;
+		}
+		c[largest] += (1 << POLYPHASE_COEFF_BITS) - total;
+	}
+	delete[] h;
+
+	const int channels = stereo ? 2 : 1;
+	for (int i = 0; i < channels; i++)
+		_history[i] = (int16 *)calloc(taps + INTERMEDIATE_BUFFER_SIZE, sizeof(int16));
+	if (!stereo)
+		_history[1] = nullptr;
+	// Start with a history of silence
+	_histPos = 0;
+	_histLen = taps;
+	_drainLeft = taps / 2;
+}
+
+template<bool stereo, bool reverseStereo>
+PolyphaseRateConverter<stereo, reverseStereo>::~PolyphaseRateConverter() {
+	free(_coeffsAlloc);
+	free(_history[0]);
+	free(_history[1]);
+}
+
+/*
+ * Move the samples the filter still needs to the start of the history,
+ * to make room for the next block.
+ */
+template<bool stereo, bool reverseStereo>
+void PolyphaseRateConverter<stereo, reverseStereo>::compactHistory() {
+	const int channels = stereo ? 2 : 1;
+	for (int i = 0; i < channels; i++)
+		memmove(_history[i], _history[i] + _histPos, (_histLen - _histPos) * sizeof(int16));
+	_histLen -= _histPos;
+	_histPos = 0;
+}
+
+template<bool stereo, bool reverseStereo>
+inline void PolyphaseRateConverter<stereo, reverseStereo>::outputSample(st_sample_t *obuf, st_volume_t vol_l, st_volume_t vol_r) {
+	const int16 *coeffs = _coeffs + _phase * _taps;
+	const int32 round = 1 << (POLYPHASE_COEFF_BITS - 1);
+
+#if defined(MATH_USE_SSE2)
+	// Do the rounding, clipping, volume and mixing of both channels at once
+	// as well, which costs more than the dot products otherwise
+	const int16 *x0 = _history[0] + _histPos;
+	const int16 *x1 = stereo ? _history[1] + _histPos : x0;
+	__m128i acc0 = _mm_setzero_si128();
+	__m128i acc1 = _mm_setzero_si128();
+	for (int i = 0; i < _taps; i += 8) {
+		__m128i y = _mm_load_si128((const __m128i *)(coeffs + i));
+		acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(x0 + i)), y));
+		if (stereo)
+			acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(x1 + i)), y));
+	}
+	if (!stereo)
+		acc1 = acc0;
+
+	// Lanes 0 and 1 get the left and right sums
+	__m128i sum = _mm_add_epi32(_mm_unpacklo_epi32(acc0, acc1), _mm_unpackhi_epi32(acc0, acc1));
+	sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+	sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(round)), POLYPHASE_COEFF_BITS);
+
+	// Clip to 16 bits and repeat the left and right samples, then multiply
+	// them with their volumes, in the order of the output channels
+	__m128i samples = _mm_packs_epi32(sum, sum);
+	samples = _mm_unpacklo_epi32(samples, samples);
+	const __m128i volumes = reverseStereo ? _mm_setr_epi16(0, vol_r, vol_l, 0, 0, 0, 0, 0) :
+	                                        _mm_setr_epi16(vol_l, 0, 0, vol_r, 0, 0, 0, 0);
+	__m128i out = _mm_srai_epi32(_mm_madd_epi16(samples, volumes), 8);
+	out = _mm_packs_epi32(out, out);
+
+	// Add to the output with saturation, like clampedAdd()
+	out = _mm_adds_epi16(out, _mm_cvtsi32_si128(READ_UINT32(obuf)));
+	WRITE_UINT32(obuf, _mm_cvtsi128_si32(out));
+#else
+	int32 out0, out1;
+	dotProducts<stereo>(_history[0] + _histPos, stereo ? _history[1] + _histPos : nullptr, coeffs, _taps, out0, out1);
+	out0 = CLIP<int32>((out0 + round) >> POLYPHASE_COEFF_BITS, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+	out1 = (stereo ? CLIP<int32>((out1 + round) >> POLYPHASE_COEFF_BITS, ST_SAMPLE_MIN, ST_SAMPLE_MAX) : out0);
+
+	// output left channel
+	clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+	// output right channel
+	clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+#endif
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int PolyphaseRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+
+		// read enough input samples so that the phase lies between the
+		// two center samples of the history
+		while (_phase >= _phases) {
+			// Check if we have to read the next block
+			if (_histPos + _taps >= _histLen) {
+				compactHistory();
+				const int len = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+				if (len <= 0)
+					return (obuf - ostart) / 2;
+
+				const st_sample_t *inPtr = inBuf;
+				int16 *dst0 = _history[0] + _histLen;
+				int16 *dst1 = _history[1] + _histLen;
+				for (int i = 0; i < len; i += (stereo ? 2 : 1)) {
+					*dst0++ = *inPtr++;
+					if (stereo)
+						*dst1++ = *inPtr++;
+				}
+				_histLen += (stereo ? len / 2 : len);
+			}
+			_histPos++;
+			_phase -= _phases;
+			_drainLeft = _taps / 2;
+		}
+
+		// Loop as long as the output needs no new input sample, and as long
+		// as there is still space in the output buffer.
+		while (_phase < _phases && obuf < oend) {
+			outputSample(obuf, vol_l, vol_r);
+			obuf += 2;
+
+			// Increment output position
+			_phase += _step;
+		}
+	}
+	return (obuf - ostart) / 2;
+}
+
+/*
+ * Flush the output for the last input samples, which are still in the
+ * second half of the history, by feeding in silence.
+ * Return number of sample pairs processed, 0 once everything is flushed.
+ */
+template<bool stereo, bool reverseStereo>
+int PolyphaseRateConverter<stereo, reverseStereo>::drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+		while (_phase >= _phases) {
+			if (_histPos + _taps >= _histLen) {
+				if (_drainLeft == 0)
+					return (obuf - ostart) / 2;
+
+				// Append the silence after the samples which are still there
+				compactHistory();
+				const int channels = stereo ? 2 : 1;
+				for (int i = 0; i < channels; i++)
+					memset(_history[i] + _histLen, 0, _drainLeft * sizeof(int16));
+				_histLen += _drainLeft;
+				_drainLeft = 0;
+			}
+			_histPos++;
+			_phase -= _phases;
+		}
+
+		while (_phase < _phases && obuf < oend) {
+			outputSample(obuf, vol, vol);
+			obuf += 2;
+			_phase += _step;
+		}
+	}
+	return (obuf - ostart) / 2;
+}
+
+
+#pragma mark -
+
+
 /**
  * Simple audio rate converter for the case that the inrate equals the outrate.
  */
@@ -341,8 +689,39 @@ public:
 #pragma mark -
 
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makePolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
+	const st_rate_t divisor = Common::gcd(inrate, outrate);
+	const uint phases = outrate / divisor;
+	const uint step = inrate / divisor;
+
+	// When downsampling, the filter has to be longer to cut off at the lower
+	// output rate. Round the length up to what the dot product handles.
+	int taps = (quality == kRateConverterQualityHigh) ? 32 : 16;
+	if (step > phases)
+		taps = (taps * step / phases + 7) & ~7;
+
+	if (phases > POLYPHASE_MAX_PHASES || taps > POLYPHASE_MAX_TAPS)
+		return nullptr;
+
+	// Cut off a bit below the lower of both Nyquist frequencies, so the
+	// transition band of the short filter stays below it
+	double cutoff = (quality == kRateConverterQualityHigh) ? 0.9 : 0.8;
+	if (step > phases)
+		cutoff = cutoff * phases / step;
+
+	const double beta = (quality == kRateConverterQualityHigh) ? 9.0 : 7.0;
+	return new PolyphaseRateConverter<stereo, reverseStereo>(phases, step, taps, cutoff, beta);
+}
+
+template<bool stereo, bool reverseStereo>
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
 	if (inrate != outrate) {
+		if (quality != kRateConverterQualityLow) {
+			RateConverter *converter = makePolyphaseRateConverter<stereo, reverseStereo>(inrate, outrate, quality);
+			if (converter)
+				return converter;
+		}
+
 		if ((inrate % outrate) == 0 && (inrate < 65536)) {
 			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
 		} else {
@@ -356,14 +735,14 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, quality);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, quality);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, quality);
 }
 
 } // End of namespace Audio
@@ -78,7 +78,30 @@ public:
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * How much effort a RateConverter puts into the conversion.
+ */
+enum RateConverterQuality {
+	/** Drop or duplicate samples, or interpolate linearly between them. */
+	kRateConverterQualityLow,
+	/** Band-limited interpolation with a 16 tap windowed sinc filter. */
+	kRateConverterQualityMedium,
+	/** Band-limited interpolation with a 32 tap windowed sinc filter. */
+	kRateConverterQualityHigh
+};
+
+/**
+ * Create a RateConverter for the specified input and output rates.
+ *
+ * The band-limited converters of the higher quality levels are only used
+ * for rates with a reasonably simple ratio, such as 22050 to 44100 or
+ * 48000 Hz. Other conversions fall back to the low quality converters.
+ *
+ * The band-limited converters delay the output by half their filter length.
+ * Use drain() to get the end of it once the input has ended.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false,
+                                 RateConverterQuality quality = kRateConverterQualityLow);
 
 } // End of namespace Audio
 
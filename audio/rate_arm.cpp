@@ -446,8 +446,9 @@ public:
 
 /**
  * Create and return a RateConverter object for the specified input and output rates.
+ * The assembler converters have a single quality level.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
 	if (inrate != outrate) {
 		if ((inrate % outrate) == 0 && (inrate < 65536)) {
 			if (stereo) {
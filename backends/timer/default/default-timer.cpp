@@ -34,50 +34,111 @@ struct TimerSlot {
 	uint32 nextFireTime;	// in milliseconds
 	uint32 nextFireTimeMicro;	// microseconds part of nextFire
 
+	TimerSlot *prev;
 	TimerSlot *next;
 
-	TimerSlot() : callback(nullptr), refCon(nullptr), interval(0), nextFireTime(0), nextFireTimeMicro(0), next(nullptr) {}
+	// Statistics, in milliseconds
+	uint32 calls;
+	uint32 totalTime;
+	uint32 maxTime;
+	uint32 maxDelay;
+
+	TimerSlot() : callback(nullptr), refCon(nullptr), interval(0), nextFireTime(0), nextFireTimeMicro(0), prev(this), next(this),
+		calls(0), totalTime(0), maxTime(0), maxDelay(0) {}
 };
 
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
-
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = 0;
-
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
-	while (true) {
-		assert(slot);
-		if (slot->next == 0 || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
-		}
-		slot = slot->next;
-	}
+// The lists of the wheel are circular, their anchor is a fake TimerSlot;
+// this common trick allows us to get rid of many special cases.
+
+static void appendSlot(TimerSlot *list, TimerSlot *slot) {
+	slot->prev = list->prev;
+	slot->next = list;
+	list->prev->next = slot;
+	list->prev = slot;
+}
+
+static void unlinkSlot(TimerSlot *slot) {
+	slot->prev->next = slot->next;
+	slot->next->prev = slot->prev;
+	slot->prev = slot->next = slot;
 }
 
 
 DefaultTimerManager::DefaultTimerManager() :
-	_timerCallbackNext(0),
-	_head(0) {
+	_wheel(nullptr),
+	_wheelTime(0),
+	_currentSlot(nullptr),
+	_timerCallbackNext(0) {
 
-	_head = new TimerSlot();
+	_wheel = new TimerSlot[kWheelSize];
 }
 
 DefaultTimerManager::~DefaultTimerManager() {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
+	for (uint i = 0; i < _slots.size(); ++i)
+		delete _slots[i];
+	_slots.clear();
+
+	Common::StackLock pendingLock(_pendingMutex);
+	for (uint i = 0; i < _pending.size(); ++i)
+		delete _pending[i];
+	_pending.clear();
+
+	delete[] _wheel;
+	_wheel = nullptr;
+}
+
+/**
+ * Put the timer into the list of the wheel where it is due.
+ *
+ * Timers due within the next 256 ms go into the first level, which has a
+ * list for every millisecond. Later ones go into the lists of the second
+ * and third level, which cover 256 ms and 16 s each. Whenever the first
+ * level wraps around, the next list of the second level is cascaded, i.e.
+ * its timers are moved down into the first level, and likewise for the
+ * third level and the overflow list, which holds everything due after
+ * about 17 minutes.
+ */
+void DefaultTimerManager::scheduleSlot(TimerSlot *slot) {
+	uint32 fireTime = slot->nextFireTime;
+	int32 delta = (int32)(fireTime - _wheelTime);
+	if (delta < 0) {
+		// Overdue timers fire as soon as possible
+		fireTime = _wheelTime;
+		delta = 0;
+	}
+
+	uint index;
+	if (delta < (1 << kWheelBits))
+		index = fireTime & ((1 << kWheelBits) - 1);
+	else if (delta < (1 << (kWheelBits + kLevelBits)))
+		index = kLevel1 + ((fireTime >> kWheelBits) & ((1 << kLevelBits) - 1));
+	else if (delta < (1 << (kWheelBits + 2 * kLevelBits)))
+		index = kLevel2 + ((fireTime >> (kWheelBits + kLevelBits)) & ((1 << kLevelBits) - 1));
+	else
+		index = kOverflow;
+
+	appendSlot(&_wheel[index], slot);
+}
+
+void DefaultTimerManager::cascade(uint index) {
+	// Take the whole list first, some of the timers may go back into it
+	TimerSlot list;
+	TimerSlot *anchor = &_wheel[index];
+	if (anchor->next == anchor)
+		return;
+	list.next = anchor->next;
+	list.prev = anchor->prev;
+	list.next->prev = &list;
+	list.prev->next = &list;
+	anchor->next = anchor->prev = anchor;
+
+	while (list.next != &list) {
+		TimerSlot *slot = list.next;
+		unlinkSlot(slot);
+		scheduleSlot(slot);
 	}
-	_head = 0;
 }
 
 void DefaultTimerManager::handler() {
@@ -86,32 +147,79 @@ void DefaultTimerManager::handler() {
 	uint32 curTime = g_system->getMillis(true);
 
 	// On slow systems this could still be run after destructor
-	if (!_head)
+	if (!_wheel)
 		return;
 
-	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
-
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
-		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
+	// Schedule the timers which were installed since the last run
+	Common::Array<TimerSlot *> pending;
+	{
+		Common::StackLock pendingLock(_pendingMutex);
+		SWAP(pending, _pending);
+	}
+	if (_slots.empty()) {
+		// Nothing to catch up on, start the wheel at the earliest timer
+		_wheelTime = curTime;
+		for (uint i = 0; i < pending.size(); ++i) {
+			if ((int32)(pending[i]->nextFireTime - _wheelTime) < 0)
+				_wheelTime = pending[i]->nextFireTime;
+		}
+	}
+	for (uint i = 0; i < pending.size(); ++i) {
+		_slots.push_back(pending[i]);
+		scheduleSlot(pending[i]);
+	}
+
+	// Handle every millisecond before the current one, and fire the timers
+	// that were due then.
+	while ((int32)(curTime - _wheelTime) > 0) {
+		const uint32 tick = _wheelTime;
+		if ((tick & ((1 << kWheelBits) - 1)) == 0) {
+			const uint index1 = (tick >> kWheelBits) & ((1 << kLevelBits) - 1);
+			if (index1 == 0) {
+				const uint index2 = (tick >> (kWheelBits + kLevelBits)) & ((1 << kLevelBits) - 1);
+				if (index2 == 0)
+					cascade(kOverflow);
+				cascade(kLevel2 + index2);
+			}
+			cascade(kLevel1 + index1);
 		}
-		insertPrioQueue(_head, slot);
 
-		// Invoke the timer callback
-		assert(slot->callback);
-		slot->callback(slot->refCon);
+		TimerSlot *list = &_wheel[tick & ((1 << kWheelBits) - 1)];
+		while (list->next != list) {
+			TimerSlot *slot = list->next;
+			unlinkSlot(slot);
+
+			const uint32 delay = curTime - slot->nextFireTime;
+
+			// Update the fire time and reschedule the TimerSlot. If it is
+			// still due, it gets back into this list and fires again.
+			assert(slot->interval > 0);
+			slot->nextFireTime += (slot->interval / 1000);
+			slot->nextFireTimeMicro += (slot->interval % 1000);
+			if (slot->nextFireTimeMicro > 1000) {
+				slot->nextFireTime += slot->nextFireTimeMicro / 1000;
+				slot->nextFireTimeMicro %= 1000;
+			}
+			scheduleSlot(slot);
+
+			// Invoke the timer callback
+			assert(slot->callback);
+			_currentSlot = slot;
+			const uint32 startTime = g_system->getMillis(true);
+			slot->callback(slot->refCon);
+			const uint32 time = g_system->getMillis(true) - startTime;
+
+			// The callback may have removed its own timer
+			if (_currentSlot == slot) {
+				slot->calls++;
+				slot->totalTime += time;
+				slot->maxTime = MAX(slot->maxTime, time);
+				slot->maxDelay = MAX(slot->maxDelay, delay);
+			}
+			_currentSlot = nullptr;
+		}
 
-		// Look at the next scheduled timer
-		slot = _head->next;
+		_wheelTime++;
 	}
 }
 
@@ -127,7 +235,7 @@ void DefaultTimerManager::checkTimers(uint32 interval) {
 
 bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, void *refCon, const Common::String &id) {
 	assert(interval > 0);
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_pendingMutex);
 
 	if (_callbacks.contains(id)) {
 		if (_callbacks[id] != callback) {
@@ -150,9 +258,9 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 	slot->interval = interval;
 	slot->nextFireTime = g_system->getMillis() + interval / 1000;
 	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = 0;
 
-	insertPrioQueue(_head, slot);
+	// The next run of the handler schedules it
+	_pending.push_back(slot);
 
 	return true;
 }
@@ -160,15 +268,27 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
+	for (uint i = 0; i < _slots.size(); ) {
+		TimerSlot *slot = _slots[i];
+		if (slot->callback == callback) {
+			unlinkSlot(slot);
+			if (_currentSlot == slot)
+				_currentSlot = nullptr;
+			delete slot;
+			_slots.remove_at(i);
+		} else {
+			++i;
+		}
+	}
+
+	Common::StackLock pendingLock(_pendingMutex);
 
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
+	for (uint i = 0; i < _pending.size(); ) {
+		if (_pending[i]->callback == callback) {
+			delete _pending[i];
+			_pending.remove_at(i);
 		} else {
-			slot = slot->next;
+			++i;
 		}
 	}
 
@@ -189,3 +309,20 @@ void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 			_callbacks.erase(i);
 	}
 }
+
+void DefaultTimerManager::getTimerStats(Common::Array<TimerStats> &stats) {
+	Common::StackLock lock(_mutex);
+
+	stats.clear();
+	for (uint i = 0; i < _slots.size(); ++i) {
+		const TimerSlot *slot = _slots[i];
+		TimerStats timerStats;
+		timerStats.id = slot->id;
+		timerStats.interval = slot->interval;
+		timerStats.calls = slot->calls;
+		timerStats.totalTime = slot->totalTime;
+		timerStats.maxTime = slot->maxTime;
+		timerStats.maxDelay = slot->maxDelay;
+		stats.push_back(timerStats);
+	}
+}
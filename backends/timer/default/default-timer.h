@@ -23,6 +23,7 @@
 #ifndef BACKENDS_TIMER_DEFAULT_H
 #define BACKENDS_TIMER_DEFAULT_H
 
+#include "common/array.h"
 #include "common/str.h"
 #include "common/hash-str.h"
 #include "common/timer.h"
@@ -30,21 +31,50 @@
 
 struct TimerSlot;
 
+/**
+ * Timer manager that keeps the timers in a hierarchical timer wheel with a
+ * resolution of one millisecond, so both scheduling a timer and finding the
+ * ones that are due take constant time.
+ */
 class DefaultTimerManager : public Common::TimerManager {
 private:
 	typedef Common::HashMap<Common::String, TimerProc, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> TimerSlotMap;
 
+	enum {
+		kWheelBits = 8,      ///< The first level has one list per millisecond
+		kLevelBits = 6,      ///< Each further level covers 64 times as long
+		kLevel1 = 1 << kWheelBits,
+		kLevel2 = kLevel1 + (1 << kLevelBits),
+		kOverflow = kLevel2 + (1 << kLevelBits),
+		kWheelSize = kOverflow + 1
+	};
+
+	/** Held while the wheel is changed or the callbacks run. */
 	Common::Mutex _mutex;
-	TimerSlot *_head;
+	/**
+	 * Only guards the timers which were installed but not scheduled yet, so
+	 * installing never waits for callbacks to finish.
+	 */
+	Common::Mutex _pendingMutex;
+	Common::Array<TimerSlot *> _pending;
 	TimerSlotMap _callbacks;
 
+	TimerSlot *_wheel;             ///< Anchors of the lists of timers, see scheduleSlot()
+	Common::Array<TimerSlot *> _slots;
+	uint32 _wheelTime;             ///< The next millisecond to be handled
+	TimerSlot *_currentSlot;       ///< The timer whose callback is running
+
 	uint32 _timerCallbackNext;
 
+	void scheduleSlot(TimerSlot *slot);
+	void cascade(uint index);
+
 public:
 	DefaultTimerManager();
 	virtual ~DefaultTimerManager();
 	virtual bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id);
 	virtual void removeTimerProc(TimerProc proc);
+	virtual void getTimerStats(Common::Array<TimerStats> &stats);
 
 	/**
 	 * Timer callback, to be invoked at regular time intervals by the backend.
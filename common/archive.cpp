@@ -22,6 +22,7 @@
 
 #include "common/archive.h"
 #include "common/fs.h"
+#include "common/mutex.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
@@ -92,10 +93,15 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	invalidateMemberIndex();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
 	if (find(name) == _list.end()) {
+		SearchSet *nested = dynamic_cast<SearchSet *>(archive);
+		if (nested)
+			nested->_parent = this;
+
 		Node node(priority, name, archive, autoFree);
 		insert(node);
 	} else {
@@ -170,9 +176,11 @@ void SearchSet::addSubDirectoriesMatching(const FSNode &directory, String origPa
 void SearchSet::remove(const String &name) {
 	ArchiveNodeList::iterator it = find(name);
 	if (it != _list.end()) {
+		detach(*it);
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		invalidateMemberIndex();
 	}
 }
 
@@ -182,11 +190,13 @@ bool SearchSet::hasArchive(const String &name) const {
 
 void SearchSet::clear() {
 	for (ArchiveNodeList::iterator i = _list.begin(); i != _list.end(); ++i) {
+		detach(*i);
 		if (i->_autoFree)
 			delete i->_arc;
 	}
 
 	_list.clear();
+	invalidateMemberIndex();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -205,10 +215,80 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
+SearchSet::~SearchSet() {
+	clear();
+	delete _memberIndexMutex;
+}
+
+void SearchSet::setMemberIndexEnabled(bool enabled) {
+	// Created here rather than on first lookup, so that only the main thread
+	// ever creates it
+	if (enabled && !_memberIndexMutex)
+		_memberIndexMutex = new Mutex();
+
+	if (_memberIndexMutex) {
+		StackLock lock(*_memberIndexMutex);
+		_memberIndex.clear(true);
+	}
+
+	_memberIndexEnabled = enabled;
+	invalidateMemberIndex();
+}
+
+void SearchSet::invalidateMemberIndex() {
+	// The sets containing this one may have indexed our members too
+	for (SearchSet *set = this; set; set = set->_parent)
+		set->_changeCount++;
+}
+
+void SearchSet::detach(const Node &node) {
+	SearchSet *nested = dynamic_cast<SearchSet *>(node._arc);
+	if (nested && nested->_parent == this)
+		nested->_parent = nullptr;
+}
+
+Archive *SearchSet::findArchiveForMember(const String &name) const {
+	uint32 changeCount;
+
+	{
+		StackLock lock(*_memberIndexMutex);
+
+		changeCount = _changeCount;
+		if (changeCount != _indexedChangeCount) {
+			_memberIndex.clear(true);
+			_indexedChangeCount = changeCount;
+		}
+
+		MemberIndex::const_iterator i = _memberIndex.find(name);
+		if (i != _memberIndex.end())
+			return i->_value;
+	}
+
+	// Asking the archives can take a while, so other threads may use the
+	// index in the meantime. If two look up the same name they both store
+	// the same result.
+	Archive *archive = nullptr;
+	ArchiveNodeList::const_iterator it = _list.begin();
+	for (; it != _list.end(); ++it) {
+		if (it->_arc->hasFile(name)) {
+			archive = it->_arc;
+			break;
+		}
+	}
+
+	StackLock lock(*_memberIndexMutex);
+	if (_indexedChangeCount == changeCount)
+		_memberIndex[name] = archive;
+	return archive;
+}
+
 bool SearchSet::hasFile(const String &name) const {
 	if (name.empty())
 		return false;
 
+	if (_memberIndexEnabled)
+		return findArchiveForMember(name) != nullptr;
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
 		if (it->_arc->hasFile(name))
@@ -221,6 +301,13 @@ bool SearchSet::hasFile(const String &name) const {
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
 	int matches = 0;
 
+	// A pattern without wildcards can only match a single name, which we
+	// may already know to be absent from every archive.
+	if (_memberIndexEnabled && !pattern.contains('*') && !pattern.contains('?') && !pattern.contains('#')) {
+		if (!findArchiveForMember(pattern))
+			return 0;
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it)
 		matches += it->_arc->listMatchingMembers(list, pattern);
@@ -242,6 +329,11 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
+	if (_memberIndexEnabled) {
+		Archive *archive = findArchiveForMember(name);
+		return archive ? archive->getMember(name) : ArchiveMemberPtr();
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
 		if (it->_arc->hasFile(name))
@@ -255,6 +347,17 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return nullptr;
 
+	if (_memberIndexEnabled) {
+		Archive *archive = findArchiveForMember(name);
+		if (!archive)
+			return nullptr;
+
+		SeekableReadStream *stream = archive->createReadStreamForMember(name);
+		if (stream)
+			return stream;
+		// Fall back to trying every archive, as we would without the index
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
 		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
@@ -25,6 +25,8 @@
 
 #include "common/str.h"
 #include "common/list.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
 
@@ -133,6 +135,8 @@ public:
  * match. SearchSet *DOES* guarantee that searches are performed in *DESCENDING*
  * priority order. In case of conflicting priorities, insertion order prevails.
  */
+class Mutex;
+
 class SearchSet : public Archive {
 	struct Node {
 		int		_priority;
@@ -154,9 +158,30 @@ class SearchSet : public Archive {
 
 	bool _ignoreClashes;
 
+	// Caseless index from member name to the first archive containing it,
+	// or to nullptr if no archive does. Filled lazily by lookups, which may
+	// come from other threads than the main one, so it is guarded by a mutex.
+	typedef HashMap<String, Archive *, IgnoreCase_Hash, IgnoreCase_EqualTo> MemberIndex;
+	mutable MemberIndex _memberIndex;
+	bool _memberIndexEnabled;
+	Mutex *_memberIndexMutex;
+
+	// Bumped whenever the archives of the set, or of a set nested in it,
+	// change. The index is reset when it differs from the count the index
+	// was filled with.
+	uint32 _changeCount;
+	mutable uint32 _indexedChangeCount;
+
+	// The set this one was added to, which is told about our changes
+	SearchSet *_parent;
+
+	Archive *findArchiveForMember(const String &name) const;
+	void invalidateMemberIndex();
+	void detach(const Node &node);
+
 public:
-	SearchSet() : _ignoreClashes(false) { }
-	virtual ~SearchSet() { clear(); }
+	SearchSet() : _ignoreClashes(false), _memberIndexEnabled(false), _memberIndexMutex(nullptr), _changeCount(0), _indexedChangeCount(0), _parent(nullptr) { }
+	virtual ~SearchSet();
 
 	/**
 	 * Add a new archive to the searchable set.
@@ -256,6 +281,21 @@ public:
 	 * in FSDirectory documentation
 	 */
 	void setIgnoreClashes(bool ignoreClashes) { _ignoreClashes = ignoreClashes; }
+
+	/**
+	 * Enable or disable the member index. When enabled, the archive serving a
+	 * given name (or the fact that none does) is remembered, so that repeated
+	 * lookups of the same name, including misses, no longer query every archive.
+	 * Names are matched case-insensitively. The index is reset whenever archives
+	 * are added, removed or reordered, in this set or in a SearchSet nested in
+	 * it, so it is only suited to sets whose other archives do not change their
+	 * contents behind the SearchSet's back.
+	 *
+	 * Lookups may be made from any thread, but the index must be enabled or
+	 * disabled, and archives added or removed, from the main thread while no
+	 * other thread uses the set.
+	 */
+	void setMemberIndexEnabled(bool enabled);
 };
 
 
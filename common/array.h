@@ -84,6 +84,18 @@ public:
 		}
 	}
 
+#if __cplusplus >= 201103L
+	/**
+	 * Construct an array by taking over the storage of another one,
+	 * which is left empty. No elements are copied.
+	 */
+	Array(Array<T> &&old) : _capacity(old._capacity), _size(old._size), _storage(old._storage) {
+		old._storage = nullptr;
+		old._capacity = 0;
+		old._size = 0;
+	}
+#endif
+
 	/**
 	 * Construct an array by copying data from a regular array.
 	 */
@@ -108,6 +120,32 @@ public:
 			insert_aux(end(), &element, &element + 1);
 	}
 
+#if __cplusplus >= 201103L
+	/** Appends element to the end of the array, moving it into place. */
+	void push_back(T &&element) {
+		emplace_back(Common::move(element));
+	}
+
+	/** Constructs a new element in place at the end of the array from the given arguments. */
+	template<class... TArgs>
+	void emplace_back(TArgs &&...args) {
+		if (_size + 1 <= _capacity) {
+			new ((void *)&_storage[_size++]) T(Common::forward<TArgs>(args)...);
+		} else {
+			T *const oldStorage = _storage;
+			allocCapacity(roundUpCapacity(_size + 1));
+
+			// The arguments may refer to elements of the old storage,
+			// so construct the new element before moving those
+			new ((void *)&_storage[_size]) T(Common::forward<TArgs>(args)...);
+			uninitialized_move(oldStorage, oldStorage + _size, _storage);
+
+			freeStorage(oldStorage, _size);
+			_size++;
+		}
+	}
+#endif
+
 	void push_back(const Array<T> &array) {
 		if (_size + array.size() <= _capacity) {
 			uninitialized_copy(array.begin(), array.end(), end());
@@ -210,6 +248,24 @@ public:
 		return *this;
 	}
 
+#if __cplusplus >= 201103L
+	Array<T> &operator=(Array<T> &&old) {
+		if (this == &old)
+			return *this;
+
+		freeStorage(_storage, _size);
+		_capacity = old._capacity;
+		_size = old._size;
+		_storage = old._storage;
+
+		old._storage = nullptr;
+		old._capacity = 0;
+		old._size = 0;
+
+		return *this;
+	}
+#endif
+
 	size_type size() const {
 		return _size;
 	}
@@ -273,8 +329,8 @@ public:
 		allocCapacity(newCapacity);
 
 		if (oldStorage) {
-			// Copy old data
-			uninitialized_copy(oldStorage, oldStorage + _size, _storage);
+			// Move old data
+			uninitialized_move(oldStorage, oldStorage + _size, _storage);
 			freeStorage(oldStorage, _size);
 		}
 	}
@@ -347,14 +403,15 @@ protected:
 				// storage to avoid conflicts.
 				allocCapacity(roundUpCapacity(_size + n));
 
-				// Copy the data from the old storage till the position where
-				// we insert new data
-				uninitialized_copy(oldStorage, oldStorage + idx, _storage);
-				// Copy the data we insert
+				// Copy the data we insert first, as it may come from the
+				// old storage
 				uninitialized_copy(first, last, _storage + idx);
-				// Afterwards copy the old data from the position where we
+				// Move the data from the old storage till the position where
+				// we insert new data
+				uninitialized_move(oldStorage, oldStorage + idx, _storage);
+				// Afterwards move the old data from the position where we
 				// insert.
-				uninitialized_copy(oldStorage + idx, oldStorage + _size, _storage + idx + n);
+				uninitialized_move(oldStorage + idx, oldStorage + _size, _storage + idx + n);
 
 				freeStorage(oldStorage, _size);
 			} else if (idx + n <= _size) {
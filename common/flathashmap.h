@@ -0,0 +1,479 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/scummsys.h"
+#include "common/func.h"
+#include "common/textconsole.h" // For error()
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> maps objects of type Key to objects of type Val,
+ * like HashMap, but keeps the keys and values inline in one array.
+ *
+ * Lookups use linear probing over a separate array of control bytes, which
+ * also hold a few bits of the hash of each key, so most mismatching slots
+ * are rejected without touching the key at all. Compared to HashMap this
+ * avoids one pointer indirection per probe and lets iteration walk
+ * memory sequentially.
+ *
+ * The common parts of the HashMap interface are supported with the same
+ * semantics: find(), contains(), operator[], getVal(), setVal(), erase()
+ * and iteration. Erasing an entry leaves a marker behind, so erasing
+ * while iterating works just like it does with HashMap.
+ *
+ * Unlike HashMap, adding an entry may move the existing entries, so
+ * references and iterators to entries are invalidated by any insertion.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+	};
+
+private:
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage may fill up (including erased entries)
+		// before being rebuilt.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 3,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 4
+	};
+
+	enum {
+		kCtrlEmpty = 0,
+		kCtrlDeleted = 1,
+		kCtrlUsed = 0x80 ///< Ored with the low 7 bits of the hash
+	};
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	Node *_storage;   ///< Uninitialized unless the matching control byte is used
+	byte *_ctrl;      ///< State of every slot of _storage
+	size_type _mask;  ///< Capacity minus one; capacity is a power of two
+	size_type _shift; ///< 32 minus log2 of the capacity
+	size_type _size;
+	size_type _deleted;
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	static byte ctrlForHash(size_type hash) {
+		return kCtrlUsed | (hash & 0x7F);
+	}
+
+	/** Spread the hash over the whole table, some hash functions only vary in their low bits. */
+	size_type slotForHash(size_type hash) const {
+		return (size_type)(hash * 2654435769U) >> _shift;
+	}
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void rebuildStorage(size_type newCapacity);
+
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->_ctrl[_idx] & kCtrlUsed);
+			return &_hashmap->_storage[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			_idx = _hashmap->nextUsed(_idx + 1);
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+	/** Returns the first used slot at or after idx, or (size_type)-1. */
+	size_type nextUsed(size_type idx) const {
+		for (; idx <= _mask; ++idx) {
+			if (_ctrl[idx] & kCtrlUsed)
+				return idx;
+		}
+		return (size_type)-1;
+	}
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		clear();
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+	bool empty() const { return (_size == 0); }
+
+	iterator begin() { return iterator(nextUsed(0), this); }
+	iterator end() { return iterator((size_type)-1, this); }
+	const_iterator begin() const { return const_iterator(nextUsed(0), this); }
+	const_iterator end() const { return const_iterator((size_type)-1, this); }
+
+	iterator find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (ctr != (size_type)-1)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (ctr != (size_type)-1)
+			return const_iterator(ctr, this);
+		return end();
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(FLATHASHMAP_MIN_CAPACITY);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	clear();
+	freeStorage();
+}
+
+/**
+ * Allocate empty storage for the given number of slots.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity >= FLATHASHMAP_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
+
+	_storage = (Node *)malloc(sizeof(Node) * capacity);
+	_ctrl = (byte *)malloc(capacity);
+	if (!_storage || !_ctrl)
+		::error("Common::FlatHashMap: failure to allocate %u bytes", capacity * (uint)(sizeof(Node) + 1));
+	memset(_ctrl, kCtrlEmpty, capacity);
+
+	_mask = capacity - 1;
+	_shift = 32;
+	for (size_type c = capacity; c > 1; c >>= 1)
+		_shift--;
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	free(_storage);
+	free(_ctrl);
+	_storage = nullptr;
+	_ctrl = nullptr;
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one. The layout is copied as is, erased entries included.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocStorage(map._mask + 1);
+
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] & kCtrlUsed)
+			new ((void *)&_storage[ctr]) Node(map._storage[ctr]);
+	}
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] & kCtrlUsed)
+			_storage[ctr].~Node();
+	}
+
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+	} else {
+		memset(_ctrl, kCtrlEmpty, _mask + 1);
+		_size = 0;
+		_deleted = 0;
+	}
+}
+
+/**
+ * Move all the entries into new storage of the given capacity, dropping
+ * the markers left behind by erased entries on the way.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rebuildStorage(size_type newCapacity) {
+	Node *oldStorage = _storage;
+	byte *oldCtrl = _ctrl;
+	const size_type oldMask = _mask;
+#ifndef NDEBUG
+	const size_type oldSize = _size;
+#endif
+
+	allocStorage(newCapacity);
+
+	for (size_type ctr = 0; ctr <= oldMask; ++ctr) {
+		if (!(oldCtrl[ctr] & kCtrlUsed))
+			continue;
+
+		// No key exists twice and there are no erased entries yet,
+		// so the first empty slot is the right one
+		const size_type hash = _hash(oldStorage[ctr]._key);
+		size_type idx = slotForHash(hash);
+		while (_ctrl[idx] != kCtrlEmpty)
+			idx = (idx + 1) & _mask;
+
+		new ((void *)&_storage[idx]) Node(oldStorage[ctr]);
+		_ctrl[idx] = ctrlForHash(hash);
+		_size++;
+
+		oldStorage[ctr].~Node();
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	assert(_size == oldSize);
+
+	free(oldStorage);
+	free(oldCtrl);
+}
+
+/**
+ * Returns the slot holding the key, or (size_type)-1 if it is not in the map.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const size_type hash = _hash(key);
+	const byte ctrl = ctrlForHash(hash);
+	size_type ctr = slotForHash(hash);
+
+	// The load factor guarantees there is always an empty slot to stop at
+	while (_ctrl[ctr] != kCtrlEmpty) {
+		if (_ctrl[ctr] == ctrl && _equal(_storage[ctr]._key, key))
+			return ctr;
+
+		ctr = (ctr + 1) & _mask;
+	}
+
+	return (size_type)-1;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const size_type hash = _hash(key);
+	const byte ctrl = ctrlForHash(hash);
+	size_type ctr = slotForHash(hash);
+	const size_type NONE_FOUND = _mask + 1;
+	size_type firstFree = NONE_FOUND;
+
+	while (_ctrl[ctr] != kCtrlEmpty) {
+		if (_ctrl[ctr] == kCtrlDeleted) {
+			if (firstFree == NONE_FOUND)
+				firstFree = ctr;
+		} else if (_ctrl[ctr] == ctrl && _equal(_storage[ctr]._key, key)) {
+			return ctr;
+		}
+
+		ctr = (ctr + 1) & _mask;
+	}
+
+	// Reuse the slot of an erased entry if we went past one
+	if (firstFree != NONE_FOUND) {
+		ctr = firstFree;
+		_deleted--;
+	}
+
+	new ((void *)&_storage[ctr]) Node(key);
+	_ctrl[ctr] = ctrl;
+	_size++;
+
+	// Keep the load factor below a certain threshold.
+	// Erased entries are also counted
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted) * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		// Only grow if the live entries need it, otherwise just clear out the erased ones
+		if (_size * 2 * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR)
+			capacity = capacity < 512 ? (capacity * 4) : (capacity * 2);
+		rebuildStorage(capacity);
+		ctr = lookup(key);
+		assert(ctr != (size_type)-1);
+	}
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) != (size_type)-1;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _storage[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr != (size_type)-1)
+		return _storage[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_storage[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const size_type ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(_ctrl[ctr] & kCtrlUsed);
+
+	// If we remove a key, we leave a marker behind so that lookups of the
+	// entries after it still work
+	_storage[ctr].~Node();
+	_ctrl[ctr] = kCtrlDeleted;
+	_size--;
+	_deleted++;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr == (size_type)-1)
+		return;
+
+	erase(iterator(ctr, this));
+}
+
+} // End of namespace Common
+
+#endif
@@ -44,6 +44,7 @@
 
 
 #include "common/func.h"
+#include "common/type-traits.h"
 
 #ifdef DEBUG_HASH_COLLISIONS
 #include "common/debug.h"
@@ -92,6 +93,9 @@ private:
 		const Key _key;
 		explicit Node(const Key &key) : _key(key), _value() {}
 		Node() : _key(), _value() {}
+#if __cplusplus >= 201103L
+		Node(Key &&key, Val &&value) : _value(Common::move(value)), _key(Common::move(key)) {}
+#endif
 	};
 
 	enum {
@@ -149,6 +153,9 @@ private:
 	}
 
 	void assign(const HM_t &map);
+#if __cplusplus >= 201103L
+	void takeNodes(HM_t &map);
+#endif
 	size_type lookup(const Key &key) const;
 	size_type lookupAndCreateIfMissing(const Key &key);
 	void expandStorage(size_type newCapacity);
@@ -221,6 +228,9 @@ public:
 
 	HashMap();
 	HashMap(const HM_t &map);
+#if __cplusplus >= 201103L
+	HashMap(HM_t &&map);
+#endif
 	~HashMap();
 
 	HM_t &operator=(const HM_t &map) {
@@ -235,6 +245,18 @@ public:
 		return *this;
 	}
 
+#if __cplusplus >= 201103L
+	HM_t &operator=(HM_t &&map) {
+		if (this == &map)
+			return *this;
+
+		clear();
+		delete[] _storage;
+		takeNodes(map);
+		return *this;
+	}
+#endif
+
 	bool contains(const Key &key) const;
 
 	Val &operator[](const Key &key);
@@ -244,6 +266,9 @@ public:
 	const Val &getVal(const Key &key) const;
 	const Val &getVal(const Key &key, const Val &defaultVal) const;
 	void setVal(const Key &key, const Val &val);
+#if __cplusplus >= 201103L
+	void setVal(const Key &key, Val &&val);
+#endif
 
 	void clear(bool shrinkArray = 0);
 
@@ -336,6 +361,23 @@ HashMap<Key, Val, HashFunc, EqualFunc>::HashMap(const HM_t &map) :
 	assign(map);
 }
 
+#if __cplusplus >= 201103L
+/**
+ * Move constructor, takes over the table of the given hashmap and
+ * moves its keys and values, leaving it empty.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+HashMap<Key, Val, HashFunc, EqualFunc>::HashMap(HM_t &&map) :
+	_defaultVal() {
+#ifdef DEBUG_HASH_COLLISIONS
+	_collisions = 0;
+	_lookups = 0;
+	_dummyHits = 0;
+#endif
+	takeNodes(map);
+}
+#endif
+
 /**
  * Destructor, frees all used memory.
  */
@@ -383,6 +425,47 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
 	assert(_deleted == map._deleted);
 }
 
+#if __cplusplus >= 201103L
+/**
+ * Internal method for moving the content of another HashMap to this one.
+ * The table itself is taken over, but as the nodes belong to the memory
+ * pool of the other map, they are recreated here with their keys and
+ * values moved over. The other map is left empty.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void HashMap<Key, Val, HashFunc, EqualFunc>::takeNodes(HM_t &map) {
+	_mask = map._mask;
+	_storage = map._storage;
+	_size = map._size;
+	_deleted = map._deleted;
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		Node *node = _storage[ctr];
+		if (node == nullptr || node == HASHMAP_DUMMY_NODE)
+			continue;
+
+		// The old node is freed right away, so its key may be moved from
+#ifdef USE_HASHMAP_MEMORY_POOL
+		_storage[ctr] = new (_nodePool) Node(Common::move(const_cast<Key &>(node->_key)), Common::move(node->_value));
+		map._nodePool.deleteChunk(node);
+#else
+		_storage[ctr] = new Node(Common::move(const_cast<Key &>(node->_key)), Common::move(node->_value));
+		delete node;
+#endif
+	}
+
+	// Leave the other map empty, with a fresh table
+	map._mask = HASHMAP_MIN_CAPACITY - 1;
+	map._storage = new Node *[HASHMAP_MIN_CAPACITY];
+	assert(map._storage != nullptr);
+	memset(map._storage, 0, HASHMAP_MIN_CAPACITY * sizeof(Node *));
+	map._size = 0;
+	map._deleted = 0;
+}
+#endif
 
 template<class Key, class Val, class HashFunc, class EqualFunc>
 void HashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
@@ -590,6 +673,15 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &v
 	_storage[ctr]->_value = val;
 }
 
+#if __cplusplus >= 201103L
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void HashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, Val &&val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	assert(_storage[ctr] != nullptr);
+	_storage[ctr]->_value = Common::move(val);
+}
+#endif
+
 template<class Key, class Val, class HashFunc, class EqualFunc>
 void HashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
 	// Check whether we have a valid iterator
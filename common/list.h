@@ -58,6 +58,19 @@ public:
 		insert(begin(), list.begin(), list.end());
 	}
 
+#if __cplusplus >= 201103L
+	/**
+	 * Construct a list by taking over the nodes of another one,
+	 * which is left empty. No elements are copied.
+	 */
+	List(List<t_T> &&list) {
+		_anchor._prev = &_anchor;
+		_anchor._next = &_anchor;
+
+		takeNodes(list);
+	}
+#endif
+
 	~List() {
 		clear();
 	}
@@ -131,6 +144,30 @@ public:
 		insert(&_anchor, element);
 	}
 
+#if __cplusplus >= 201103L
+	/** Inserts element at the start of the list, moving it into place. */
+	void push_front(t_T &&element) {
+		link(_anchor._next, new Node(Common::move(element)));
+	}
+
+	/** Appends element to the end of the list, moving it into place. */
+	void push_back(t_T &&element) {
+		link(&_anchor, new Node(Common::move(element)));
+	}
+
+	/** Constructs a new element in place at the start of the list from the given arguments. */
+	template<class... TArgs>
+	void emplace_front(TArgs &&...args) {
+		link(_anchor._next, new Node(Common::forward<TArgs>(args)...));
+	}
+
+	/** Constructs a new element in place at the end of the list from the given arguments. */
+	template<class... TArgs>
+	void emplace_back(TArgs &&...args) {
+		link(&_anchor, new Node(Common::forward<TArgs>(args)...));
+	}
+#endif
+
 	/** Removes the first element of the list. */
 	void pop_front() {
 		assert(!empty());
@@ -183,6 +220,17 @@ public:
 		return *this;
 	}
 
+#if __cplusplus >= 201103L
+	List<t_T> &operator=(List<t_T> &&list) {
+		if (this != &list) {
+			clear();
+			takeNodes(list);
+		}
+
+		return *this;
+	}
+#endif
+
 	size_type size() const {
 		size_type n = 0;
 		for (const NodeBase *cur = _anchor._next; cur != &_anchor; cur = cur->_next)
@@ -245,7 +293,13 @@ protected:
 	 * Inserts element before pos.
 	 */
 	void insert(NodeBase *pos, const t_T &element) {
-		ListInternal::NodeBase *newNode = new Node(element);
+		link(pos, new Node(element));
+	}
+
+	/**
+	 * Links newNode into the list before pos.
+	 */
+	void link(NodeBase *pos, NodeBase *newNode) {
 		assert(newNode);
 
 		newNode->_next = pos;
@@ -253,6 +307,25 @@ protected:
 		newNode->_prev->_next = newNode;
 		newNode->_next->_prev = newNode;
 	}
+
+#if __cplusplus >= 201103L
+	/**
+	 * Moves all nodes of list over to this list, which must be empty.
+	 */
+	void takeNodes(List<t_T> &list) {
+		assert(empty());
+		if (list.empty())
+			return;
+
+		_anchor._next = list._anchor._next;
+		_anchor._prev = list._anchor._prev;
+		_anchor._next->_prev = &_anchor;
+		_anchor._prev->_next = &_anchor;
+
+		list._anchor._prev = &list._anchor;
+		list._anchor._next = &list._anchor;
+	}
+#endif
 };
 
 } // End of namespace Common
@@ -24,6 +24,7 @@
 #define COMMON_LIST_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/type-traits.h"
 
 namespace Common {
 
@@ -41,6 +42,10 @@ namespace ListInternal {
 		T _data;
 
 		Node(const T &x) : _data(x) {}
+#if __cplusplus >= 201103L
+		template<class... TArgs>
+		explicit Node(TArgs &&...args) : _data(Common::forward<TArgs>(args)...) {}
+#endif
 	};
 
 	template<typename T> struct ConstIterator;
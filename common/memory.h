@@ -24,6 +24,7 @@
 #define COMMON_MEMORY_H
 
 #include "common/scummsys.h"
+#include "common/type-traits.h"
 
 namespace Common {
 
@@ -39,6 +40,24 @@ Type *uninitialized_copy(In first, In last, Type *dst) {
 	return dst;
 }
 
+/**
+ * Moves data from the range [first, last) to [dst, dst + (last - first)).
+ * It requires the range [dst, dst + (last - first)) to be valid and
+ * uninitialized. The source elements are left in a valid but unspecified
+ * state, and still need to be destroyed by the caller. Without C++11
+ * support this copies the elements instead.
+ */
+template<class Type>
+Type *uninitialized_move(Type *first, Type *last, Type *dst) {
+#if __cplusplus >= 201103L
+	while (first != last)
+		new ((void *)dst++) Type(Common::move(*first++));
+	return dst;
+#else
+	return uninitialized_copy(first, last, dst);
+#endif
+}
+
 /**
  * Initializes the memory [first, first + (last - first)) with the value x.
  * It requires the range [first, first + (last - first)) to be valid and
@@ -33,6 +33,7 @@ MODULE_OBJS := \
 	sinewindows.o \
 	str.o \
 	str-enc.o \
+	str-intern.o \
 	stream.o \
 	streamdebug.o \
 	system.o \
@@ -0,0 +1,136 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/str-intern.h"
+#include "common/hash-str.h"
+#include "common/mutex.h"
+
+namespace Common {
+
+typedef HashMap<String, const void *, CaseSensitiveString_Hash, CaseSensitiveString_EqualTo> InternPool;
+
+static InternPool *g_internPool = nullptr; // Never freed, the strings may be used until the very end
+static Mutex *g_internPoolMutex = nullptr;
+static const void *g_emptyEntry = nullptr;
+
+static void lockInternPool() {
+	// The mutex is created once the backend is initialized. Strings interned
+	// before that can only come from the main thread.
+	if (g_internPoolMutex)
+		g_internPoolMutex->lock();
+}
+
+static void unlockInternPool() {
+	if (g_internPoolMutex)
+		g_internPoolMutex->unlock();
+}
+
+void InternedString::createPoolMutex() {
+	if (!g_emptyEntry)
+		g_emptyEntry = intern(String());
+	if (!g_internPoolMutex)
+		g_internPoolMutex = new Mutex();
+}
+
+void InternedString::releasePoolMutex() {
+	delete g_internPoolMutex;
+	g_internPoolMutex = nullptr;
+}
+
+InternedString::Entry::Entry(const String &str) : _str(str), _hash(hashit(str.c_str())), _lower(nullptr) {
+}
+
+const InternedString::Entry *InternedString::intern(const String &str) {
+	lockInternPool();
+	if (!g_internPool)
+		g_internPool = new InternPool();
+
+	const void *&slot = (*g_internPool)[str];
+	if (!slot) {
+		Entry *entry = new Entry(str);
+
+		String lower(str);
+		lower.toLowercase();
+		if (lower.equals(str)) {
+			entry->_lower = entry;
+		} else {
+			const void *&lowerSlot = (*g_internPool)[lower];
+			if (!lowerSlot) {
+				Entry *lowerEntry = new Entry(lower);
+				lowerEntry->_lower = lowerEntry;
+				lowerSlot = lowerEntry;
+			}
+			entry->_lower = (const Entry *)lowerSlot;
+		}
+
+		// HashMap nodes never move, so the slot is still valid
+		slot = entry;
+		unlockInternPool();
+		return entry;
+	}
+	unlockInternPool();
+
+	return (const Entry *)slot;
+}
+
+InternedString::InternedString() {
+	// Only the main thread may get here before createPoolMutex() has set it
+	if (!g_emptyEntry)
+		g_emptyEntry = intern(String());
+	_entry = (const Entry *)g_emptyEntry;
+}
+
+InternedString::InternedString(const String &str) : _entry(intern(str)) {
+}
+
+InternedString::InternedString(const char *str) : _entry(intern(String(str))) {
+}
+
+bool InternedString::find(const String &str, InternedString &result, bool ignoreCase) {
+	const void *entry = nullptr;
+
+	lockInternPool();
+	if (g_internPool) {
+		InternPool::const_iterator i = g_internPool->find(str);
+		if (i != g_internPool->end()) {
+			entry = i->_value;
+		} else if (ignoreCase) {
+			String lower(str);
+			lower.toLowercase();
+			i = g_internPool->find(lower);
+			if (i != g_internPool->end())
+				entry = i->_value;
+		}
+	}
+	unlockInternPool();
+
+	if (!entry)
+		return false;
+	result = InternedString((const Entry *)entry);
+	return true;
+}
+
+uint InternedString::poolSize() {
+	return g_internPool ? g_internPool->size() : 0;
+}
+
+} // End of namespace Common
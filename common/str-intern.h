@@ -0,0 +1,145 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_STR_INTERN_H
+#define COMMON_STR_INTERN_H
+
+#include "common/func.h"
+#include "common/str.h"
+
+namespace Common {
+
+/**
+ * An immutable string which is stored only once in a global pool, no
+ * matter how often it is created.
+ *
+ * Interning a string looks it up in the pool, which costs about as much as
+ * one HashMap lookup. From then on, copying an InternedString only copies a
+ * pointer, comparing two of them only compares pointers (with or without
+ * regard to case) and both their case sensitive and case insensitive hashes
+ * are available without looking at the characters again. This makes them
+ * good keys for maps which are searched often, see InternedString_Hash and
+ * InternedString_IgnoreCase_Hash below.
+ *
+ * Strings are never removed from the pool, so only intern strings which
+ * come from a limited set, like resource names, script identifiers or
+ * configuration keys, and not arbitrary text.
+ */
+class InternedString {
+public:
+	/** Construct the empty string. */
+	InternedString();
+
+	/** Intern the given string. */
+	InternedString(const String &str);
+
+	/** Intern the given NULL-terminated C string. */
+	InternedString(const char *str);
+
+	const String &str() const { return _entry->_str; }
+	const char *c_str() const { return _entry->_str.c_str(); }
+	uint size() const         { return _entry->_str.size(); }
+	bool empty() const        { return _entry->_str.empty(); }
+
+	/** The hash of the string, the same as Hash<String> returns for it. */
+	uint hash() const           { return _entry->_hash; }
+	/** The case insensitive hash of the string, the same as IgnoreCase_Hash returns for it. */
+	uint hashIgnoreCase() const { return _entry->_lower->_hash; }
+
+	/** Return the interned lowercase version of this string. */
+	InternedString toLowercase() const { return InternedString(_entry->_lower); }
+
+	bool operator==(const InternedString &x) const { return _entry == x._entry; }
+	bool operator!=(const InternedString &x) const { return _entry != x._entry; }
+
+	bool equals(const InternedString &x) const           { return _entry == x._entry; }
+	bool equalsIgnoreCase(const InternedString &x) const { return _entry->_lower == x._entry->_lower; }
+
+	/** Order by content, like String does. */
+	bool operator<(const InternedString &x) const { return _entry != x._entry && _entry->_str < x._entry->_str; }
+
+	operator const String &() const { return _entry->_str; }
+
+	/**
+	 * Look the given string up without adding it to the pool.
+	 *
+	 * @param str     the string to look up
+	 * @param result  set to the interned string when it is found
+	 * @param ignoreCase  also accept the interned lowercase version of str
+	 * @return whether the string was found
+	 */
+	static bool find(const String &str, InternedString &result, bool ignoreCase = false);
+
+	/** Return the number of distinct strings in the pool. */
+	static uint poolSize();
+
+	/**
+	 * Create the mutex guarding the pool. This is done by OSystem::initBackend,
+	 * while there is only one thread, so the mutex is never created twice.
+	 * The empty string is interned at the same time, so constructing it
+	 * needs no locking afterwards.
+	 */
+	static void createPoolMutex();
+	static void releasePoolMutex();
+
+private:
+	struct Entry {
+		const String _str;
+		const uint _hash;
+		const Entry *_lower; ///< The entry of the lowercase string, which may be this one
+
+		Entry(const String &str);
+	};
+
+	explicit InternedString(const Entry *entry) : _entry(entry) {}
+
+	static const Entry *intern(const String &str);
+
+	const Entry *_entry;
+};
+
+struct InternedString_EqualTo {
+	bool operator()(const InternedString &x, const InternedString &y) const { return x.equals(y); }
+};
+
+struct InternedString_Hash {
+	uint operator()(const InternedString &x) const { return x.hash(); }
+};
+
+struct InternedString_IgnoreCase_EqualTo {
+	bool operator()(const InternedString &x, const InternedString &y) const { return x.equalsIgnoreCase(y); }
+};
+
+struct InternedString_IgnoreCase_Hash {
+	uint operator()(const InternedString &x) const { return x.hashIgnoreCase(); }
+};
+
+template<>
+struct Hash<InternedString> {
+	uint operator()(const InternedString &s) const {
+		return s.hash();
+	}
+};
+
+} // End of namespace Common
+
+#endif
@@ -116,6 +116,27 @@ String::String(const String &str)
 	assert(_str != nullptr);
 }
 
+#if __cplusplus >= 201103L
+String::String(String &&str)
+	: _size(str._size) {
+	if (str.isStorageIntern()) {
+		// String in internal storage: just copy it
+		memcpy(_storage, str._storage, _builtinCapacity);
+		_str = _storage;
+	} else {
+		// String in external storage: take it over, the ref count stays the same
+		_extern._refCount = str._extern._refCount;
+		_extern._capacity = str._extern._capacity;
+		_str = str._str;
+
+		str._str = str._storage;
+	}
+	str._size = 0;
+	str._storage[0] = 0;
+	assert(_str != nullptr);
+}
+#endif
+
 String::String(char c)
 	: _size(0), _str(_storage) {
 
@@ -278,6 +299,31 @@ String &String::operator=(const String &str) {
 	return *this;
 }
 
+#if __cplusplus >= 201103L
+String &String::operator=(String &&str) {
+	if (&str == this)
+		return *this;
+
+	decRefCount(_extern._refCount);
+	_size = str._size;
+
+	if (str.isStorageIntern()) {
+		_str = _storage;
+		memcpy(_str, str._str, _size + 1);
+	} else {
+		_extern._refCount = str._extern._refCount;
+		_extern._capacity = str._extern._capacity;
+		_str = str._str;
+
+		str._str = str._storage;
+	}
+	str._size = 0;
+	str._storage[0] = 0;
+
+	return *this;
+}
+#endif
+
 String &String::operator=(char c) {
 	decRefCount(_extern._refCount);
 	_str = _storage;
@@ -126,6 +126,11 @@ public:
 	/** Construct a copy of the given string. */
 	String(const String &str);
 
+#if __cplusplus >= 201103L
+	/** Construct a string by taking over the storage of the given string, which is left empty. */
+	String(String &&str);
+#endif
+
 	/** Construct a string consisting of the given character. */
 	explicit String(char c);
 
@@ -136,6 +141,9 @@ public:
 
 	String &operator=(const char *str);
 	String &operator=(const String &str);
+#if __cplusplus >= 201103L
+	String &operator=(String &&str);
+#endif
 	String &operator=(char c);
 	String &operator+=(const char *str);
 	String &operator+=(const String &str);
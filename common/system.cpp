@@ -27,6 +27,7 @@
 #include "common/fs.h"
 #include "common/savefile.h"
 #include "common/str.h"
+#include "common/str-intern.h"
 #include "common/taskbar.h"
 #include "common/updates.h"
 #include "common/dialogs.h"
@@ -119,11 +120,14 @@ void OSystem::initBackend() {
 // 		error("Backend failed to instantiate fs factory");
 
 	_backendInitialized = true;
+
+	Common::InternedString::createPoolMutex();
 }
 
 void OSystem::destroy() {
 	_backendInitialized = false;
 	Common::String::releaseMemoryPoolMutex();
+	Common::InternedString::releasePoolMutex();
 	delete this;
 }
 
@@ -24,6 +24,7 @@
 #define COMMON_TIMER_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/str.h"
 #include "common/noncopyable.h"
 
@@ -55,6 +56,22 @@ public:
 	 * and no instance of this callback will be running anymore.
 	 */
 	virtual void removeTimerProc(TimerProc proc) = 0;
+
+	/** How often an installed timer callback ran, and how long it took. */
+	struct TimerStats {
+		String id;
+		uint32 interval;  ///< in microseconds
+		uint32 calls;
+		uint32 totalTime; ///< in milliseconds, like the times below
+		uint32 maxTime;
+		uint32 maxDelay;  ///< how much later than scheduled the callback ran at most
+	};
+
+	/**
+	 * Get the statistics of all installed timer callbacks, for spotting slow
+	 * ones. Timer managers which do not keep statistics return none.
+	 */
+	virtual void getTimerStats(Array<TimerStats> &stats) { stats.clear(); }
 };
 
 } // End of namespace Common
@@ -29,6 +29,28 @@ namespace Common {
 	template <typename T> struct RemoveConst { typedef T type; };
 	template <typename T> struct RemoveConst<const T> { typedef T type; };
 	template <typename T> struct AddConst { typedef const T type; };
+	template <typename T> struct RemoveReference { typedef T type; };
+	template <typename T> struct RemoveReference<T &> { typedef T type; };
+#if __cplusplus >= 201103L
+	template <typename T> struct RemoveReference<T &&> { typedef T type; };
+
+	/** Our replacement for std::move: casts t to an rvalue, so that it can be moved from. */
+	template <typename T>
+	inline typename RemoveReference<T>::type &&move(T &&t) {
+		return static_cast<typename RemoveReference<T>::type &&>(t);
+	}
+
+	/** Our replacement for std::forward, for passing on arguments of variadic templates. */
+	template <typename T>
+	inline T &&forward(typename RemoveReference<T>::type &t) {
+		return static_cast<T &&>(t);
+	}
+
+	template <typename T>
+	inline T &&forward(typename RemoveReference<T>::type &&t) {
+		return static_cast<T &&>(t);
+	}
+#endif
 } // End of namespace Common
 
 #endif
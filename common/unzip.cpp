@@ -106,9 +106,12 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/substream.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
+#include "common/ptr.h"
 
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
@@ -316,6 +319,15 @@ int unzGetLocalExtrafield(unzFile file, voidp buf, unsigned len);
 	the error code
 */
 
+int unzGetCurrentFileDataOffset(unzFile file, uLong *pOffset);
+/*
+  Get the position in the zipfile stream of the first data byte of the
+    current file, after validating its local header.
+  This allows reading the (possibly compressed) data directly, without
+    going through unzOpenCurrentFile.
+  return UNZ_OK if there is no problem.
+*/
+
 #if !defined(unix) && !defined(CASESENSITIVITYDEFAULT_YES) && \
                       !defined(CASESENSITIVITYDEFAULT_NO)
 #define CASESENSITIVITYDEFAULT_NO
@@ -382,6 +394,8 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef;	/* owns _stream, shared with open member streams */
+	Common::SharedPtr<Common::Mutex> _streamMutex;	/* held while seeking and reading _stream, shared with open member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -544,6 +558,8 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_streamRef = Common::SharedPtr<Common::SeekableReadStream>(stream);
+	us->_streamMutex = Common::SharedPtr<Common::Mutex>(new Common::Mutex());
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -595,7 +611,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -644,7 +659,6 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != nullptr)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1343,6 +1357,31 @@ int unzGetLocalExtrafield(unzFile file, voidp buf, unsigned len) {
 	return (int)read_now;
 }
 
+/*
+  Get the position in the zipfile stream of the data of the current file.
+  return UNZ_OK if there is no problem.
+*/
+int unzGetCurrentFileDataOffset(unzFile file, uLong *pOffset) {
+	uInt iSizeVar;
+	unz_s* s;
+	uLong offset_local_extrafield;
+	uInt  size_local_extrafield;
+
+	if (file==nullptr || pOffset==nullptr)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (!s->current_file_ok)
+		return UNZ_PARAMERROR;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return UNZ_BADZIPFILE;
+
+	*pOffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER +
+			iSizeVar + s->byte_before_the_zipfile;
+	return UNZ_OK;
+}
+
 /*
   Close the file in zip opened with unzipOpenCurrentFile
   Return UNZ_CRCERROR if all the file was read but the CRC is not good
@@ -1420,6 +1459,252 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 namespace Common {
 
 
+/**
+ * Read stream for a stored (uncompressed) archive member. The data is read
+ * straight from the archive stream, without any intermediate copy.
+ */
+class ZipStoredReadStream : public SafeSeekableSubReadStream {
+	SharedPtr<SeekableReadStream> _archiveStream;
+	SharedPtr<Mutex> _archiveMutex;
+
+public:
+	ZipStoredReadStream(const SharedPtr<SeekableReadStream> &archiveStream, const SharedPtr<Mutex> &archiveMutex,
+	                    uint32 begin, uint32 size)
+		: SafeSeekableSubReadStream(archiveStream.get(), begin, begin + size, DisposeAfterUse::NO),
+		  _archiveStream(archiveStream), _archiveMutex(archiveMutex) {
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		// The parent stream is seeked to our position before reading
+		StackLock lock(*_archiveMutex);
+		return SafeSeekableSubReadStream::read(dataPtr, dataSize);
+	}
+};
+
+#ifdef USE_ZLIB
+
+/**
+ * Read stream for a deflated archive member, decompressing on demand.
+ *
+ * While decompressing, a copy of the inflate state is saved every
+ * CHECKPOINT_INTERVAL bytes of output. Seeking backwards, or far forward
+ * past an already known checkpoint, resumes decompression from the closest
+ * checkpoint instead of restarting from the beginning of the member.
+ */
+class ZipInflateReadStream : public SeekableReadStream {
+	enum {
+		BUFSIZE = UNZ_BUFSIZE,
+		CHECKPOINT_INTERVAL = 1024 * 1024
+	};
+
+	struct Checkpoint {
+		z_stream state;
+		uint32 compressedPos;
+		uint32 pos;
+	};
+
+	SharedPtr<SeekableReadStream> _archiveStream;
+	SharedPtr<Mutex> _archiveMutex;
+	uint32 _dataOffset;
+	uint32 _compressedSize;
+	uint32 _size;
+
+	z_stream _stream;
+	bool _streamInitialized;
+	byte _buf[BUFSIZE];
+	uint32 _compressedPos;  // position in the compressed data of the next refill
+	uint32 _pos;            // position in the uncompressed data
+
+	Array<Checkpoint *> _checkpoints;
+
+	uLong _crc;
+	uLong _expectedCrc;
+	uint32 _crcPos;         // uncompressed bytes already accounted for in _crc
+
+	bool _err;
+	bool _eos;
+
+	void updateCrc(const byte *data, uint32 start, uint32 len) {
+		// Bytes are only added once, in order, so the CRC stays valid
+		// even when decompression is resumed from a checkpoint.
+		uint32 end = start + len;
+		if (start > _crcPos || end <= _crcPos)
+			return;
+
+		_crc = crc32(_crc, data + (_crcPos - start), end - _crcPos);
+		_crcPos = end;
+
+		if (_crcPos == _size && _crc != _expectedCrc) {
+			warning("ZipInflateReadStream: CRC mismatch");
+			_err = true;
+		}
+	}
+
+	void addCheckpoint() {
+		Checkpoint *checkpoint = new Checkpoint();
+		if (inflateCopy(&checkpoint->state, &_stream) != Z_OK) {
+			delete checkpoint;
+			return;
+		}
+		checkpoint->compressedPos = _compressedPos - _stream.avail_in;
+		checkpoint->pos = _pos;
+		_checkpoints.push_back(checkpoint);
+	}
+
+	bool restart(const Checkpoint *checkpoint) {
+		if (_streamInitialized) {
+			inflateEnd(&_stream);
+			_streamInitialized = false;
+		}
+
+		int zlibErr;
+		if (checkpoint) {
+			zlibErr = inflateCopy(&_stream, const_cast<z_stream *>(&checkpoint->state));
+			_compressedPos = checkpoint->compressedPos;
+			_pos = checkpoint->pos;
+		} else {
+			_stream.zalloc = (alloc_func)nullptr;
+			_stream.zfree = (free_func)nullptr;
+			_stream.opaque = (voidpf)nullptr;
+			zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+			_compressedPos = 0;
+			_pos = 0;
+		}
+
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		_streamInitialized = (zlibErr == Z_OK);
+		_err = !_streamInitialized;
+		return _streamInitialized;
+	}
+
+	uint32 inflateData(byte *dst, uint32 dataSize) {
+		_stream.next_out = dst;
+		_stream.avail_out = dataSize;
+
+		while (!_err && _stream.avail_out > 0) {
+			if (_stream.avail_in == 0) {
+				uint32 toRead = MIN<uint32>(BUFSIZE, _compressedSize - _compressedPos);
+				if (toRead > 0) {
+					StackLock lock(*_archiveMutex);
+					_archiveStream->seek(_dataOffset + _compressedPos, SEEK_SET);
+					if (_archiveStream->read(_buf, toRead) != toRead) {
+						_err = true;
+						break;
+					}
+					_compressedPos += toRead;
+				}
+				_stream.next_in = _buf;
+				_stream.avail_in = toRead;
+			}
+
+			byte *start = _stream.next_out;
+			int zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			uint32 produced = _stream.next_out - start;
+
+			updateCrc(start, _pos, produced);
+			_pos += produced;
+
+			if (_pos >= (_checkpoints.empty() ? 0 : _checkpoints.back()->pos) + CHECKPOINT_INTERVAL && _pos < _size)
+				addCheckpoint();
+
+			if (zlibErr == Z_STREAM_END) {
+				if (_stream.avail_out > 0)
+					_err = true;
+				break;
+			}
+			if (zlibErr == Z_BUF_ERROR && _compressedPos < _compressedSize)
+				continue;
+			if (zlibErr != Z_OK)
+				_err = true;
+		}
+
+		return dataSize - _stream.avail_out;
+	}
+
+public:
+	ZipInflateReadStream(const SharedPtr<SeekableReadStream> &archiveStream, const SharedPtr<Mutex> &archiveMutex,
+	                     uint32 dataOffset, uint32 compressedSize, uint32 size, uLong crc)
+		: _archiveStream(archiveStream), _archiveMutex(archiveMutex), _dataOffset(dataOffset), _compressedSize(compressedSize),
+		  _size(size), _stream(), _streamInitialized(false), _compressedPos(0), _pos(0),
+		  _crc(crc32(0L, Z_NULL, 0)), _expectedCrc(crc), _crcPos(0), _err(false), _eos(false) {
+		restart(nullptr);
+	}
+
+	~ZipInflateReadStream() {
+		for (uint i = 0; i < _checkpoints.size(); i++) {
+			inflateEnd(&_checkpoints[i]->state);
+			delete _checkpoints[i];
+		}
+		if (_streamInitialized)
+			inflateEnd(&_stream);
+	}
+
+	bool err() const { return _err; }
+	void clearErr() {
+		// only reset _eos; decompression errors are not recoverable
+		_eos = false;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (_err)
+			return 0;
+
+		if (dataSize > _size - _pos) {
+			dataSize = _size - _pos;
+			_eos = true;
+		}
+
+		return inflateData((byte *)dataPtr, dataSize);
+	}
+
+	bool eos() const { return _eos; }
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 newPos = 0;
+		switch (whence) {
+		default:
+			// fallthrough intended
+		case SEEK_SET:
+			newPos = offset;
+			break;
+		case SEEK_CUR:
+			newPos = _pos + offset;
+			break;
+		case SEEK_END:
+			newPos = _size + offset;
+			break;
+		}
+
+		if (newPos < 0 || (uint32)newPos > _size)
+			return false;
+
+		// Find the closest checkpoint at or before the target, and only use
+		// it if it lets us skip data we would otherwise have to inflate.
+		const Checkpoint *checkpoint = nullptr;
+		for (uint i = 0; i < _checkpoints.size() && _checkpoints[i]->pos <= (uint32)newPos; i++)
+			checkpoint = _checkpoints[i];
+
+		if ((uint32)newPos < _pos || (checkpoint && checkpoint->pos > _pos)) {
+			if (!restart(checkpoint))
+				return false;
+		}
+
+		byte tmpBuf[4096];
+		while (!_err && _pos < (uint32)newPos) {
+			if (inflateData(tmpBuf, MIN<uint32>(sizeof(tmpBuf), newPos - _pos)) == 0)
+				break;
+		}
+
+		_eos = false;
+		return !_err;
+	}
+};
+
+#endif // USE_ZLIB
+
 class ZipArchive : public Archive {
 	unzFile _zipFile;
 
@@ -1462,6 +1747,9 @@ ZipArchive::~ZipArchive() {
 }
 
 bool ZipArchive::hasFile(const String &name) const {
+	// Locating a file changes the current file of the archive
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	StackLock lock(*archive->_streamMutex);
 	return (unzLocateFile(_zipFile, name.c_str(), 2) == UNZ_OK);
 }
 
@@ -1486,35 +1774,37 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 }
 
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
+	// The member streams share the archive stream, and keep it alive when
+	// they outlive the archive itself. Every stream seeks the archive stream
+	// before reading from it, under the archive mutex, so several members
+	// can be used independently, also from different threads.
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	StackLock lock(*archive->_streamMutex);
+
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return nullptr;
 
 	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
-		return nullptr;
-
 	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, nullptr, 0, nullptr, 0, nullptr, 0) != UNZ_OK)
 		return nullptr;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
-
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
+	uLong dataOffset;
+	if (unzGetCurrentFileDataOffset(_zipFile, &dataOffset) != UNZ_OK)
 		return nullptr;
-	}
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
-		return nullptr;
+	if (fileInfo.compression_method == 0) {
+		if (fileInfo.compressed_size != fileInfo.uncompressed_size)
+			return nullptr;
+		return new ZipStoredReadStream(archive->_streamRef, archive->_streamMutex, dataOffset, fileInfo.uncompressed_size);
 	}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+#ifdef USE_ZLIB
+	if (fileInfo.compression_method == Z_DEFLATED)
+		return new ZipInflateReadStream(archive->_streamRef, archive->_streamMutex, dataOffset,
+		                                fileInfo.compressed_size, fileInfo.uncompressed_size, fileInfo.crc);
+#endif
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return nullptr;
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -194,7 +194,8 @@ void Animation::restoreState(SaveGame *state) {
  * @class AnimManager
  */
 
-AnimManager::AnimManager() {
+AnimManager::AnimManager() :
+		_hier(nullptr), _numNodes(0), _animatedNodesDirty(true) {
 
 }
 
@@ -235,6 +236,8 @@ void AnimManager::addAnimation(Animation *anim, int priority1, int priority2) {
 	}
 	if (i == _activeAnims.end())
 		_activeAnims.push_back(entry);
+
+	_animatedNodesDirty = true;
 }
 
 void AnimManager::removeAnimation(const Animation *anim) {
@@ -245,11 +248,48 @@ void AnimManager::removeAnimation(const Animation *anim) {
 			--i;
 		}
 	}
+
+	_animatedNodesDirty = true;
+}
+
+void AnimManager::updateAnimatedNodes(ModelNode *hier, int numNodes) {
+	// Which nodes a keyframe animates only depends on the node types, so it is
+	// worked out once for each animation instead of for every frame.
+	bool hierChanged = (hier != _hier || numNodes != _numNodes);
+	if (!hierChanged && !_animatedNodesDirty)
+		return;
+
+	_hier = hier;
+	_numNodes = numNodes;
+	_animatedNodesDirty = false;
+
+	_animatedNodes.clear();
+	_animatedNodes.resize(numNodes);
+	for (Common::List<AnimationEntry>::iterator j = _activeAnims.begin(); j != _activeAnims.end(); ++j) {
+		if (hierChanged || j->_animatedNodes.size() != (uint)numNodes) {
+			j->_animatedNodes.resize(numNodes);
+			j->_cursors.clear();
+			j->_cursors.resize(numNodes);
+			for (int i = 0; i < numNodes; i++)
+				j->_animatedNodes[i] = j->_anim->_keyframe->isNodeAnimated(hier, i, j->_tagged);
+		}
+
+		for (int i = 0; i < numNodes; i++) {
+			if (j->_animatedNodes[i])
+				_animatedNodes[i] = true;
+		}
+	}
 }
 
 void AnimManager::animate(ModelNode *hier, int numNodes) {
+	updateAnimatedNodes(hier, numNodes);
+
 	// Apply animation to each hierarchy node separately.
 	for (int i = 0; i < numNodes; i++) {
+		// Nothing to blend on the nodes which none of the animations move.
+		if (!_animatedNodes[i])
+			continue;
+
 		float remainingWeight = 1.0f;
 		int currPriority = -1;
 		float layerWeight = 0.0f;
@@ -265,8 +305,7 @@ void AnimManager::animate(ModelNode *hier, int numNodes) {
 				for (Common::List<AnimationEntry>::iterator k = j; k != _activeAnims.end(); ++k) {
 					if (j->_priority != k->_priority)
 						break;
-					float time = k->_anim->_time / 1000.0f;
-					if (k->_anim->_keyframe->isNodeAnimated(hier, i, time, k->_tagged))
+					if (k->_animatedNodes[i])
 						layerWeight += k->_anim->_fade;
 				}
 
@@ -275,12 +314,16 @@ void AnimManager::animate(ModelNode *hier, int numNodes) {
 					break;
 			}
 
+			// Animations which don't move this node would leave it untouched.
+			if (!j->_animatedNodes[i])
+				continue;
+
 			float time = j->_anim->_time / 1000.0f;
 			float weight = j->_anim->_fade;
 			if (layerWeight > 1.0f)
 				weight /= layerWeight;
 			weight *= remainingWeight;
-			j->_anim->_keyframe->animate(hier, i, time, weight, j->_tagged);
+			j->_anim->_keyframe->animate(hier, i, time, weight, j->_tagged, j->_cursors[i]);
 		}
 	}
 }
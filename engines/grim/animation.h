@@ -23,6 +23,8 @@
 #ifndef GRIM_ANIMATION_H
 #define GRIM_ANIMATION_H
 
+#include "common/array.h"
+
 #include "engines/grim/keyframe.h"
 
 namespace Grim {
@@ -90,9 +92,20 @@ private:
 		Animation *_anim;
 		int _priority;
 		bool _tagged;
+		/** Which nodes of the hierarchy the keyframe animates, see updateAnimatedNodes(). */
+		Common::Array<bool> _animatedNodes;
+		/** The keyframe entry each node used the last time, see KeyframeAnim::animate(). */
+		Common::Array<int> _cursors;
 	};
 
+	void updateAnimatedNodes(ModelNode *hier, int numNodes);
+
 	Common::List<AnimationEntry> _activeAnims;
+	ModelNode *_hier;
+	int _numNodes;
+	bool _animatedNodesDirty;
+	/** Whether any of the active animations animates each node. */
+	Common::Array<bool> _animatedNodes;
 };
 
 }
@@ -110,7 +110,7 @@ Costume::Costume(const Common::String &fname, Actor *owner, Costume *prevCost) :
 }
 
 void Costume::load(Common::SeekableReadStream *data) {
-	TextSplitter ts(_fname, data);
+	TextSplitter ts(_fname, data, true);
 	ts.expectString("costume v0.1");
 	ts.expectString("section tags");
 	int numTags;
@@ -20,12 +20,21 @@
  *
  */
 
+#include "common/algorithm.h"
 #include "common/config-manager.h"
+#include "common/foreach.h"
 #include "graphics/renderer.h"
+#if defined(USE_GLES2) || defined(USE_OPENGL_SHADERS)
+#include "graphics/opengl/shader.h"
+#endif
 
 #include "engines/grim/debugger.h"
 #include "engines/grim/md5check.h"
 #include "engines/grim/grim.h"
+#include "engines/grim/actor.h"
+#include "engines/grim/imuse/imuse.h"
+#include "engines/grim/emi/costumeemi.h"
+#include "engines/grim/emi/modelemi.h"
 
 namespace Grim {
 
@@ -38,6 +47,9 @@ Debugger::Debugger() :
 	registerCmd("set_renderer", WRAP_METHOD(Debugger, cmd_set_renderer));
 	registerCmd("save", WRAP_METHOD(Debugger, cmd_save));
 	registerCmd("load", WRAP_METHOD(Debugger, cmd_load));
+	registerCmd("imuse", WRAP_METHOD(Debugger, cmd_imuse));
+	registerCmd("skinning", WRAP_METHOD(Debugger, cmd_skinning));
+	registerCmd("shader_stats", WRAP_METHOD(Debugger, cmd_shaderStats));
 }
 
 Debugger::~Debugger() {
@@ -127,4 +139,63 @@ bool Debugger::cmd_load(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmd_imuse(int argc, const char **argv) {
+	if (!g_imuse) {
+		debugPrintf("iMUSE is not used by this game\n");
+		return true;
+	}
+	debugPrintf("Underruns: %u\n", g_imuse->getUnderrunCount());
+	debugPrintf("%s", g_imuse->getTrackStatus().c_str());
+	return true;
+}
+
+bool Debugger::cmd_skinning(int argc, const char **argv) {
+	if (g_grim->getGameType() != GType_MONKEY4) {
+		debugPrintf("Only EMI uses skinned models\n");
+		return true;
+	}
+	int frames = argc > 1 ? atoi(argv[1]) : 0;
+	if (frames <= 0)
+		frames = 100;
+
+	// Skin every model worn by the actors of the current set
+	Common::Array<EMIModel *> models;
+	int vertices = 0, influences = 0;
+	foreach (Actor *actor, g_grim->getActiveActors()) {
+		foreach (Costume *costume, actor->getCostumes()) {
+			EMICostume *emiCostume = static_cast<EMICostume *>(costume);
+			for (int i = -1; i < emiCostume->getNumChores(); i++) {
+				EMIModel *model = i < 0 ? emiCostume->getEMIModel() : emiCostume->getEMIModel(i);
+				if (!model || !model->_skeleton || Common::find(models.begin(), models.end(), model) != models.end())
+					continue;
+				models.push_back(model);
+				vertices += model->_numVertices;
+				influences += model->_numSkinInfluences;
+			}
+		}
+	}
+
+	uint32 start = g_system->getMillis();
+	for (int i = 0; i < frames; i++) {
+		for (uint j = 0; j < models.size(); j++)
+			models[j]->updateSkinning();
+	}
+	uint32 elapsed = g_system->getMillis() - start;
+
+	debugPrintf("%u models, %d vertices, %d influences\n", models.size(), vertices, influences);
+	debugPrintf("%d frames in %u ms, %.3f ms per frame\n", frames, elapsed, (float)elapsed / frames);
+	return true;
+}
+
+bool Debugger::cmd_shaderStats(int argc, const char **argv) {
+#if defined(USE_GLES2) || defined(USE_OPENGL_SHADERS)
+	const OpenGL::Shader::Stats &stats = OpenGL::Shader::getFrameStats();
+	debugPrintf("Last frame: %u program changes, %u uniform uploads, %u redundant uniforms skipped\n",
+	            stats._programChanges, stats._uniformUploads, stats._redundantUniforms);
+#else
+	debugPrintf("Shaders are not available in this build\n");
+#endif
+	return true;
+}
+
 }
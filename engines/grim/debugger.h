@@ -40,6 +40,9 @@ public:
 	bool cmd_set_renderer(int argc, const char **argv);
 	bool cmd_save(int argc, const char **argv);
 	bool cmd_load(int argc, const char **argv);
+	bool cmd_imuse(int argc, const char **argv);
+	bool cmd_skinning(int argc, const char **argv);
+	bool cmd_shaderStats(int argc, const char **argv);
 };
 
 }
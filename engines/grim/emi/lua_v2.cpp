@@ -32,6 +32,7 @@
 
 #include "engines/grim/resource.h"
 #include "engines/grim/set.h"
+#include "engines/grim/savegame.h"
 #include "engines/grim/grim.h"
 #include "engines/grim/gfx_base.h"
 #include "engines/grim/font.h"
@@ -460,6 +461,8 @@ void Lua_V2::FileFindFirst() {
 	if (0 == strcmp(extension, "*.gsv"))
 		extension = "efmi###.gsv";
 
+	// A savegame being written in the background must be listed as well
+	SaveGame::waitForPendingWrites();
 	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
 	g_grim->_listFiles = saveFileMan->listSavefiles(extension);
 	Common::sort(g_grim->_listFiles.begin(), g_grim->_listFiles.end());
@@ -22,6 +22,7 @@
 
 #include "common/endian.h"
 #include "common/foreach.h"
+#include "math/simd.h"
 #include "engines/grim/debug.h"
 #include "engines/grim/grim.h"
 #include "engines/grim/material.h"
@@ -222,20 +223,27 @@ void EMIModel::setSkeleton(Skeleton *skel) {
 	if (!skel || !_numBoneInfos) {
 		return;
 	}
-	delete[] _vertexBoneInfo; _vertexBoneInfo = nullptr;
-	_vertexBoneInfo = new int[_numBoneInfos];
-	for (int i = 0; i < _numBoneInfos; i++) {
-		_vertexBoneInfo[i] = _skeleton->findJointIndex(_boneNames[_boneInfos[i]._joint]);
-	}
-}
 
-void EMIModel::prepareForRender() {
-	if (!_skeleton || !_vertexBoneInfo)
-		return;
-
-	for (int i = 0; i < _numVertices; i++) {
-		_drawVertices[i].set(0.0f, 0.0f, 0.0f);
-		_drawNormals[i].set(0.0f, 0.0f, 0.0f);
+	delete[] _skinVertices;
+	delete[] _skinSlots;
+	delete[] _skinWeights;
+	delete[] _skinJoints;
+	delete[] _skinJointRadii;
+	delete[] _skinMatrices;
+	_skinVertices = new int[_numBoneInfos];
+	_skinSlots = new int[_numBoneInfos];
+	_skinWeights = new float[_numBoneInfos];
+	_skinJoints = new int[_numBoneInfos];
+	_skinJointRadii = new float[_numBoneInfos];
+	_numSkinInfluences = 0;
+	_numSkinSlots = 0;
+	_skinBoundsValid = true;
+
+	// Every joint the model uses gets a slot, so that the skinning matrices
+	// of the other joints of the skeleton do not need to be calculated.
+	int *jointSlots = new int[skel->_numJoints];
+	for (int i = 0; i < skel->_numJoints; i++) {
+		jointSlots[i] = -1;
 	}
 
 	int boneVert = -1;
@@ -244,27 +252,166 @@ void EMIModel::prepareForRender() {
 			boneVert++;
 		}
 
-		int jointIndex = _vertexBoneInfo[i];
-		const Math::Matrix4 &jointMatrix = _skeleton->_joints[jointIndex]._finalMatrix;
-		const Math::Matrix4 &bindPose = _skeleton->_joints[jointIndex]._absMatrix;
+		int jointIndex = skel->findJointIndex(_boneNames[_boneInfos[i]._joint]);
+		if (boneVert < 0 || boneVert >= _numVertices || jointIndex < 0) {
+			warning("EMIModel::setSkeleton: Invalid bone info %d in %s", i, _fname.c_str());
+			_skinBoundsValid = false;
+			continue;
+		}
+
+		int &slot = jointSlots[jointIndex];
+		if (slot < 0) {
+			slot = _numSkinSlots++;
+			_skinJoints[slot] = jointIndex;
+			_skinJointRadii[slot] = 0.0f;
+		}
 
-		Math::Vector3d vert = _vertices[boneVert];
-		bindPose.inverseTranslate(&vert);
-		bindPose.inverseRotate(&vert);
-		jointMatrix.transform(&vert, true);
-		_drawVertices[boneVert] += vert * _boneInfos[i]._weight;
+		const Math::Vector3d bindPos = skel->_joints[jointIndex]._absMatrix.getPosition();
+		_skinJointRadii[slot] = MAX(_skinJointRadii[slot], _vertices[boneVert].getDistanceTo(bindPos));
 
-		Math::Vector3d normal = _normals[boneVert];
-		bindPose.inverseRotate(&normal);
-		jointMatrix.transform(&normal, false);
-		_drawNormals[boneVert] += normal * _boneInfos[i]._weight;
+		_skinVertices[_numSkinInfluences] = boneVert;
+		_skinSlots[_numSkinInfluences] = slot;
+		_skinWeights[_numSkinInfluences] = _boneInfos[i]._weight;
+		_numSkinInfluences++;
+	}
+	delete[] jointSlots;
+
+	_skinMatrices = new float[_numSkinSlots * 16];
+	_skinDirty = true;
+
+	// The joint transformations are rigid, so every skinned vertex stays within
+	// the sphere around its joints that it was in in the bind pose. That only
+	// carries over to the blended vertex if its weights form an affine
+	// combination, and if every vertex is skinned at all.
+	int skinned = 0;
+	for (int i = 0; i < _numSkinInfluences && _skinBoundsValid; skinned++) {
+		const int vertex = _skinVertices[i];
+		float sum = 0.0f;
+		do {
+			if (_skinWeights[i] < 0.0f)
+				_skinBoundsValid = false;
+			sum += _skinWeights[i];
+		} while (++i < _numSkinInfluences && _skinVertices[i] == vertex);
+		if (fabs(sum - 1.0f) > 0.01f)
+			_skinBoundsValid = false;
 	}
+	if (skinned != _numVertices)
+		_skinBoundsValid = false;
+}
 
-	for (int i = 0; i < _numVertices; i++) {
-		_drawNormals[i].normalize();
+void EMIModel::updateSkinning() {
+	if (!_skeleton || !_skinMatrices)
+		return;
+
+	updateSkinningMatrices();
+	skinVertices();
+}
+
+bool EMIModel::updateSkinningMatrices() {
+	// Calculate the skinning matrix of every joint slot, which is the animated
+	// joint matrix times the inverse of the bind pose. The bind pose is rigid,
+	// so its inverse is the transposed rotation and the rotated negative
+	// translation.
+	bool changed = _skinDirty;
+	for (int slot = 0; slot < _numSkinSlots; slot++) {
+		const Joint &joint = _skeleton->_joints[_skinJoints[slot]];
+		const Math::Matrix4 &f = joint._finalMatrix;
+		const Math::Matrix4 &b = joint._absMatrix;
+		float m[16];
+
+		for (int col = 0; col < 3; col++) {
+			for (int row = 0; row < 3; row++) {
+				m[col * 4 + row] = f(row, 0) * b(col, 0) + f(row, 1) * b(col, 1) + f(row, 2) * b(col, 2);
+			}
+			m[col * 4 + 3] = 0.0f;
+		}
+		for (int row = 0; row < 3; row++) {
+			m[12 + row] = f(row, 3) - (m[row] * b(0, 3) + m[4 + row] * b(1, 3) + m[8 + row] * b(2, 3));
+		}
+		m[15] = 1.0f;
+
+		float *dst = _skinMatrices + slot * 16;
+		if (memcmp(dst, m, sizeof(m)) != 0) {
+			memcpy(dst, m, sizeof(m));
+			changed = true;
+		}
+	}
+	_skinDirty = false;
+	return changed;
+}
+
+void EMIModel::skinVertices() {
+	if (!_skinBoundsValid) {
+		// Some vertices may not have an influence and stay at the origin
+		for (int i = 0; i < _numVertices; i++) {
+			_drawVertices[i].set(0.0f, 0.0f, 0.0f);
+			_drawNormals[i].set(0.0f, 0.0f, 0.0f);
+		}
 	}
 
-	g_driver->updateEMIModel(this);
+	// Blend the transformed positions and normals of each vertex. The
+	// influences of a vertex are next to each other, so each vertex is
+	// written only once.
+	const int *vertices = _skinVertices;
+	const int *slots = _skinSlots;
+	const float *weights = _skinWeights;
+	const int count = _numSkinInfluences;
+	for (int i = 0; i < count; ) {
+		const int v = vertices[i];
+		const Math::Vector3d &vert = _vertices[v];
+		const Math::Vector3d &normal = _normals[v];
+#ifdef MATH_USE_SSE2
+		const __m128 vx = _mm_set1_ps(vert.x()), vy = _mm_set1_ps(vert.y()), vz = _mm_set1_ps(vert.z());
+		const __m128 nx = _mm_set1_ps(normal.x()), ny = _mm_set1_ps(normal.y()), nz = _mm_set1_ps(normal.z());
+		__m128 pos = _mm_setzero_ps(), nrm = _mm_setzero_ps();
+		do {
+			const float *m = _skinMatrices + slots[i] * 16;
+			const __m128 w = _mm_set1_ps(weights[i]);
+			const __m128 c0 = _mm_mul_ps(_mm_loadu_ps(m), w);
+			const __m128 c1 = _mm_mul_ps(_mm_loadu_ps(m + 4), w);
+			const __m128 c2 = _mm_mul_ps(_mm_loadu_ps(m + 8), w);
+			const __m128 c3 = _mm_mul_ps(_mm_loadu_ps(m + 12), w);
+			pos = _mm_add_ps(pos, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, vx), _mm_mul_ps(c1, vy)), _mm_add_ps(_mm_mul_ps(c2, vz), c3)));
+			nrm = _mm_add_ps(nrm, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, nx), _mm_mul_ps(c1, ny)), _mm_mul_ps(c2, nz)));
+		} while (++i < count && vertices[i] == v);
+
+		float result[8];
+		_mm_storeu_ps(result, pos);
+		_mm_storeu_ps(result + 4, nrm);
+		_drawVertices[v].set(result[0], result[1], result[2]);
+		_drawNormals[v].set(result[4], result[5], result[6]);
+#else
+		float px = 0.0f, py = 0.0f, pz = 0.0f, nx = 0.0f, ny = 0.0f, nz = 0.0f;
+		do {
+			const float *m = _skinMatrices + slots[i] * 16;
+			const float w = weights[i];
+			const float x = vert.x() * w, y = vert.y() * w, z = vert.z() * w;
+			const float a = normal.x() * w, b = normal.y() * w, c = normal.z() * w;
+			px += m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+			py += m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+			pz += m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+			nx += m[0] * a + m[4] * b + m[8] * c;
+			ny += m[1] * a + m[5] * b + m[9] * c;
+			nz += m[2] * a + m[6] * b + m[10] * c;
+		} while (++i < count && vertices[i] == v);
+
+		_drawVertices[v].set(px, py, pz);
+		_drawNormals[v].set(nx, ny, nz);
+#endif
+		_drawNormals[v].normalize();
+	}
+}
+
+void EMIModel::prepareForRender() {
+	if (!_skeleton || !_skinMatrices)
+		return;
+
+	// Actors which stand still keep their vertices, and their lighting
+	if (updateSkinningMatrices()) {
+		skinVertices();
+		_poseGeneration++;
+		g_driver->updateEMIModel(this);
+	}
 }
 
 void EMIModel::prepareTextures() {
@@ -275,11 +422,19 @@ void EMIModel::prepareTextures() {
 }
 
 void EMIModel::draw() {
-	prepareForRender();
-
 	Actor *actor = _costume->getOwner();
 	Math::Matrix4 modelToWorld = actor->getFinalMatrix();
 
+	if (!actor->isInOverworld() && _skinBoundsValid && _skeleton && _skinMatrices) {
+		// Skip skinning models which are outside of the view. getBoundingBox()
+		// skins them on demand.
+		Math::AABB bounds = calculateSkeletonBounds(modelToWorld);
+		if (bounds.isValid() && !g_grim->getCurrSet()->getFrustum().isInside(bounds))
+			return;
+	}
+
+	prepareForRender();
+
 	if (!actor->isInOverworld()) {
 		Math::AABB bounds = calculateWorldBounds(modelToWorld);
 		if (bounds.isValid() && !g_grim->getCurrSet()->getFrustum().isInside(bounds))
@@ -290,7 +445,7 @@ void EMIModel::draw() {
 		// If shaders are not available, we calculate lighting in software.
 		Actor::LightMode lightMode = actor->getLightMode();
 		if (lightMode != Actor::LightNone) {
-			if (lightMode != Actor::LightStatic)
+			if (lightMode != Actor::LightStatic && !isLightingValid(modelToWorld))
 				_lightingDirty = true;
 
 			if (_lightingDirty) {
@@ -305,10 +460,7 @@ void EMIModel::draw() {
 	}
 	// We will need to add a call to the skeleton, to get the modified vertices, but for now,
 	// I'll be happy with just static drawing
-	for (uint32 i = 0; i < _numFaces; i++) {
-		setTex(_faces[i]._texID);
-		g_driver->drawEMIModelFace(this, &_faces[i]);
-	}
+	g_driver->drawEMIModelFaces(this);
 
 	if (g_driver->supportsShaders() && actor->getLightMode() == Actor::LightNone) {
 		g_driver->enableLights();
@@ -324,71 +476,119 @@ void EMIModel::updateLighting(const Math::Matrix4 &modelToWorld) {
 	bool hasAmbient = false;
 
 	Actor *actor = _costume->getOwner();
-
-	foreach(Light *l, g_grim->getCurrSet()->getLights(actor->isInOverworld())) {
-		if (l->_enabled) {
-			activeLights.push_back(l);
-			if (l->_type == Light::Ambient)
-				hasAmbient = true;
+	Set *set = g_grim->getCurrSet();
+
+	// Lights which cannot reach the bounding sphere of the model are skipped
+	Math::AABB bounds = calculateWorldBounds(modelToWorld);
+	Math::Vector3d center = (bounds.getMin() + bounds.getMax()) * 0.5f;
+	float radius = (bounds.getMax() - bounds.getMin()).getMagnitude() * 0.5f;
+
+	foreach(Light *l, set->getLights(actor->isInOverworld())) {
+		if (!l->_enabled)
+			continue;
+		if (l->_type == Light::Ambient) {
+			hasAmbient = true;
+		} else if (l->_type != Light::Direct && bounds.isValid()) {
+			if (l->_pos.getDistanceTo(center) > l->_falloffFar + radius)
+				continue;
+			if (l->_type == Light::Spot && l->_dir.dotProduct(l->_pos - center) < -radius)
+				continue;
 		}
+		activeLights.push_back(l);
 	}
 
+	// Work on plain arrays of world space positions, normals and colors, one
+	// light after the other, so that the compiler can vectorize the loops
+	if (!_lightingScratch)
+		_lightingScratch = new float[_numVertices * 9];
+	float *px = _lightingScratch;
+	float *py = px + _numVertices;
+	float *pz = py + _numVertices;
+	float *nx = pz + _numVertices;
+	float *ny = nx + _numVertices;
+	float *nz = ny + _numVertices;
+	float *r = nz + _numVertices;
+	float *g = r + _numVertices;
+	float *b = g + _numVertices;
+
+	const Math::Matrix4 &m = modelToWorld;
 	for (int i = 0; i < _numVertices; i++) {
-		Math::Vector3d &result = _lighting[i];
-		result.set(0.0f, 0.0f, 0.0f);
-
-		Math::Vector3d normal = _drawNormals[i];
-		Math::Vector3d vertex = _drawVertices[i];
-		modelToWorld.transform(&vertex, true);
-		modelToWorld.transform(&normal, false);
-
-		for (uint j = 0; j < activeLights.size(); ++j) {
-			Light *l = activeLights[j];
-			float shade = l->_intensity;
-		
-			if (l->_type != Light::Ambient) {
-				// Direction of incident light
-				Math::Vector3d dir = l->_dir;
-
-				if (l->_type != Light::Direct) {
-					dir = l->_pos - vertex;
-					float distSq = dir.getSquareMagnitude();
-					if (distSq > l->_falloffFar * l->_falloffFar)
-						continue;
-
-					dir.normalize();
-
-					if (distSq > l->_falloffNear * l->_falloffNear) {
-						float dist = sqrt(distSq);
-						float attn = 1.0f - (dist - l->_falloffNear) / (l->_falloffFar - l->_falloffNear);
-						shade *= attn;
-					}
-				}
+		const Math::Vector3d &vertex = _drawVertices[i];
+		const Math::Vector3d &normal = _drawNormals[i];
+		px[i] = m(0, 0) * vertex.x() + m(0, 1) * vertex.y() + m(0, 2) * vertex.z() + m(0, 3);
+		py[i] = m(1, 0) * vertex.x() + m(1, 1) * vertex.y() + m(1, 2) * vertex.z() + m(1, 3);
+		pz[i] = m(2, 0) * vertex.x() + m(2, 1) * vertex.y() + m(2, 2) * vertex.z() + m(2, 3);
+		nx[i] = m(0, 0) * normal.x() + m(0, 1) * normal.y() + m(0, 2) * normal.z();
+		ny[i] = m(1, 0) * normal.x() + m(1, 1) * normal.y() + m(1, 2) * normal.z();
+		nz[i] = m(2, 0) * normal.x() + m(2, 1) * normal.y() + m(2, 2) * normal.z();
+		r[i] = g[i] = b[i] = 0.0f;
+	}
 
-				if (l->_type == Light::Spot) {
-					float cosAngle = l->_dir.dotProduct(dir);
-					if (cosAngle < 0.0f)
-						continue;
+	for (uint j = 0; j < activeLights.size(); ++j) {
+		const Light *l = activeLights[j];
+		const float intensity = l->_intensity;
+		const float cr = l->_color.getRed() / 255.0f;
+		const float cg = l->_color.getGreen() / 255.0f;
+		const float cb = l->_color.getBlue() / 255.0f;
+
+		if (l->_type == Light::Ambient) {
+			for (int i = 0; i < _numVertices; i++) {
+				r[i] += cr * intensity;
+				g[i] += cg * intensity;
+				b[i] += cb * intensity;
+			}
+			continue;
+		}
 
-					float angle = acos(cosAngle);
-					if (angle > l->_penumbraangle)
-						continue;
+		if (l->_type == Light::Direct) {
+			const float dx = l->_dir.x(), dy = l->_dir.y(), dz = l->_dir.z();
+			for (int i = 0; i < _numVertices; i++) {
+				const float shade = intensity * MAX(0.0f, nx[i] * dx + ny[i] * dy + nz[i] * dz);
+				r[i] += cr * shade;
+				g[i] += cg * shade;
+				b[i] += cb * shade;
+			}
+			continue;
+		}
 
-					if (angle > l->_umbraangle)
+		// Point and spot lights, with the incident direction from the vertex to the light
+		const float lx = l->_pos.x(), ly = l->_pos.y(), lz = l->_pos.z();
+		const float nearSq = l->_falloffNear * l->_falloffNear;
+		const float farSq = l->_falloffFar * l->_falloffFar;
+		const float falloff = l->_falloffFar > l->_falloffNear ? 1.0f / (l->_falloffFar - l->_falloffNear) : 0.0f;
+		const bool spot = l->_type == Light::Spot;
+		for (int i = 0; i < _numVertices; i++) {
+			const float dx = lx - px[i], dy = ly - py[i], dz = lz - pz[i];
+			const float distSq = dx * dx + dy * dy + dz * dz;
+			const float dist = sqrtf(distSq);
+			const float invDist = dist > 0.0f ? 1.0f / dist : 0.0f;
+			const float attn = distSq > nearSq ? 1.0f - (dist - l->_falloffNear) * falloff : 1.0f;
+			float shade = intensity * attn * MAX(0.0f, (nx[i] * dx + ny[i] * dy + nz[i] * dz) * invDist);
+
+			if (spot && shade != 0.0f) {
+				float cosAngle = (l->_dir.x() * dx + l->_dir.y() * dy + l->_dir.z() * dz) * invDist;
+				if (cosAngle < 0.0f) {
+					shade = 0.0f;
+				} else {
+					float angle = acos(MIN(cosAngle, 1.0f));
+					if (angle > l->_penumbraangle)
+						shade = 0.0f;
+					else if (angle > l->_umbraangle)
 						shade *= 1.0f - (angle - l->_umbraangle) / (l->_penumbraangle - l->_umbraangle);
 				}
-
-				float dot = MAX(0.0f, normal.dotProduct(dir));
-				shade *= dot;
 			}
 
-			Math::Vector3d color;
-			color.x() = l->_color.getRed() / 255.0f;
-			color.y() = l->_color.getGreen() / 255.0f;
-			color.z() = l->_color.getBlue() / 255.0f;
-
-			result += color * shade;
+			if (distSq > farSq)
+				shade = 0.0f;
+			r[i] += cr * shade;
+			g[i] += cg * shade;
+			b[i] += cb * shade;
 		}
+	}
+
+	for (int i = 0; i < _numVertices; i++) {
+		Math::Vector3d &result = _lighting[i];
+		result.set(r[i], g[i], b[i]);
 
 		if (!hasAmbient) {
 			// If the set does not specify an ambient light, a default ambient light is used
@@ -403,9 +603,25 @@ void EMIModel::updateLighting(const Math::Matrix4 &modelToWorld) {
 			result.z() = result.z() / max;
 		}
 	}
+
+	_lightingPose = _poseGeneration;
+	_lightingGeneration = set->getLightsGeneration();
+	_lightingOverworld = actor->isInOverworld();
+	_lightingMatrix = modelToWorld;
+}
+
+bool EMIModel::isLightingValid(const Math::Matrix4 &modelToWorld) const {
+	Actor *actor = _costume->getOwner();
+	return _lightingPose == _poseGeneration &&
+	       _lightingGeneration == g_grim->getCurrSet()->getLightsGeneration() &&
+	       _lightingOverworld == actor->isInOverworld() &&
+	       memcmp(_lightingMatrix.getData(), modelToWorld.getData(), 16 * sizeof(float)) == 0;
 }
 
-void EMIModel::getBoundingBox(int *x1, int *y1, int *x2, int *y2) const {
+void EMIModel::getBoundingBox(int *x1, int *y1, int *x2, int *y2) {
+	// draw() does not skin the vertices of a model outside of the view
+	prepareForRender();
+
 	int winX1, winY1, winX2, winY2;
 	g_driver->getScreenBoundingBox(this, &winX1, &winY1, &winX2, &winY2);
 	if (winX1 != -1 && winY1 != -1 && winX2 != -1 && winY2 != -1) {
@@ -425,6 +641,19 @@ Math::AABB EMIModel::calculateWorldBounds(const Math::Matrix4 &matrix) const {
 	return bounds;
 }
 
+Math::AABB EMIModel::calculateSkeletonBounds(const Math::Matrix4 &matrix) const {
+	Math::AABB bounds;
+	for (int slot = 0; slot < _numSkinSlots; slot++) {
+		const Math::Vector3d pos = _skeleton->_joints[_skinJoints[slot]]._finalMatrix.getPosition();
+		// Leave some room for rounding errors of the joint matrices
+		const float radius = _skinJointRadii[slot] * 1.01f;
+		bounds.expand(pos - Math::Vector3d(radius, radius, radius));
+		bounds.expand(pos + Math::Vector3d(radius, radius, radius));
+	}
+	bounds.transform(matrix);
+	return bounds;
+}
+
 EMIModel::EMIModel(const Common::String &filename, Common::SeekableReadStream *data, EMICostume *costume) :
 		_fname(filename), _costume(costume) {
 	_meshAlphaMode = Actor::AlphaOff;
@@ -444,7 +673,17 @@ EMIModel::EMIModel(const Common::String &filename, Common::SeekableReadStream *d
 	_numBones = 0;
 	_boneInfos = nullptr;
 	_numBoneInfos = 0;
-	_vertexBoneInfo = nullptr;
+	_numSkinInfluences = 0;
+	_skinVertices = nullptr;
+	_skinSlots = nullptr;
+	_skinWeights = nullptr;
+	_numSkinSlots = 0;
+	_skinJoints = nullptr;
+	_skinJointRadii = nullptr;
+	_skinMatrices = nullptr;
+	_skinBoundsValid = false;
+	_skinDirty = true;
+	_poseGeneration = 0;
 	_skeleton = nullptr;
 	_radius = 0;
 	_center = new Math::Vector3d();
@@ -455,6 +694,10 @@ EMIModel::EMIModel(const Common::String &filename, Common::SeekableReadStream *d
 	_boneNames = nullptr;
 	_lighting = nullptr;
 	_lightingDirty = true;
+	_lightingPose = 0;
+	_lightingGeneration = 0;
+	_lightingOverworld = false;
+	_lightingScratch = nullptr;
 	_texFlags = nullptr;
 
 	loadMesh(data);
@@ -474,9 +717,15 @@ EMIModel::~EMIModel() {
 	delete[] _texNames;
 	delete[] _mats;
 	delete[] _boneInfos;
-	delete[] _vertexBoneInfo;
+	delete[] _skinVertices;
+	delete[] _skinSlots;
+	delete[] _skinWeights;
+	delete[] _skinJoints;
+	delete[] _skinJointRadii;
+	delete[] _skinMatrices;
 	delete[] _boneNames;
 	delete[] _lighting;
+	delete[] _lightingScratch;
 	delete[] _texFlags;
 	delete _center;
 	delete _boxData;
@@ -55,7 +55,6 @@ class Skeleton;
 class EMIMeshFace {
 public:
 	Vector3int *_indexes;
-	uint32 _indicesEBO;
 	uint32 _faceLength;
 	uint32 _numFaces;
 	uint32 _hasTexture;
@@ -69,7 +68,7 @@ public:
 		kUnknownBlend = 0x40000 // used only in intro screen actors
 	};
 
-	EMIMeshFace() : _faceLength(0), _numFaces(0), _hasTexture(0), _texID(0), _flags(0), _indexes(NULL), _parent(NULL), _indicesEBO(0) { }
+	EMIMeshFace() : _faceLength(0), _numFaces(0), _hasTexture(0), _texID(0), _flags(0), _indexes(NULL), _parent(NULL) { }
 	~EMIMeshFace();
 	void loadFace(Common::SeekableReadStream *data);
 	void setParent(EMIModel *m) { _parent = m; }
@@ -113,7 +112,21 @@ public:
 	int _numBoneInfos;
 	BoneInfo *_boneInfos;
 	Common::String *_boneNames;
-	int *_vertexBoneInfo;
+
+	// Skinning data, built by setSkeleton(). The influences are stored in
+	// parallel arrays, sorted by vertex, and refer to the joints this model
+	// uses through a compact list of joint slots.
+	int _numSkinInfluences;
+	int *_skinVertices;
+	int *_skinSlots;
+	float *_skinWeights;
+	int _numSkinSlots;
+	int *_skinJoints;        // Skeleton joint of each slot
+	float *_skinJointRadii;  // Farthest bind pose vertex from each joint
+	float *_skinMatrices;    // 16 floats per slot, stored column by column
+	bool _skinBoundsValid;   // The joint spheres contain the skinned mesh
+	bool _skinDirty;         // The skinning matrices have to be recalculated
+	uint32 _poseGeneration;  // Changes whenever the skinned vertices do
 
 	// Stuff we dont know how to use:
 	float _radius;
@@ -129,6 +142,13 @@ public:
 	void *_userData;
 	bool _lightingDirty;
 
+	// The state the software lighting was calculated for
+	uint32 _lightingPose;
+	uint32 _lightingGeneration;
+	bool _lightingOverworld;
+	Math::Matrix4 _lightingMatrix;
+	float *_lightingScratch;
+
 public:
 	EMIModel(const Common::String &filename, Common::SeekableReadStream *data, EMICostume *costume);
 	~EMIModel();
@@ -136,11 +156,16 @@ public:
 	void setSkeleton(Skeleton *skel);
 	void loadMesh(Common::SeekableReadStream *data);
 	void prepareForRender();
+	void updateSkinning();
+	bool updateSkinningMatrices();
+	void skinVertices();
 	void prepareTextures();
 	void draw();
 	void updateLighting(const Math::Matrix4 &modelToWorld);
-	void getBoundingBox(int *x1, int *y1, int *x2, int *y2) const;
+	bool isLightingValid(const Math::Matrix4 &modelToWorld) const;
+	void getBoundingBox(int *x1, int *y1, int *x2, int *y2);
 	Math::AABB calculateWorldBounds(const Math::Matrix4 &matrix) const;
+	Math::AABB calculateSkeletonBounds(const Math::Matrix4 &matrix) const;
 };
 
 } // end of namespace Grim
@@ -42,6 +42,7 @@
 #include "engines/grim/grim.h"
 
 #include "engines/grim/model.h"
+#include "engines/grim/emi/modelemi.h"
 
 namespace Grim {
 
@@ -109,6 +110,13 @@ void GfxBase::drawMesh(const Mesh *mesh) {
 		mesh->_faces[i].draw(mesh);
 }
 
+void GfxBase::drawEMIModelFaces(EMIModel *model) {
+	for (uint32 i = 0; i < model->_numFaces; i++) {
+		model->setTex(model->_faces[i]._texID);
+		drawEMIModelFace(model, &model->_faces[i]);
+	}
+}
+
 #ifndef USE_OPENGL
 // Allow CreateGfxOpenGL to be called even if OpenGL isn't included
 GfxBase *CreateGfxOpenGL() {
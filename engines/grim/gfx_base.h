@@ -139,6 +139,8 @@ public:
 	virtual void translateViewpointFinish() = 0;
 
 	virtual void drawEMIModelFace(const EMIModel *model, const EMIMeshFace *face) = 0;
+	/** Draws all the faces of the model in order, selecting their textures. */
+	virtual void drawEMIModelFaces(EMIModel *model);
 	virtual void drawModelFace(const Mesh *mesh, const MeshFace *face) = 0;
 	virtual void drawSprite(const Sprite *sprite) = 0;
 	virtual void drawMesh(const Mesh *mesh);
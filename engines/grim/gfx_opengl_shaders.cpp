@@ -121,12 +121,23 @@ struct FontUserData {
 	GLuint texture;
 };
 
+// A run of consecutive faces of an EMI model which need the same state,
+// so that they can be drawn with a single call.
+struct EMIFaceBatch {
+	uint32 _firstFace;
+	uint32 _numIndices;
+};
+
 struct EMIModelUserData {
 	OpenGL::Shader *_shader;
 	uint32 _texCoordsVBO;
 	uint32 _colorMapVBO;
 	uint32 _verticesVBO;
 	uint32 _normalsVBO;
+	// The indices of all the faces, one after the other
+	uint32 _indicesEBO;
+	Common::Array<uint32> _faceOffsets;
+	Common::Array<EMIFaceBatch> _batches;
 };
 
 struct ModelUserData {
@@ -381,6 +392,11 @@ void GfxOpenGLS::setupShaders() {
 
 	static const char* actorAttributes[] = {"position", "texcoord", "color", "normal", NULL};
 	_actorProgram = OpenGL::Shader::fromFiles(isEMI ? "emi_actor" : "grim_actor", actorAttributes);
+	_texturedUniform = _actorProgram->getUniformHandle("textured");
+	_lightsEnabledUniform = _actorProgram->getUniformHandle("lightsEnabled");
+	_swapRandBUniform = _actorProgram->getUniformHandle("swapRandB");
+	_useVertexAlphaUniform = _actorProgram->getUniformHandle("useVertexAlpha");
+	_meshAlphaUniform = _actorProgram->getUniformHandle("meshAlpha");
 	_spriteProgram = OpenGL::Shader::fromFiles(isEMI ? "emi_actor" : "grim_actor", actorAttributes);
 
 	static const char* primAttributes[] = { "position", NULL };
@@ -520,6 +536,7 @@ void GfxOpenGLS::clearDepthBuffer() {
 
 void GfxOpenGLS::flipBuffer() {
 	g_system->updateScreen();
+	OpenGL::Shader::endFrame();
 }
 
 void GfxOpenGLS::getScreenBoundingBox(const Mesh *mesh, int *x1, int *y1, int *x2, int *y2) {
@@ -955,22 +972,43 @@ void GfxOpenGLS::updateEMIModel(const EMIModel* model) {
 }
 
 void GfxOpenGLS::drawEMIModelFace(const EMIModel* model, const EMIMeshFace* face) {
+	const EMIModelUserData *mud = (const EMIModelUserData *)model->_userData;
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mud->_indicesEBO);
+	drawEMIModelIndices(model, face, mud->_faceOffsets[face - model->_faces], 3 * face->_faceLength);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void GfxOpenGLS::drawEMIModelFaces(EMIModel *model) {
+	// This only batches, it is not a render queue: the faces are still drawn
+	// in their order, without sorting by state or sorting the transparent ones
+	// back to front, as the blending depends on the order. Each run of faces
+	// with the same texture and flags only needs the state to be set up once
+	// and a single draw call.
+	const EMIModelUserData *mud = (const EMIModelUserData *)model->_userData;
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mud->_indicesEBO);
+	for (uint32 i = 0; i < mud->_batches.size(); ++i) {
+		const EMIFaceBatch &batch = mud->_batches[i];
+		const EMIMeshFace *face = &model->_faces[batch._firstFace];
+		model->setTex(face->_texID);
+		drawEMIModelIndices(model, face, mud->_faceOffsets[batch._firstFace], batch._numIndices);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void GfxOpenGLS::drawEMIModelIndices(const EMIModel *model, const EMIMeshFace *face, uint32 offset, uint32 numIndices) {
 	if (face->_flags & EMIMeshFace::kAlphaBlend ||
 	    face->_flags & EMIMeshFace::kUnknownBlend)
 		glEnable(GL_BLEND);
 	const EMIModelUserData *mud = (const EMIModelUserData *)model->_userData;
 	mud->_shader->use();
 	bool textured = face->_hasTexture && !_currentShadowArray;
-	mud->_shader->setUniform("textured", textured ? GL_TRUE : GL_FALSE);
-	mud->_shader->setUniform("lightsEnabled", (face->_flags & EMIMeshFace::kNoLighting) ? false : _lightsEnabled);
-	mud->_shader->setUniform("swapRandB", _selectedTexture->_colorFormat == BM_BGRA || _selectedTexture->_colorFormat == BM_BGR888);
-	mud->_shader->setUniform("useVertexAlpha", _selectedTexture->_colorFormat == BM_BGRA);
-	mud->_shader->setUniform1f("meshAlpha", (model->_meshAlphaMode == Actor::AlphaReplace) ? model->_meshAlpha : 1.0f);
+	mud->_shader->setUniform(_texturedUniform, textured ? GL_TRUE : GL_FALSE);
+	mud->_shader->setUniform(_lightsEnabledUniform, (face->_flags & EMIMeshFace::kNoLighting) ? false : _lightsEnabled);
+	mud->_shader->setUniform(_swapRandBUniform, _selectedTexture->_colorFormat == BM_BGRA || _selectedTexture->_colorFormat == BM_BGR888);
+	mud->_shader->setUniform(_useVertexAlphaUniform, _selectedTexture->_colorFormat == BM_BGRA);
+	mud->_shader->setUniform1f(_meshAlphaUniform, (model->_meshAlphaMode == Actor::AlphaReplace) ? model->_meshAlpha : 1.0f);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, face->_indicesEBO);
-
-	glDrawElements(GL_TRIANGLES, 3 * face->_faceLength, GL_UNSIGNED_INT, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, (const GLvoid *)(uintptr)offset);
 }
 
 void GfxOpenGLS::drawMesh(const Mesh *mesh) {
@@ -2022,24 +2060,45 @@ void GfxOpenGLS::createEMIModel(EMIModel *model) {
 	actorShader->enableVertexAttribute("color", mud->_colorMapVBO, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4 * sizeof(byte), 0);
 	mud->_shader = actorShader;
 
+	uint32 numIndices = 0;
+	mud->_faceOffsets.resize(model->_numFaces);
 	for (uint32 i = 0; i < model->_numFaces; ++i) {
-		EMIMeshFace * face = &model->_faces[i];
-		face->_indicesEBO = OpenGL::Shader::createBuffer(GL_ELEMENT_ARRAY_BUFFER, face->_faceLength * 3 * sizeof(uint32), face->_indexes, GL_STATIC_DRAW);
+		mud->_faceOffsets[i] = numIndices * sizeof(uint32);
+		numIndices += 3 * model->_faces[i]._faceLength;
 	}
 
+	uint32 *indices = new uint32[numIndices];
+	for (uint32 i = 0; i < model->_numFaces; ++i) {
+		const EMIMeshFace *face = &model->_faces[i];
+		memcpy((byte *)indices + mud->_faceOffsets[i], face->_indexes, face->_faceLength * 3 * sizeof(uint32));
+
+		// Faces which select the same texture and set the same state as the
+		// one before them are appended to its batch.
+		if (!mud->_batches.empty()) {
+			EMIFaceBatch &batch = mud->_batches.back();
+			const EMIMeshFace *first = &model->_faces[batch._firstFace];
+			if (face->_texID == first->_texID && face->_hasTexture == first->_hasTexture && face->_flags == first->_flags) {
+				batch._numIndices += 3 * face->_faceLength;
+				continue;
+			}
+		}
+
+		EMIFaceBatch batch;
+		batch._firstFace = i;
+		batch._numIndices = 3 * face->_faceLength;
+		mud->_batches.push_back(batch);
+	}
+	mud->_indicesEBO = OpenGL::Shader::createBuffer(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(uint32), indices, GL_STATIC_DRAW);
+	delete[] indices;
+
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void GfxOpenGLS::destroyEMIModel(EMIModel *model) {
-	for (uint32 i = 0; i < model->_numFaces; ++i) {
-		EMIMeshFace *face = &model->_faces[i];
-		OpenGL::Shader::freeBuffer(face->_indicesEBO);
-		face->_indicesEBO = 0;
-	}
-
 	EMIModelUserData *mud = static_cast<EMIModelUserData *>(model->_userData);
 
 	if (mud) {
+		OpenGL::Shader::freeBuffer(mud->_indicesEBO);
 		OpenGL::Shader::freeBuffer(mud->_verticesVBO);
 		OpenGL::Shader::freeBuffer(mud->_normalsVBO);
 		OpenGL::Shader::freeBuffer(mud->_texCoordsVBO);
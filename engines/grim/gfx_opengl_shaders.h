@@ -91,6 +91,7 @@ public:
 	virtual void translateViewpointFinish() override;
 
 	virtual void drawEMIModelFace(const EMIModel* model, const EMIMeshFace* face) override;
+	virtual void drawEMIModelFaces(EMIModel *model) override;
 	virtual void drawModelFace(const Mesh *mesh, const MeshFace *face) override;
 	virtual void drawSprite(const Sprite *sprite) override;
 	virtual void drawMesh(const Mesh *mesh) override;
@@ -218,6 +219,8 @@ protected:
 	void createSpecialtyTextureFromScreen(uint id, uint8 *data, int x, int y, int width, int height) override;
 
 private:
+	void drawEMIModelIndices(const EMIModel *model, const EMIMeshFace *face, uint32 offset, uint32 numIndices);
+
 	const Actor *_currentActor;
 	float _alpha;
 	int _maxLights;
@@ -226,6 +229,12 @@ private:
 
 	OpenGL::Shader* _backgroundProgram;
 	OpenGL::Shader* _actorProgram;
+	// Uniforms of _actorProgram which are set for every face of EMI models
+	OpenGL::Shader::UniformHandle _texturedUniform;
+	OpenGL::Shader::UniformHandle _lightsEnabledUniform;
+	OpenGL::Shader::UniformHandle _swapRandBUniform;
+	OpenGL::Shader::UniformHandle _useVertexAlphaUniform;
+	OpenGL::Shader::UniformHandle _meshAlphaUniform;
 	OpenGL::Shader* _spriteProgram;
 	OpenGL::Shader* _dimProgram;
 	OpenGL::Shader* _dimPlaneProgram;
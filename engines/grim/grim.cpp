@@ -105,6 +105,7 @@ GrimEngine::GrimEngine(OSystem *syst, uint32 gameFlags, GrimGameType gameType, C
 
 	//Set default settings
 	ConfMan.registerDefault("use_arb_shaders", true);
+	ConfMan.registerDefault("cache_text_resources", true);
 
 	_showFps = ConfMan.getBool("show_fps");
 
@@ -181,6 +182,8 @@ GrimEngine::GrimEngine(OSystem *syst, uint32 gameFlags, GrimGameType gameType, C
 }
 
 GrimEngine::~GrimEngine() {
+	SaveGame::waitForPendingWrites();
+
 	delete[] _controlsEnabled;
 	delete[] _controlsState;
 	delete[] _joyAxisPosition;
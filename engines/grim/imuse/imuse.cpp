@@ -51,6 +51,7 @@ void Imuse::timerHandler(void *refCon) {
 Imuse::Imuse(int fps, bool demo) {
 	_demo = demo;
 	_pause = false;
+	_underruns = 0;
 	_sound = new ImuseSndMgr(_demo);
 	assert(_sound);
 	_callbackFps = fps;
@@ -217,7 +218,14 @@ void Imuse::callback() {
 			if (_pause)
 				return;
 
-			if (track->volFadeUsed) {
+			// A cloned fade out track starts with silence, which has to play
+			// before it fades
+			if (track->volFadeUsed && track->volFadeStartSize > 0) {
+				if (track->queuedSize - getQueuedAheadSize(track) >= track->volFadeStartSize)
+					track->volFadeStartSize = 0;
+			}
+
+			if (track->volFadeUsed && track->volFadeStartSize == 0) {
 				if (track->volFadeStep < 0) {
 					if (track->vol > track->volFadeDest) {
 						track->vol += track->volFadeStep;
@@ -277,8 +285,21 @@ void Imuse::callback() {
 			int channels = _sound->getChannels(track->soundDesc);
 			int32 mixer_size = track->feedSize / _callbackFps;
 
-			if (track->stream->endOfData()) {
-				mixer_size *= 2;
+			// Keep the stream filled IMUSE_DECODE_AHEAD ms ahead of the mixer,
+			// so a late callback (e.g. while switching regions in a heavy
+			// frame) does not make the audio stutter.
+			if (g_system->getMixer()->isReady()) {
+				int32 aheadSize = track->feedSize * IMUSE_DECODE_AHEAD / 1000;
+				if (track->stream->endOfData()) {
+					if (track->queuedSize > 0) {
+						track->underruns++;
+						_underruns++;
+						Debug::debug(Debug::Sound, "Imuse::callback(): underrun: soundName:%s", track->soundName);
+					}
+					mixer_size = aheadSize;
+				} else {
+					mixer_size = CLIP<int32>(aheadSize - getQueuedAheadSize(track), 0, aheadSize);
+				}
 			}
 
 			if (channels == 1)
@@ -304,6 +325,7 @@ void Imuse::callback() {
 				if (g_system->getMixer()->isReady()) {
 					track->stream->queueBuffer(data, result, DisposeAfterUse::YES, makeMixerFlags(track->mixerFlags));
 					track->regionOffset += result;
+					track->queuedSize += result;
 				} else
 					delete[] data;
 
@@ -323,6 +345,29 @@ void Imuse::callback() {
 	}
 }
 
+int32 Imuse::getQueuedAheadSize(Track *track) {
+	if (!track->stream)
+		return 0;
+	uint64 played = (uint64)g_system->getMixer()->getSoundElapsedTime(track->handle) * track->feedSize / 1000;
+	int32 ahead = (int32)(track->queuedSize - (uint32)played);
+	// Rounding and the granularity of the elapsed time may make this negative
+	return MAX<int32>(ahead, 0) & ~3;
+}
+
+Common::String Imuse::getTrackStatus() {
+	Common::StackLock lock(_mutex);
+
+	Common::String status;
+	for (int l = 0; l < MAX_IMUSE_TRACKS + MAX_IMUSE_FADETRACKS; l++) {
+		Track *track = _track[l];
+		if (!track->used || !track->stream || !track->feedSize)
+			continue;
+		status += Common::String::format("%2d %-32s region %3d, %4d ms ahead, %d underruns\n", l, track->soundName,
+		                                 track->curRegion, getQueuedAheadSize(track) * 1000 / track->feedSize, track->underruns);
+	}
+	return status;
+}
+
 void Imuse::switchToNextRegion(Track *track) {
 	assert(track);
 
@@ -31,6 +31,8 @@ namespace Grim {
 
 #define MAX_IMUSE_TRACKS 16
 #define MAX_IMUSE_FADETRACKS 16
+// How far ahead of the mixer the tracks are decoded, in milliseconds
+#define IMUSE_DECODE_AHEAD 100
 
 struct ImuseTable;
 class SaveGame;
@@ -47,6 +49,7 @@ private:
 
 	bool _pause;
 	bool _demo;
+	uint32 _underruns;
 
 	int32 _attributes[185];
 	int32 _curMusicState;
@@ -70,6 +73,7 @@ private:
 	void playMusic(const ImuseTable *table, int atribPos, bool sequence);
 
 	void flushTrack(Track *track);
+	int32 getQueuedAheadSize(Track *track);
 
 public:
 	Imuse(int fps, bool demo);
@@ -107,6 +111,11 @@ public:
 	int getCurMusicVol();
 	bool getSoundStatus(const char *soundName);
 	int32 getPosIn16msTicks(const char *soundName);
+
+	/** Return how often any track ran out of decoded data so far. */
+	uint32 getUnderrunCount() const { return _underruns; }
+	/** Describe the playing tracks, for the debugger. */
+	Common::String getTrackStatus();
 };
 
 extern Imuse *g_imuse;
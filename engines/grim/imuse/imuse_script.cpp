@@ -106,7 +106,9 @@ int32 Imuse::getPosIn16msTicks(const char *soundName) {
 		return false;
 	}
 
-	int32 pos = (62.5 / 60.0) * (5 * (getTrack->dataOffset + getTrack->regionOffset)) / (getTrack->feedSize / 12); // 16ms is 62.5 Hz
+	// The track is decoded ahead of what is audible
+	int32 offset = MAX<int32>(getTrack->dataOffset + getTrack->regionOffset - getQueuedAheadSize(getTrack), 0);
+	int32 pos = (62.5 / 60.0) * (5 * offset) / (getTrack->feedSize / 12); // 16ms is 62.5 Hz
 	return pos;
 }
 
@@ -396,9 +396,23 @@ Track *Imuse::cloneToFadeOutTrack(Track *track, int fadeDelay) {
 	fadeTrack->volFadeDest = 0;
 	fadeTrack->volFadeStep = (fadeTrack->volFadeDest - fadeTrack->vol) * 60 * (1000 / _callbackFps) / (1000 * fadeDelay);
 	fadeTrack->volFadeUsed = true;
+	fadeTrack->volFadeStartSize = 0;
 
 	// Create an appendable output buffer
 	fadeTrack->stream = Audio::makeQueuingAudioStream(_sound->getFreq(fadeTrack->soundDesc), track->mixerFlags & kFlagStereo);
+	fadeTrack->queuedSize = 0;
+	fadeTrack->underruns = 0;
+
+	// The track itself still has decoded data of the old region queued, so
+	// delay the sound and its fade out until that played
+	int32 aheadSize = getQueuedAheadSize(track);
+	if (aheadSize > 0) {
+		byte *silence = (byte *)calloc(aheadSize, 1);
+		fadeTrack->stream->queueBuffer(silence, aheadSize, DisposeAfterUse::YES, makeMixerFlags(fadeTrack->mixerFlags));
+		fadeTrack->queuedSize = aheadSize;
+		fadeTrack->volFadeStartSize = aheadSize;
+	}
+
 	g_system->getMixer()->playStream(track->getType(), &fadeTrack->handle, fadeTrack->stream, -1, fadeTrack->getVol(),
 											fadeTrack->getPan(), DisposeAfterUse::YES, false,
 											(track->mixerFlags & kFlagReverseStereo) != 0);
@@ -453,6 +467,7 @@ Track *Imuse::moveToFadeOutTrack(Track *track, int fadeDelay) {
 	fadeTrack->volFadeDest = 0;
 	fadeTrack->volFadeStep = (fadeTrack->volFadeDest - fadeTrack->vol) * 60 * (1000 / _callbackFps) / (1000 * fadeDelay);
 	fadeTrack->volFadeUsed = true;
+	fadeTrack->volFadeStartSize = 0;
 
 	fadeTrack->used = true;
 
@@ -48,6 +48,7 @@ struct Track {
 	int32 volFadeStep;
 	int32 volFadeDelay;
 	bool volFadeUsed;
+	uint32 volFadeStartSize;	// bytes to play before the volume fade starts
 
 	char soundName[32];
 	bool used;
@@ -60,6 +61,8 @@ struct Track {
 	int32 volGroupId;
 	int32 feedSize;
 	int32 mixerFlags;
+	uint32 queuedSize;	// bytes queued into the stream so far
+	int32 underruns;	// how often the stream ran dry
 
 	ImuseSndMgr::SoundDesc *soundDesc;
 	Audio::SoundHandle handle;
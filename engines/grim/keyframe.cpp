@@ -38,7 +38,7 @@ KeyframeAnim::KeyframeAnim(const Common::String &fname, Common::SeekableReadStre
 		loadBinary(data);
 	else {
 		data->seek(0, SEEK_SET);
-		TextSplitter ts(fname, data);
+		TextSplitter ts(fname, data, true);
 		loadText(ts);
 	}
 }
@@ -158,17 +158,12 @@ KeyframeAnim::~KeyframeAnim() {
 	g_resourceloader->uncacheKeyframe(this);
 }
 
-bool KeyframeAnim::isNodeAnimated(ModelNode *nodes, int num, float time, bool tagged) const {
+bool KeyframeAnim::isNodeAnimated(ModelNode *nodes, int num, bool tagged) const {
 	// Without this sending the bread down the tube in "mo" often crashes,
 	// because it goes outside the bounds of the array of the nodes.
 	if (num >= _numJoints)
 		return false;
 
-	float frame = time * _fps;
-
-	if (frame > _numFrames)
-		frame = _numFrames;
-
 	if (_nodes[num] && tagged == ((_type & nodes[num]._type) != 0)) {
 		return _nodes[num]->_numEntries != 0;
 	} else {
@@ -176,7 +171,7 @@ bool KeyframeAnim::isNodeAnimated(ModelNode *nodes, int num, float time, bool ta
 	}
 }
 
-void KeyframeAnim::animate(ModelNode *nodes, int num, float time, float fade, bool tagged) const {
+void KeyframeAnim::animate(ModelNode *nodes, int num, float time, float fade, bool tagged, int &cursor) const {
 	// Without this sending the bread down the tube in "mo" often crashes,
 	// because it goes outside the bounds of the array of the nodes.
 	if (num >= _numJoints)
@@ -188,7 +183,7 @@ void KeyframeAnim::animate(ModelNode *nodes, int num, float time, float fade, bo
 		frame = _numFrames;
 
 	if (_nodes[num] && tagged == ((_type & nodes[num]._type) != 0)) {
-		_nodes[num]->animate(nodes[num], frame, fade, (_flags & 256) == 0);
+		_nodes[num]->animate(nodes[num], frame, fade, (_flags & 256) == 0, cursor);
 	}
 }
 
@@ -230,6 +225,7 @@ void KeyframeAnim::KeyframeNode::loadBinary(Common::SeekableReadStream *data, ch
 	for (int i = 0; i < _numEntries; i++) {
 		_entries[i].loadBinary(data);
 	}
+	checkSorted();
 }
 
 void KeyframeAnim::KeyframeNode::loadText(TextSplitter &ts) {
@@ -253,15 +249,35 @@ void KeyframeAnim::KeyframeNode::loadText(TextSplitter &ts) {
 		_entries[which]._dyaw = dyaw;
 		_entries[which]._droll = dr;
 	}
+	checkSorted();
+}
+
+void KeyframeAnim::KeyframeNode::checkSorted() {
+	_sorted = true;
+	for (int i = 1; i < _numEntries; i++) {
+		if (_entries[i]._frame < _entries[i - 1]._frame) {
+			_sorted = false;
+			break;
+		}
+	}
 }
 
 KeyframeAnim::KeyframeNode::~KeyframeNode() {
 	delete[] _entries;
 }
 
-void KeyframeAnim::KeyframeNode::animate(ModelNode &node, float frame, float fade, bool useDelta) const {
-	if (_numEntries == 0)
-		return;
+int KeyframeAnim::KeyframeNode::findEntry(float frame, int &cursor) const {
+	// While an animation plays the time only moves forward, so the entry used
+	// the last time is usually still the right one or just a few steps behind.
+	// The cursor is only trusted if it is not past the frame, which catches
+	// animations being restarted or looping.
+	if (_sorted && cursor >= 0 && cursor < _numEntries && (cursor == 0 || _entries[cursor]._frame <= frame)) {
+		for (int steps = 0; steps < 4; steps++) {
+			if (cursor + 1 >= _numEntries || _entries[cursor + 1]._frame > frame)
+				return cursor;
+			cursor++;
+		}
+	}
 
 	// Do a binary search for the nearest previous frame
 	// Loop invariant: entries_[low].frame_ <= frame < entries_[high].frame_
@@ -274,6 +290,16 @@ void KeyframeAnim::KeyframeNode::animate(ModelNode &node, float frame, float fad
 			high = mid;
 	}
 
+	cursor = low;
+	return low;
+}
+
+void KeyframeAnim::KeyframeNode::animate(ModelNode &node, float frame, float fade, bool useDelta, int &cursor) const {
+	if (_numEntries == 0)
+		return;
+
+	int low = findEntry(frame, cursor);
+
 	float dt = frame - _entries[low]._frame;
 	Math::Vector3d pos = _entries[low]._pos;
 	Math::Angle pitch = _entries[low]._pitch;
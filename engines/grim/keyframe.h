@@ -43,8 +43,17 @@ public:
 
 	void loadBinary(Common::SeekableReadStream *data);
 	void loadText(TextSplitter &ts);
-	bool isNodeAnimated(ModelNode *nodes, int num, float time, bool tagged) const;
-	void animate(ModelNode *nodes, int num, float time, float fade, bool tagged) const;
+	/**
+	 * Whether this animation moves the given node. This doesn't depend on the time,
+	 * so the result can be cached for as long as the hierarchy stays the same.
+	 */
+	bool isNodeAnimated(ModelNode *nodes, int num, bool tagged) const;
+	/**
+	 * Apply the animation to the given node. The cursor holds the keyframe entry used
+	 * the last time, which makes finding the next one cheap while time moves forward.
+	 * It should start out as 0 and be kept by the caller for each node.
+	 */
+	void animate(ModelNode *nodes, int num, float time, float fade, bool tagged, int &cursor) const;
 	int getMarker(float startTime, float stopTime) const;
 
 	float getLength() const { return _numFrames / _fps; }
@@ -84,11 +93,15 @@ private:
 		void loadText(TextSplitter &ts);
 		~KeyframeNode();
 
-		void animate(ModelNode &node, float frame, float fade, bool useDelta) const;
+		void animate(ModelNode &node, float frame, float fade, bool useDelta, int &cursor) const;
+		int findEntry(float frame, int &cursor) const;
+		void checkSorted();
 
 		char _meshName[32];
 		int _numEntries;
 		KeyframeEntry *_entries;
+		/** Whether the entries are in frame order, so that the cursor can be trusted. */
+		bool _sorted;
 	};
 
 	KeyframeNode **_nodes;
@@ -30,8 +30,7 @@
 namespace Grim {
 
 LabEntry::LabEntry(const Common::String &name, uint32 offset, uint32 len, Lab *parent) :
-		_offset(offset), _len(len), _parent(parent), _name(name) {
-	_name.toLowercase();
+		_offset(offset), _len(len), _parent(parent), _name(Common::InternedString(name).toLowercase()) {
 }
 
 Common::SeekableReadStream *LabEntry::createReadStream() const {
@@ -97,7 +96,7 @@ void Lab::parseGrimFileTable(Common::File *file) {
 			error("File \"%s\" past the end of lab \"%s\". Your game files may be corrupt.", fname.c_str(), _labFileName.c_str());
 
 		LabEntry *entry = new LabEntry(fname, start, size, this);
-		_entries[fname] = LabEntryPtr(entry);
+		_entries[entry->_name] = LabEntryPtr(entry);
 	}
 
 	delete[] stringTable;
@@ -140,16 +139,29 @@ void Lab::parseMonkey4FileTable(Common::File *file) {
 			error("File \"%s\" past the end of lab \"%s\". Your game files may be corrupt.", fname.c_str(), _labFileName.c_str());
 
 		LabEntry *entry = new LabEntry(fname, start, size, this);
-		_entries[fname] = LabEntryPtr(entry);
+		_entries[entry->_name] = LabEntryPtr(entry);
 	}
 
 	delete[] stringTable;
 }
 
+bool Lab::findEntry(const Common::String &filename, LabMap::const_iterator &entry) const {
+	// All member names were interned in lowercase when the directory was
+	// read, so a name which is not in the pool in any case can't be one of
+	// them. Looking it up doesn't add it to the pool, which would keep every
+	// name probed in any of the archives around forever.
+	Common::InternedString name;
+	if (!Common::InternedString::find(filename, name, true))
+		return false;
+
+	// The map ignores case already, no need to lowercase the name first
+	entry = _entries.find(name);
+	return entry != _entries.end();
+}
+
 bool Lab::hasFile(const Common::String &filename) const {
-	Common::String fname(filename);
-	fname.toLowercase();
-	return _entries.contains(fname);
+	LabMap::const_iterator entry;
+	return findEntry(filename, entry);
 }
 
 int Lab::listMembers(Common::ArchiveMemberList &list) const {
@@ -164,21 +176,19 @@ int Lab::listMembers(Common::ArchiveMemberList &list) const {
 }
 
 const Common::ArchiveMemberPtr Lab::getMember(const Common::String &name) const {
-	if (!hasFile(name))
+	LabMap::const_iterator i;
+	if (!findEntry(name, i))
 		return Common::ArchiveMemberPtr();
 
-	Common::String fname(name);
-	fname.toLowercase();
-	return _entries[fname];
+	return i->_value;
 }
 
 Common::SeekableReadStream *Lab::createReadStreamForMember(const Common::String &filename) const {
-	if (!hasFile(filename))
+	LabMap::const_iterator entry;
+	if (!findEntry(filename, entry))
 		return nullptr;
 
-	Common::String fname(filename);
-	fname.toLowercase();
-	LabEntryPtr i = _entries[fname];
+	LabEntryPtr i = entry->_value;
 
 	if (!_stream) {
 		Common::File *file = new Common::File();
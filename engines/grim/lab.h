@@ -24,6 +24,8 @@
 #define GRIM_LAB_H
 
 #include "common/archive.h"
+#include "common/flathashmap.h"
+#include "common/str-intern.h"
 
 namespace Common {
 	class File;
@@ -35,7 +37,7 @@ class Lab;
 
 class LabEntry : public Common::ArchiveMember {
 	Lab *_parent;
-	Common::String _name;
+	Common::InternedString _name;
 	uint32 _offset, _len;
 public:
 	LabEntry(const Common::String &name, uint32 offset, uint32 len, Lab *parent);
@@ -61,9 +63,13 @@ private:
 
 	Common::String _labFileName;
 	typedef Common::SharedPtr<LabEntry> LabEntryPtr;
-	typedef Common::HashMap<Common::String, LabEntryPtr, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> LabMap;
+	// Lab file names come from a fixed set, so interning them makes the
+	// case insensitive lookups a pointer comparison
+	typedef Common::FlatHashMap<Common::InternedString, LabEntryPtr, Common::InternedString_IgnoreCase_Hash, Common::InternedString_IgnoreCase_EqualTo> LabMap;
 	LabMap _entries;
 	Common::SeekableReadStream *_stream;
+
+	bool findEntry(const Common::String &filename, LabMap::const_iterator &entry) const;
 };
 
 } // end of namespace Grim
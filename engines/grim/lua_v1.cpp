@@ -421,6 +421,8 @@ void Lua_V1::FileFindFirst() {
 	if (searchString == "*.gsv") {
 		searchString = "grim##.gsv";
 	}
+	// A savegame being written in the background must be listed as well
+	SaveGame::waitForPendingWrites();
 	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
 	g_grim->_listFiles = saveFileMan->listSavefiles(searchString);
 	Common::sort(g_grim->_listFiles.begin(), g_grim->_listFiles.end());
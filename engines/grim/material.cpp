@@ -122,7 +122,7 @@ void MaterialData::initEMI(Common::SeekableReadStream *data) {
 	if (_fname.hasSuffix(".sur")) {  // This expects that we want all the materials in the sur-file
 		Common::Array<Common::String> texFileNames;
 		char readFileName[64];
-		TextSplitter *ts = new TextSplitter(_fname, data);
+		TextSplitter *ts = new TextSplitter(_fname, data, true);
 		ts->setLineNumber(2); // Skip copyright-line
 		ts->expectString("version\t1.0");
 		if (ts->checkString("name:"))
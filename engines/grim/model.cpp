@@ -47,7 +47,7 @@ Model::Model(const Common::String &filename, Common::SeekableReadStream *data, C
 		loadBinary(data);
 	else {
 		data->seek(0, SEEK_SET);
-		TextSplitter ts(_fname, data);
+		TextSplitter ts(_fname, data, true);
 		loadText(&ts);
 	}
 
@@ -209,6 +209,10 @@ ResourceLoader::ResourceLoader() {
 	}
 
 	files.clear();
+
+	// Grim probes for many files which do not exist, across dozens of
+	// archives, so remember which archive answers for each name.
+	SearchMan.setMemberIndexEnabled(true);
 }
 
 template<typename T>
@@ -231,6 +235,7 @@ ResourceLoader::~ResourceLoader() {
 	clearList(_keyframeAnims);
 	clearList(_lipsyncs);
 	MD5Check::clear();
+	SearchMan.setMemberIndexEnabled(false);
 }
 
 static int sortCallback(const void *entry1, const void *entry2) {
@@ -21,8 +21,11 @@
  */
 
 #include "common/endian.h"
+#include "common/list.h"
+#include "common/mutex.h"
 #include "common/savefile.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #include "math/vector3d.h"
 
@@ -37,7 +40,120 @@ namespace Grim {
 uint SaveGame::SAVEGAME_MAJOR_VERSION = 22;
 uint SaveGame::SAVEGAME_MINOR_VERSION = 27;
 
+/**
+ * A complete savegame waiting to be written. The save file takes care of
+ * compressing the data, which is most of the time spent saving, so both
+ * happen on the timer thread instead of stalling the game.
+ */
+struct PendingSaveWrite {
+	Common::OutSaveFile *_outSaveFile;
+	byte *_data;
+	uint32 _size;
+	uint32 _written;
+};
+
+/**
+ * How much of a savegame is compressed and written at a time. The timer
+ * thread is shared with the sound, which must not wait for a whole save.
+ */
+static const uint32 kSaveWriteChunkSize = 64 * 1024;
+
+static Common::Mutex *g_saveWriteMutex = nullptr;
+static Common::List<PendingSaveWrite> g_saveWrites;
+static bool g_saveWriterBusy = false;
+static bool g_saveWriterInstalled = false;
+
+static void finishSaveGame(const PendingSaveWrite &save) {
+	save._outSaveFile->writeUint32BE(SAVEGAME_FOOTERTAG);
+	save._outSaveFile->finalize();
+	if (save._outSaveFile->err())
+		warning("SaveGame: Can't write the savegame file in the background. (Disk full?)");
+	delete save._outSaveFile;
+	free(save._data);
+}
+
+/**
+ * Write the next chunk of the oldest pending savegame.
+ * Returns false if there was nothing to do, or another thread is
+ * already writing, as the saves have to be written in order.
+ */
+static bool writeNextSaveChunk() {
+	PendingSaveWrite *save;
+	{
+		Common::StackLock lock(*g_saveWriteMutex);
+		if (g_saveWriterBusy || g_saveWrites.empty())
+			return false;
+		// List nodes stay put when more saves are queued
+		save = &g_saveWrites.front();
+		g_saveWriterBusy = true;
+	}
+
+	uint32 size = MIN(kSaveWriteChunkSize, save->_size - save->_written);
+	save->_outSaveFile->write(save->_data + save->_written, size);
+	save->_written += size;
+
+	bool done = save->_written == save->_size;
+	if (done)
+		finishSaveGame(*save);
+
+	Common::StackLock lock(*g_saveWriteMutex);
+	if (done)
+		g_saveWrites.pop_front();
+	g_saveWriterBusy = false;
+	return true;
+}
+
+static void saveWriterProc(void *) {
+	writeNextSaveChunk();
+}
+
+static void queueSaveWrite(const PendingSaveWrite &save) {
+	if (!g_saveWriteMutex)
+		g_saveWriteMutex = new Common::Mutex();
+
+	{
+		Common::StackLock lock(*g_saveWriteMutex);
+		g_saveWrites.push_back(save);
+	}
+
+	if (!g_saveWriterInstalled) {
+		g_saveWriterInstalled = g_system->getTimerManager()->installTimerProc(saveWriterProc, 10000, nullptr, "grimSaveWriter");
+		if (!g_saveWriterInstalled)
+			SaveGame::waitForPendingWrites();
+	}
+}
+
+void SaveGame::waitForPendingWrites() {
+	if (!g_saveWriteMutex)
+		return;
+
+	while (true) {
+		// Write what is left ourselves, there is no point in waiting for the timer
+		if (writeNextSaveChunk())
+			continue;
+
+		bool done;
+		{
+			Common::StackLock lock(*g_saveWriteMutex);
+			done = !g_saveWriterBusy && g_saveWrites.empty();
+		}
+		if (done)
+			break;
+
+		// The timer thread is writing one at the moment
+		g_system->delayMillis(1);
+	}
+
+	if (g_saveWriterInstalled) {
+		g_system->getTimerManager()->removeTimerProc(saveWriterProc);
+		g_saveWriterInstalled = false;
+	}
+}
+
 SaveGame *SaveGame::openForLoading(const Common::String &filename) {
+	// The savegame may still be on its way to the disk
+	waitForPendingWrites();
+
 	Common::InSaveFile *inSaveFile = g_system->getSavefileManager()->openForLoading(filename);
 	if (!inSaveFile) {
 		warning("SaveGame::openForLoading() Error opening savegame file %s", filename.c_str());
@@ -61,6 +177,10 @@ SaveGame *SaveGame::openForLoading(const Common::String &filename) {
 }
 
 SaveGame *SaveGame::openForSaving(const Common::String &filename) {
+	// An earlier save to the same slot may still be written in the
+	// background, and the saves have to be written in order anyway
+	waitForPendingWrites();
+
 	Common::OutSaveFile *outSaveFile =  g_system->getSavefileManager()->openForSaving(filename);
 	if (!outSaveFile) {
 		warning("SaveGame::openForSaving() Error creating savegame file %s", filename.c_str());
@@ -71,6 +191,7 @@ SaveGame *SaveGame::openForSaving(const Common::String &filename) {
 
 	save->_saving = true;
 	save->_outSaveFile = outSaveFile;
+	save->_snapshot = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
 
 	outSaveFile->writeUint32BE(SAVEGAME_HEADERTAG);
 	outSaveFile->writeUint32BE(SAVEGAME_MAJOR_VERSION);
@@ -85,17 +206,20 @@ SaveGame *SaveGame::openForSaving(const Common::String &filename) {
 SaveGame::SaveGame() :
 		_currentSection(0), _sectionBuffer(nullptr), _majorVersion(0),
 		_minorVersion(0), _saving(false), _inSaveFile(nullptr), _outSaveFile(nullptr),
-		_sectionSize(0), _sectionAlloc(0), _sectionPtr(0) {
+		_sectionSize(0), _sectionAlloc(0), _sectionPtr(0), _snapshot(nullptr) {
 
 }
 
 SaveGame::~SaveGame() {
 	if (_saving) {
-		_outSaveFile->writeUint32BE(SAVEGAME_FOOTERTAG);
-		_outSaveFile->finalize();
-		if (_outSaveFile->err())
-			warning("SaveGame::~SaveGame() Can't write file. (Disk full?)");
-		delete _outSaveFile;
+		// The snapshot is complete, the rest can be done in the background
+		PendingSaveWrite save;
+		save._outSaveFile = _outSaveFile;
+		save._data = _snapshot->getData();
+		save._size = _snapshot->size();
+		save._written = 0;
+		delete _snapshot;
+		queueSaveWrite(save);
 	} else {
 		delete _inSaveFile;
 	}
@@ -143,12 +267,6 @@ uint32 SaveGame::beginSection(uint32 sectionTag) {
 
 		_inSaveFile->seek(-(int32)_sectionSize, SEEK_CUR);
 		_inSaveFile->read(_sectionBuffer, _sectionSize);
-
-	} else {
-		if (!_sectionBuffer) {
-			_sectionAlloc = _allocAmmount;
-			_sectionBuffer = (byte *)malloc(_sectionAlloc);
-		}
 	}
 	_sectionPtr = 0;
 	return _sectionSize;
@@ -158,9 +276,9 @@ void SaveGame::endSection() {
 	if (_currentSection == 0)
 		error("Tried to end a save game section without starting a section");
 	if (_saving) {
-		_outSaveFile->writeUint32BE(_currentSection);
-		_outSaveFile->writeUint32BE(_sectionSize);
-		_outSaveFile->write(_sectionBuffer, _sectionSize);
+		_snapshot->writeUint32BE(_currentSection);
+		_snapshot->writeUint32BE(_sectionSize);
+		_snapshot->write(_sectionBuffer, _sectionSize);
 	}
 	_currentSection = 0;
 }
@@ -230,8 +348,8 @@ bool SaveGame::readBool() {
 
 void SaveGame::checkAlloc(int size) {
 	if (_sectionSize + size > _sectionAlloc) {
-		while (_sectionSize + size > _sectionAlloc)
-			_sectionAlloc += _allocAmmount;
+		// Grow geometrically, so big sections are not copied over and over
+		_sectionAlloc = MAX<uint32>(_sectionAlloc * 2, _sectionSize + size);
 		_sectionBuffer = (byte *)realloc(_sectionBuffer, _sectionAlloc);
 		if (!_sectionBuffer)
 			error("Failed to allocate space for buffer");
@@ -24,6 +24,7 @@
 #define GRIM_SAVEGAME_H
 
 #include "common/savefile.h"
+#include "common/memstream.h"
 
 #include "math/mathfwd.h"
 
@@ -37,6 +38,12 @@ public:
 	static SaveGame *openForSaving(const Common::String &filename);
 	~SaveGame();
 
+	/**
+	 * Saved games are written to disk in the background once they are
+	 * complete. This blocks until all of them have been written.
+	 */
+	static void waitForPendingWrites();
+
 	/**
 	 * Major savegame version.
 	 * If a savegame has a different major version than SAVEGAME_MAJOR_VERSION
@@ -96,8 +103,8 @@ protected:
 	uint32 _sectionAlloc;
 	uint32 _sectionPtr;
 	byte *_sectionBuffer;
-
-	static const int _allocAmmount = 1048576;
+	/** The finished sections of a savegame being stored */
+	Common::MemoryWriteStreamDynamic *_snapshot;
 };
 
 } // end of namespace Grim
@@ -46,7 +46,7 @@ Set::Set(const Common::String &sceneName, Common::SeekableReadStream *data) :
 	data->read(header, 7);
 	data->seek(0, SEEK_SET);
 	if (memcmp(header, "section", 7) == 0) {
-		TextSplitter ts(_name, data);
+		TextSplitter ts(_name, data, true);
 		loadText(ts);
 	} else {
 		loadBinary(data);
@@ -89,9 +89,18 @@ Set::~Set() {
 	}
 }
 
+void Set::lightsChanged() {
+	// The generation is shared by all sets, so that lighting cached for
+	// one set never matches another one.
+	static uint32 lightsGeneration = 0;
+	_lightsGeneration = ++lightsGeneration;
+}
+
 void Set::setupOverworldLights() {
 	Light *l;
 
+	lightsChanged();
+
 	l = new Light();
 	l->_name = "Overworld Light 1";
 	l->_enabled = true;
@@ -341,6 +350,7 @@ bool Set::restoreState(SaveGame *savedState) {
 		_lights[i]._id = i;
 		_lightsList.push_back(&_lights[i]);
 	}
+	lightsChanged();
 
 	if (savedState->saveMinorVersion() >= 19) {
 		_numShadows = savedState->readLESint32();
@@ -981,6 +991,7 @@ void Set::setLightIntensity(const char *light, float intensity) {
 		Light &l = _lights[i];
 		if (l._name == light) {
 			l.setIntensity(intensity);
+			lightsChanged();
 			return;
 		}
 	}
@@ -989,6 +1000,7 @@ void Set::setLightIntensity(const char *light, float intensity) {
 void Set::setLightIntensity(int light, float intensity) {
 	Light &l = _lights[light];
 	l.setIntensity(intensity);
+	lightsChanged();
 }
 
 void Set::setLightEnabled(const char *light, bool enabled) {
@@ -996,6 +1008,7 @@ void Set::setLightEnabled(const char *light, bool enabled) {
 		Light &l = _lights[i];
 		if (l._name == light) {
 			l._enabled = enabled;
+			lightsChanged();
 			return;
 		}
 	}
@@ -1004,6 +1017,7 @@ void Set::setLightEnabled(const char *light, bool enabled) {
 void Set::setLightEnabled(int light, bool enabled) {
 	Light &l = _lights[light];
 	l._enabled = enabled;
+	lightsChanged();
 }
 
 void Set::setLightPosition(const char *light, const Math::Vector3d &pos) {
@@ -1011,6 +1025,7 @@ void Set::setLightPosition(const char *light, const Math::Vector3d &pos) {
 		Light &l = _lights[i];
 		if (l._name == light) {
 			l._pos = pos;
+			lightsChanged();
 			return;
 		}
 	}
@@ -1019,6 +1034,7 @@ void Set::setLightPosition(const char *light, const Math::Vector3d &pos) {
 void Set::setLightPosition(int light, const Math::Vector3d &pos) {
 	Light &l = _lights[light];
 	l._pos = pos;
+	lightsChanged();
 }
 
 void Set::setSoundPosition(const char *soundName, const Math::Vector3d &pos) {
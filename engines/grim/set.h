@@ -145,6 +145,8 @@ public:
 
 	Setup *getCurrSetup() { return _currSetup; }
 	const Common::List<Light *> &getLights(bool inOverworld) { return (inOverworld ? _overworldLightsList : _lightsList); }
+	/** Changes whenever a light of any set changes, so it can key cached lighting. */
+	uint32 getLightsGeneration() const { return _lightsGeneration; }
 	const Math::Frustum &getFrustum() { return _frustum; }
 
 	int getShadowCount() const { return _numShadows; }
@@ -152,6 +154,8 @@ public:
 	SetShadow *getShadowByName(const Common::String &name);
 
 private:
+	void lightsChanged();
+
 	bool _locked;
 	Common::String _name;
 	int _numCmaps;
@@ -162,6 +166,7 @@ private:
 	Light *_lights;
 	Common::List<Light *> _lightsList;
 	Common::List<Light *> _overworldLightsList;
+	uint32 _lightsGeneration;
 	Setup *_setups;
 	SetShadow *_shadows;
 
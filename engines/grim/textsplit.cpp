@@ -23,11 +23,35 @@
 #include "common/util.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
+#include "common/memstream.h"
+#include "common/hash-str.h"
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/config-manager.h"
 
+#include "engines/grim/debug.h"
 #include "engines/grim/textsplit.h"
 
 namespace Grim {
 
+enum {
+	kTextCacheVersion = 2,
+	kTextCacheHeaderSize = 24,
+	kTextCacheEndOfFields = 0xFFFF,
+	// Caches of a game beyond this number get evicted
+	kMaxTextCaches = 512
+};
+
+static uint32 computeTextChecksum(const char *text, uint32 size) {
+	// FNV-1a, which is a lot cheaper than splitting the text again
+	uint32 hash = 2166136261u;
+	for (uint32 i = 0; i < size; i++) {
+		hash ^= (byte)text[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
 static bool isCodeSeparator(char c) {
 	return (c == ' ' || c == ',' || c == '.' || c == '%' || c == '\'' || c == ':');
 }
@@ -96,9 +120,17 @@ static char *parseCharacterClass(const char *code, bool *isNegated) {
 	return chars;
 }
 
+static void recordField(Common::WriteStream *record, const void *var, uint32 size) {
+	if (record) {
+		record->writeUint16LE(size);
+		record->write(var, size);
+	}
+}
+
 // This function is modelled after sscanf, and supports a subset of its features. See sscanf documentation
-// for information about the syntax it accepts.
-static void parse(const char *line, const char *fmt, int field_count, va_list va) {
+// for information about the syntax it accepts. If 'record' is set, whatever gets written to the
+// variables is also written there.
+static void parse(const char *line, const char *fmt, int field_count, va_list va, Common::WriteStream *record) {
 	char *str = scumm_strdup(line);
 	const int len = strlen(str);
 	for (int i = 0; i < len; ++i) {
@@ -142,6 +174,7 @@ static void parse(const char *line, const char *fmt, int field_count, va_list va
 			void *var = va_arg(va, void *);
 			if (strcmp(code, "n") == 0) {
 				*(int*)var = src - str;
+				recordField(record, var, sizeof(int));
 				continue;
 			}
 
@@ -192,23 +225,31 @@ static void parse(const char *line, const char *fmt, int field_count, va_list va
 
 			if (strcmp(code, "d") == 0) {
 				*(int*)var = atoi(s);
+				recordField(record, var, sizeof(int));
 			} else if (strcmp(code, "x") == 0) {
 				*(int*)var = strtol(s, (char **) nullptr, 16);
+				recordField(record, var, sizeof(int));
 			} else if (strcmp(code, "f") == 0) {
 				*(float*)var = str2float(s);
+				recordField(record, var, sizeof(float));
 			} else if (strcmp(code, "c") == 0) {
 				*(char*)var = s[0];
+				recordField(record, var, sizeof(char));
 			} else if (strcmp(code, "s") == 0) {
 				char *string = (char*)var;
 				strncpy(string, s, fieldWidth);
 				if (fieldWidth <= strlen(s)) {
 					// add terminating \0
 					string[fieldWidth] = '\0';
+					recordField(record, var, fieldWidth + 1);
+				} else {
+					recordField(record, var, fieldWidth);
 				}
 			} else if (code[0] == '[') {
 				char *string = (char*)var;
 				strncpy(string, s, fieldWidth);
 				string[fieldWidth - 1] = '\0';
+				recordField(record, var, fieldWidth);
 			} else {
 				error("Code not handled: \"%s\" \"%s\"\n\"%s\" \"%s\"", code, s, line, fmt);
 			}
@@ -244,16 +285,49 @@ static void parse(const char *line, const char *fmt, int field_count, va_list va
 }
 
 
-TextSplitter::TextSplitter(const Common::String &fname, Common::SeekableReadStream *data) : _fname(fname) {
+TextSplitter::TextSplitter(const Common::String &fname, Common::SeekableReadStream *data, bool cache) :
+		_fname(fname), _textSize(0), _textChecksum(0), _cacheData(nullptr), _replayStart(nullptr),
+		_replayPos(nullptr), _replayEnd(nullptr), _record(nullptr) {
+	_textSize = data->size();
+
+	_stringData = new char[_textSize + 1];
+	data->read(_stringData, _textSize);
+	_stringData[_textSize] = '\0';
+
+	_numLines = _lineIndex = 0;
+	_lines = nullptr;
+
+	cache = cache && ConfMan.getBool("cache_text_resources");
+	if (cache) {
+		_textChecksum = computeTextChecksum(_stringData, _textSize);
+		_cacheName = Common::String::format("%s-text-%08x.cache", ConfMan.getActiveDomainName().c_str(), Common::hashit_lower(fname.c_str()));
+	}
+
+	if (!cache || !openCache()) {
+		splitLines();
+		if (cache)
+			startRecord();
+	}
+
+	_currLine = nullptr;
+	processLine();
+}
+
+TextSplitter::~TextSplitter() {
+	if (_record)
+		saveCache();
+
+	delete _record;
+	delete[] _cacheData;
+	delete[] _stringData;
+	delete[] _lines;
+}
+
+void TextSplitter::splitLines() {
 	char *line;
 	int i;
-	uint32 len = data->size();
 
-	_stringData = new char[len + 1];
-	data->read(_stringData, len);
-	_stringData[len] = '\0';
 	// Find out how many lines of text there are
-	_numLines = _lineIndex = 0;
 	line = (char *)_stringData;
 	while (line) {
 		line = strchr(line, '\n');
@@ -271,14 +345,197 @@ TextSplitter::TextSplitter(const Common::String &fname, Common::SeekableReadStre
 		*line = '\0';
 		_lines[i] = lastLine;
 		line++;
+
+		// Cut off comments
+		char *comment_start = strchr(lastLine, '#');
+		if (comment_start)
+			*comment_start = '\0';
+
+		// Cut off trailing whitespace (including '\r')
+		char *strend = strchr(lastLine, '\0');
+		while (strend > lastLine && Common::isSpace(strend[-1]))
+			strend--;
+		*strend = '\0';
+
+		// Convert to lower case
+		for (char *s = lastLine; *s != '\0'; s++)
+			*s = tolower(*s);
 	}
-	_currLine = nullptr;
-	processLine();
 }
 
-TextSplitter::~TextSplitter() {
+bool TextSplitter::openCache() {
+	Common::InSaveFile *file = g_system->getSavefileManager()->openForLoading(_cacheName);
+	if (!file)
+		return false;
+
+	uint32 cacheSize = file->size();
+	_cacheData = new byte[cacheSize];
+	bool valid = file->read(_cacheData, cacheSize) == cacheSize && cacheSize >= kTextCacheHeaderSize &&
+	             READ_BE_UINT32(_cacheData) == MKTAG('G','T','X','C') &&
+	             READ_LE_UINT32(_cacheData + 4) == kTextCacheVersion;
+	delete file;
+
+	if (!valid) {
+		Debug::warning(Debug::Engine, "Ignoring broken text cache %s for %s", _cacheName.c_str(), _fname.c_str());
+	} else if (READ_LE_UINT32(_cacheData + 8) != _textSize || READ_LE_UINT32(_cacheData + 12) != _textChecksum) {
+		// The text changed, or another one has the same name hash. The
+		// cache gets replaced.
+		valid = false;
+	} else {
+		// Point the lines into the cache, checking that they are all there
+		int numLines = READ_LE_UINT32(_cacheData + 16);
+		uint32 linesSize = READ_LE_UINT32(_cacheData + 20);
+		valid = numLines >= 0 && (uint32)numLines <= linesSize && linesSize <= cacheSize - kTextCacheHeaderSize;
+		if (valid) {
+			char *line = (char *)_cacheData + kTextCacheHeaderSize;
+			char *linesEnd = line + linesSize;
+			_lines = new char *[numLines];
+			for (_numLines = 0; _numLines < numLines && line < linesEnd; _numLines++) {
+				char *lineEnd = (char *)memchr(line, '\0', linesEnd - line);
+				if (!lineEnd)
+					break;
+				_lines[_numLines] = line;
+				line = lineEnd + 1;
+			}
+			valid = _numLines == numLines && line == linesEnd;
+		}
+		if (!valid)
+			Debug::warning(Debug::Engine, "Ignoring broken text cache %s for %s", _cacheName.c_str(), _fname.c_str());
+	}
+
+	if (!valid) {
+		delete[] _lines;
+		_lines = nullptr;
+		_numLines = 0;
+		delete[] _cacheData;
+		_cacheData = nullptr;
+		return false;
+	}
+
+	// The lines are in the cache, the text isn't needed anymore
 	delete[] _stringData;
-	delete[] _lines;
+	_stringData = nullptr;
+
+	_replayStart = _replayPos = _cacheData + kTextCacheHeaderSize + READ_LE_UINT32(_cacheData + 20);
+	_replayEnd = _cacheData + cacheSize;
+	return true;
+}
+
+void TextSplitter::startRecord() {
+	uint32 linesSize = 0;
+	for (int i = 0; i < _numLines; i++)
+		linesSize += strlen(_lines[i]) + 1;
+
+	_record = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+	_record->writeUint32BE(MKTAG('G','T','X','C'));
+	_record->writeUint32LE(kTextCacheVersion);
+	_record->writeUint32LE(_textSize);
+	_record->writeUint32LE(_textChecksum);
+	_record->writeUint32LE(_numLines);
+	_record->writeUint32LE(linesSize);
+	for (int i = 0; i < _numLines; i++)
+		_record->write(_lines[i], strlen(_lines[i]) + 1);
+}
+
+void TextSplitter::saveCache() {
+	evictCaches();
+
+	Common::OutSaveFile *file = g_system->getSavefileManager()->openForSaving(_cacheName, false);
+	if (!file) {
+		Debug::warning(Debug::Engine, "Could not create text cache %s for %s", _cacheName.c_str(), _fname.c_str());
+		return;
+	}
+
+	file->write(_record->getData(), _record->size());
+	file->finalize();
+	if (file->err())
+		Debug::warning(Debug::Engine, "Could not write text cache %s for %s", _cacheName.c_str(), _fname.c_str());
+	delete file;
+}
+
+void TextSplitter::evictCaches() {
+	// Keep the number of caches of this game bounded, so that they don't
+	// pile up in the save path. Their names are hashes, so this drops
+	// arbitrary ones.
+	Common::SaveFileManager *saveMan = g_system->getSavefileManager();
+	Common::StringArray caches = saveMan->listSavefiles(ConfMan.getActiveDomainName() + "-text-*.cache");
+	int count = caches.size();
+	for (uint i = 0; i < caches.size() && count >= kMaxTextCaches; i++) {
+		if (caches[i] != _cacheName && saveMan->removeSavefile(caches[i]))
+			count--;
+	}
+}
+
+void TextSplitter::scan(int offset, const char *fmt, int field_count, va_list va) {
+	if (_replayPos) {
+		if (replay(offset, fmt, va))
+			return;
+
+		// The loader took another path than when the cache was written,
+		// so parse everything from here on, and write the cache again
+		// with the scans which did match so far.
+		Debug::debug(Debug::Engine, "Text cache %s doesn't match %s at line %d", _cacheName.c_str(), _fname.c_str(), getLineNumber());
+		startRecord();
+		_record->write(_replayStart, _replayPos - _replayStart);
+		_replayPos = nullptr;
+	}
+
+	if (_record) {
+		_record->writeSint32LE(getLineNumber());
+		_record->writeSint32LE(offset);
+		uint32 fmtLength = strlen(fmt);
+		_record->writeUint16LE(fmtLength);
+		_record->write(fmt, fmtLength);
+	}
+
+	parse(getCurrentLine() + offset, fmt, field_count, va, _record);
+
+	if (_record)
+		_record->writeUint16LE(kTextCacheEndOfFields);
+}
+
+bool TextSplitter::replay(int offset, const char *fmt, va_list va) {
+	const byte *pos = _replayPos;
+	uint32 fmtLength = strlen(fmt);
+
+	if (_replayEnd - pos < 10 ||
+	    (int32)READ_LE_UINT32(pos) != getLineNumber() ||
+	    (int32)READ_LE_UINT32(pos + 4) != offset ||
+	    READ_LE_UINT16(pos + 8) != fmtLength)
+		return false;
+	pos += 10;
+
+	if ((uint32)(_replayEnd - pos) < fmtLength || memcmp(pos, fmt, fmtLength) != 0)
+		return false;
+	pos += fmtLength;
+
+	// Check that all the fields are there before touching any of the
+	// variables, so that a damaged cache can still fall back to parsing.
+	const byte *fields = pos;
+	for (;;) {
+		if (_replayEnd - pos < 2)
+			return false;
+		uint16 size = READ_LE_UINT16(pos);
+		pos += 2;
+		if (size == kTextCacheEndOfFields)
+			break;
+		if ((uint32)(_replayEnd - pos) < size)
+			return false;
+		pos += size;
+	}
+
+	for (pos = fields; ; ) {
+		uint16 size = READ_LE_UINT16(pos);
+		pos += 2;
+		if (size == kTextCacheEndOfFields)
+			break;
+		void *var = va_arg(va, void *);
+		memcpy(var, pos, size);
+		pos += size;
+	}
+
+	_replayPos = pos;
+	return true;
 }
 
 bool TextSplitter::checkString(const char *needle) {
@@ -310,7 +567,7 @@ void TextSplitter::scanString(const char *fmt, int field_count, ...) {
 	va_list va;
 	va_start(va, field_count);
 
-	parse(getCurrentLine(), fmt, field_count, va);
+	scan(0, fmt, field_count, va);
 
 	va_end(va);
 
@@ -324,7 +581,7 @@ void TextSplitter::scanStringAtOffset(int offset, const char *fmt, int field_cou
 	va_list va;
 	va_start(va, field_count);
 
-	parse(getCurrentLine() + offset, fmt, field_count, va);
+	scan(offset, fmt, field_count, va);
 
 	va_end(va);
 
@@ -338,7 +595,7 @@ void TextSplitter::scanStringNoNewLine(const char *fmt, int field_count, ...) {
 	va_list va;
 	va_start(va, field_count);
 
-	parse(getCurrentLine(), fmt, field_count, va);
+	scan(0, fmt, field_count, va);
 
 	va_end(va);
 }
@@ -350,7 +607,7 @@ void TextSplitter::scanStringAtOffsetNoNewLine(int offset, const char *fmt, int
 	va_list va;
 	va_start(va, field_count);
 
-	parse(getCurrentLine() + offset, fmt, field_count, va);
+	scan(offset, fmt, field_count, va);
 
 	va_end(va);
 }
@@ -359,27 +616,13 @@ void TextSplitter::processLine() {
 	if (isEof())
 		return;
 
+	// The lines were stripped and lowercased by splitLines(), or come
+	// from the cache like that
 	_currLine = _lines[_lineIndex++];
 
-	// Cut off comments
-	char *comment_start = strchr(_currLine, '#');
-	if (comment_start)
-		*comment_start = '\0';
-
-	// Cut off trailing whitespace (including '\r')
-	char *strend = strchr(_currLine, '\0');
-	while (strend > _currLine && Common::isSpace(strend[-1]))
-		strend--;
-	*strend = '\0';
-
 	// Skip blank lines
 	if (*_currLine == '\0')
 		nextLine();
-
-	// Convert to lower case
-	if (!isEof())
-		for (char *s = _currLine; *s != '\0'; s++)
-			*s = tolower(*s);
 }
 
 } // end of namespace Grim
@@ -25,6 +25,7 @@
 
 namespace Common {
 class SeekableReadStream;
+class MemoryWriteStreamDynamic;
 }
 
 namespace Grim {
@@ -32,10 +33,17 @@ namespace Grim {
 // A utility class to help in parsing the text-format files.  Splits
 // the text data into lines, skipping comments, trailing whitespace,
 // and empty lines.  Also folds everything to lowercase.
+//
+// If 'cache' is set, the split lines and the results of the scans are
+// saved in the save path, and the next time the same text is loaded they
+// are copied out of there instead of splitting and parsing the lines
+// again.  A scan which doesn't match the cached ones in order (same
+// line, offset and format) parses the line as usual, and the cache is
+// written again with the new scans.
 
 class TextSplitter {
 public:
-	TextSplitter(const Common::String &fname, Common::SeekableReadStream *data);
+	TextSplitter(const Common::String &fname, Common::SeekableReadStream *data, bool cache = false);
 	~TextSplitter();
 
 	char *nextLine() {
@@ -79,7 +87,20 @@ private:
 	int _numLines, _lineIndex;
 	char **_lines;
 
+	Common::String _cacheName;
+	uint32 _textSize, _textChecksum;
+	byte *_cacheData;
+	const byte *_replayStart, *_replayPos, *_replayEnd;
+	Common::MemoryWriteStreamDynamic *_record;
+
+	void splitLines();
 	void processLine();
+	bool openCache();
+	void startRecord();
+	void saveCache();
+	void evictCaches();
+	void scan(int offset, const char *fmt, int field_count, va_list va);
+	bool replay(int offset, const char *fmt, va_list va);
 };
 
 } // end of namespace Grim
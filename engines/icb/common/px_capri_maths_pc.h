@@ -102,6 +102,7 @@ inline int myNINT_PC(float f) {
 #define gte_SetBackColor_pc mygte_SetBackColor_pc
 #define gte_SetColorMatrix_pc mygte_SetColorMatrix_pc
 #define gte_SetLightMatrix_pc mygte_SetLightMatrix_pc
+#define gte_NormalColorEffect_pc mygte_NormalColorEffect_pc
 #define gte_NormalColorCol_pc mygte_NormalColorCol_pc
 #define gte_NormalColorCol3_pc mygte_NormalColorCol3_pc
 #define gte_NormalClip_pc mygte_NormalClip_pc
@@ -155,6 +156,8 @@ inline void mygte_SetBackColor_pc(int32 r, int32 g, int32 b);
 
 inline void mygte_SetScreenScaleShift_pc(int32 shift);
 
+inline void mygte_NormalColorEffect_pc(SVECTOR *v0, SVECTORPC *colourEffect);
+
 inline void mygte_NormalColorCol_pc(SVECTOR *v0, CVECTOR *in0, CVECTOR *out0);
 
 inline void mygte_NormalColorCol3_pc(SVECTOR *v0, SVECTOR *v1, SVECTOR *v2, CVECTOR *in0, CVECTOR *out0, CVECTOR *out1, CVECTOR *out2);
@@ -433,7 +436,9 @@ inline void mygte_SetGeomScreen_pc(int32 h) { gtegeomscrn_pc = h; }
 
 //------------------------------------------------------------------------
 
-inline void mygte_NormalColorCol_pc(SVECTOR *v0, CVECTOR *in0, CVECTOR *out0) {
+// The colour effect of a normal before it is modulated by the base colour
+// 256 = 1.0 in colourEffect
+inline void mygte_NormalColorEffect_pc(SVECTOR *v0, SVECTORPC *colourEffect) {
 	SVECTORPC lightEffect;
 	// Normal line vector(local) -> light source effect
 	ApplyMatrixSV_pc(&gtelight_pc, v0, &lightEffect);
@@ -445,20 +450,26 @@ inline void mygte_NormalColorCol_pc(SVECTOR *v0, CVECTOR *in0, CVECTOR *out0) {
 		lightEffect.vz = 0;
 
 	// Light source effect -> Colour effect(local colour matrix+back colour)
-	SVECTORPC colourEffect;
-	ApplyMatrixSV_pc(&gtecolour_pc, &lightEffect, &colourEffect);
-	if (colourEffect.vx < 0)
-		colourEffect.vx = 0;
-	if (colourEffect.vy < 0)
-		colourEffect.vy = 0;
-	if (colourEffect.vz < 0)
-		colourEffect.vz = 0;
+	ApplyMatrixSV_pc(&gtecolour_pc, &lightEffect, colourEffect);
+	if (colourEffect->vx < 0)
+		colourEffect->vx = 0;
+	if (colourEffect->vy < 0)
+		colourEffect->vy = 0;
+	if (colourEffect->vz < 0)
+		colourEffect->vz = 0;
 
 	// colourEffect is 0-ONE_PC (2^ONE_PC_SCALE)
 	// gteback is 0-255 (2^8)
-	colourEffect.vx = ((colourEffect.vx >> (ONE_PC_SCALE - 8)) + gteback_pc[0]);
-	colourEffect.vy = ((colourEffect.vy >> (ONE_PC_SCALE - 8)) + gteback_pc[1]);
-	colourEffect.vz = ((colourEffect.vz >> (ONE_PC_SCALE - 8)) + gteback_pc[2]);
+	colourEffect->vx = ((colourEffect->vx >> (ONE_PC_SCALE - 8)) + gteback_pc[0]);
+	colourEffect->vy = ((colourEffect->vy >> (ONE_PC_SCALE - 8)) + gteback_pc[1]);
+	colourEffect->vz = ((colourEffect->vz >> (ONE_PC_SCALE - 8)) + gteback_pc[2]);
+}
+
+//------------------------------------------------------------------------
+
+inline void mygte_NormalColorCol_pc(SVECTOR *v0, CVECTOR *in0, CVECTOR *out0) {
+	SVECTORPC colourEffect;
+	mygte_NormalColorEffect_pc(v0, &colourEffect);
 
 	// 256 = 1.0 in colourEffect
 	// 128 = 1.0 in in0
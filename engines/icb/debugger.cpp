@@ -0,0 +1,187 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the AUTHORS
+ * file distributed with this source distribution.
+ *
+ * Additional copyright for this file:
+ * Copyright (C) 1999-2000 Revolution Software Ltd.
+ * This code is based on source code created by Revolution Software,
+ * used with permission.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/icb/debugger.h"
+#include "engines/icb/common/px_common.h"
+#include "engines/icb/res_man.h"
+#include "engines/icb/global_objects.h"
+#include "engines/icb/drawpoly_pc.h"
+#include "engines/icb/mission.h"
+#include "engines/icb/p4.h"
+#include "engines/icb/jpeg.h"
+#include "engines/icb/surface_manager.h"
+#include "engines/icb/debug_pc.h"
+
+#include "common/system.h"
+
+namespace ICB {
+
+static const char *const resManNames[] = {"anims", "bg", "icons", "private"};
+
+Debugger::Debugger() : GUI::Debugger() {
+	registerCmd("resman", WRAP_METHOD(Debugger, cmd_resman));
+	registerCmd("defrag", WRAP_METHOD(Debugger, cmd_defrag));
+	registerCmd("litcheck", WRAP_METHOD(Debugger, cmd_litcheck));
+	registerCmd("jpeg", WRAP_METHOD(Debugger, cmd_jpeg));
+}
+
+Debugger::~Debugger() {
+}
+
+res_man *Debugger::findResMan(const char *name) {
+	if (!strcmp(name, "anims"))
+		return rs_anims;
+	if (!strcmp(name, "bg"))
+		return rs_bg;
+	if (!strcmp(name, "icons"))
+		return rs_icons;
+	if (!strcmp(name, "private"))
+		return private_session_resman;
+	return nullptr;
+}
+
+void Debugger::printResMan(const char *name, res_man *rm) {
+	if (!rm) {
+		debugPrintf("%s: not created\n", name);
+		return;
+	}
+
+	RMPoolStats stats;
+	rm->Fetch_pool_stats(&stats);
+
+	uint32 used = stats.total_pool - stats.free_memory;
+	// How much of the free memory can't be used for the largest allocation
+	uint32 fragmentation = 0;
+	if (stats.free_memory)
+		fragmentation = 100 - (uint32)(((uint64)stats.largest_free_block * 100) / stats.free_memory);
+
+	debugPrintf("%s: %uKB of %uKB used (%u%%), %u files open\n", name, used / 1024, stats.total_pool / 1024,
+	            stats.total_pool ? (uint32)(((uint64)used * 100) / stats.total_pool) : 0, stats.files_open);
+	debugPrintf("  %u free blocks, largest %uKB, fragmentation %u%%, %u of %u mem blocks\n", stats.free_blocks,
+	            stats.largest_free_block / 1024, fragmentation, stats.used_blocks, stats.max_blocks);
+	debugPrintf("  %u defrags taking %ums (longest %ums), %uKB compacted\n", stats.defrags, stats.defrag_time,
+	            stats.max_defrag_time, stats.compacted / 1024);
+}
+
+bool Debugger::cmd_resman(int argc, const char **argv) {
+	for (uint i = 0; i < ARRAYSIZE(resManNames); i++) {
+		if ((argc < 2) || !strcmp(argv[1], resManNames[i])) {
+			printResMan(resManNames[i], findResMan(resManNames[i]));
+			if (argc >= 2)
+				return true;
+		}
+	}
+
+	if (argc >= 2)
+		debugPrintf("Usage: resman [anims|bg|icons|private]\n");
+	return true;
+}
+
+bool Debugger::cmd_defrag(int argc, const char **argv) {
+	if (argc < 2) {
+		debugPrintf("Usage: defrag <anims|bg|icons|private>\n");
+		return true;
+	}
+
+	res_man *rm = findResMan(argv[1]);
+	if (!rm) {
+		debugPrintf("Unknown resource manager %s\n", argv[1]);
+		return true;
+	}
+
+	uint32 time = g_system->getMillis();
+	rm->Defrag();
+	debugPrintf("Defrag took %ums\n", g_system->getMillis() - time);
+	printResMan(argv[1], rm);
+	return true;
+}
+
+bool Debugger::cmd_litcheck(int argc, const char **argv) {
+	if (argc < 2) {
+		debugPrintf("Usage: litcheck <frames>\n");
+		debugPrintf("Compares the vertex colours lit through the lit normal cache against the reference lighting\n");
+		debugPrintf("for a number of frames, using a hash of the colours of each frame (not of the rendered image)\n");
+		return true;
+	}
+
+	StartLitNormalCheck(atoi(argv[1]));
+	debugPrintf("Checking the lit normal cache, the result is reported as a warning\n");
+	return true;
+}
+
+bool Debugger::cmd_jpeg(int argc, const char **argv) {
+	if (!g_mission || !MS->set.OK()) {
+		debugPrintf("No set is loaded\n");
+		return true;
+	}
+
+	int count = (argc < 2) ? 1 : atoi(argv[1]);
+	if (count < 1) {
+		debugPrintf("Usage: jpeg [count]\n");
+		debugPrintf("Decodes the background of the current camera count times and prints the time taken and a hash of the pixels\n");
+		return true;
+	}
+
+	// The same data set_pc.cpp decodes into the background surface
+	uint8 *bgPtr = MS->set.GetBackground();
+	uint32 *shadowTable = ((uint32 *)bgPtr) + 1;
+	uint8 *jpegPtr = bgPtr + shadowTable[0];
+
+	uint32 sid = surface_manager->Create_new_surface("jpeg test", SCREEN_WIDTH, SCREEN_DEPTH, EITHER);
+
+	uint32 bestTime = 0xffffffff;
+	uint32 totalTime = 0;
+	for (int i = 0; i < count; i++) {
+		uint32 time = GetMicroTimer();
+		JpegDecoder decoder;
+		decoder.ReadImage(jpegPtr, sid);
+		time = GetMicroTimer() - time;
+
+		totalTime += time;
+		if (time < bestTime)
+			bestTime = time;
+	}
+
+	// FNV-1a over the visible pixels, so the pitch doesn't matter
+	uint32 hash = 2166136261u;
+	uint8 *pixels = surface_manager->Lock_surface(sid);
+	int pitch = surface_manager->Get_pitch(sid);
+	for (uint32 y = 0; y < SCREEN_DEPTH; y++) {
+		const uint8 *row = pixels + y * pitch;
+		for (uint32 x = 0; x < SCREEN_WIDTH * 4; x++) {
+			hash ^= row[x];
+			hash *= 16777619u;
+		}
+	}
+	surface_manager->Unlock_surface(sid);
+	surface_manager->Kill_surface(sid);
+
+	debugPrintf("Decoded %d times, best %uus, average %uus, hash %08x\n", count, bestTime, totalTime / count, hash);
+	return true;
+}
+
+} // End of namespace ICB
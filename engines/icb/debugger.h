@@ -0,0 +1,54 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the AUTHORS
+ * file distributed with this source distribution.
+ *
+ * Additional copyright for this file:
+ * Copyright (C) 1999-2000 Revolution Software Ltd.
+ * This code is based on source code created by Revolution Software,
+ * used with permission.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ICB_DEBUGGER_H
+#define ICB_DEBUGGER_H
+
+#include "gui/debugger.h"
+
+namespace ICB {
+
+class res_man;
+
+class Debugger : public GUI::Debugger {
+public:
+	Debugger();
+	virtual ~Debugger();
+
+	bool cmd_resman(int argc, const char **argv);
+	bool cmd_defrag(int argc, const char **argv);
+	bool cmd_litcheck(int argc, const char **argv);
+	bool cmd_jpeg(int argc, const char **argv);
+
+private:
+	res_man *findResMan(const char *name);
+	void printResMan(const char *name, res_man *rm);
+};
+
+} // End of namespace ICB
+
+#endif
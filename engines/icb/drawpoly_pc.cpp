@@ -79,7 +79,8 @@ uint8 selPAlpha = 0;
 
 // Specialist lighting routines for polygons
 // support for bounce & width
-inline void LightPolygon(SVECTOR *n0, CVECTOR *rgbIn, CVECTOR *rgb0) {
+// Computes the colour effect of a normal before it is modulated by the base colour
+inline void LightPolygonEffect(SVECTOR *n0, SVECTORPC *colourEffect) {
 	SVECTORPC lightEffect;
 	// Normal line vector(local) -> light source effect
 	ApplyMatrixSV_pc(&gtelight_pc, n0, &lightEffect);
@@ -115,26 +116,28 @@ inline void LightPolygon(SVECTOR *n0, CVECTOR *rgbIn, CVECTOR *rgb0) {
 	}
 
 	// Light source effect -> Colour effect(local colour matrix+back colour)
-	SVECTORPC colourEffect;
-	ApplyMatrixSV_pc(&gtecolour_pc, &lightEffect, &colourEffect);
-	if (colourEffect.vx < 0)
-		colourEffect.vx = 0;
-	if (colourEffect.vy < 0)
-		colourEffect.vy = 0;
-	if (colourEffect.vz < 0)
-		colourEffect.vz = 0;
+	ApplyMatrixSV_pc(&gtecolour_pc, &lightEffect, colourEffect);
+	if (colourEffect->vx < 0)
+		colourEffect->vx = 0;
+	if (colourEffect->vy < 0)
+		colourEffect->vy = 0;
+	if (colourEffect->vz < 0)
+		colourEffect->vz = 0;
 
 	// colourEffect is 0-4095 (2^12)
 	// gteback is 0-255 (2^8)
-	colourEffect.vx = (short)((colourEffect.vx >> 4) + gteback_pc[0]);
-	colourEffect.vy = (short)((colourEffect.vy >> 4) + gteback_pc[1]);
-	colourEffect.vz = (short)((colourEffect.vz >> 4) + gteback_pc[2]);
+	colourEffect->vx = (short)((colourEffect->vx >> 4) + gteback_pc[0]);
+	colourEffect->vy = (short)((colourEffect->vy >> 4) + gteback_pc[1]);
+	colourEffect->vz = (short)((colourEffect->vz >> 4) + gteback_pc[2]);
+}
 
+// Modulate the base colour by a colour effect
+inline void ApplyColourEffect(SVECTORPC *colourEffect, CVECTOR *rgbIn, CVECTOR *rgb0) {
 	// 256 = 1.0 in colourEffect
 	// 128 = 1.0 in in0
-	int red = (rgbIn->r * colourEffect.vx);
-	int green = (rgbIn->g * colourEffect.vy);
-	int blue = (rgbIn->b * colourEffect.vz);
+	int red = (rgbIn->r * colourEffect->vx);
+	int green = (rgbIn->g * colourEffect->vy);
+	int blue = (rgbIn->b * colourEffect->vz);
 
 	red = red >> 8;
 	green = green >> 8;
@@ -152,6 +155,12 @@ inline void LightPolygon(SVECTOR *n0, CVECTOR *rgbIn, CVECTOR *rgb0) {
 	rgb0->b = (uint8)(blue);
 }
 
+inline void LightPolygon(SVECTOR *n0, CVECTOR *rgbIn, CVECTOR *rgb0) {
+	SVECTORPC colourEffect;
+	LightPolygonEffect(n0, &colourEffect);
+	ApplyColourEffect(&colourEffect, rgbIn, rgb0);
+}
+
 // Specialist lighting routines for polygons
 // support for bounce & width
 inline void LightPolygon3(SVECTOR *n0, SVECTOR *n1, SVECTOR *n2, CVECTOR *rgbIn, CVECTOR *rgb0, CVECTOR *rgb1, CVECTOR *rgb2) {
@@ -176,6 +185,118 @@ inline void LightPolygon3(SVECTOR *n0, SVECTOR *n1, SVECTOR *n2, CVECTOR *rgbIn,
 			gte_NormalColorCol3_pc(n0, n1, n2, rgbIn, rgb0, rgb1, rgb2);                                                                                               \
 	}
 
+// Cache of lit normals used by the fast lit drawing routines.
+// Normals are shared between the polygons of a mesh, so the expensive
+// light & colour matrix work is done at most once per normal per call
+// and only the modulation by the base colour is done per vertex.
+#define LIT_NORMAL_CACHE_SIZE 2048
+
+typedef struct {
+	uint32 stamp;
+	SVECTORPC colourEffect;
+} LitNormal;
+
+static LitNormal litNormalCache[LIT_NORMAL_CACHE_SIZE];
+static uint32 litNormalStamp = 0;
+
+// Invalidate the cache : must be called at the start of each draw call
+// as the GTE lighting registers may have changed since the last one
+inline void ResetLitNormals() {
+	litNormalStamp++;
+	if (litNormalStamp == 0) {
+		for (int i = 0; i < LIT_NORMAL_CACHE_SIZE; i++)
+			litNormalCache[i].stamp = 0;
+		litNormalStamp = 1;
+	}
+}
+
+inline void LightNormal(SVECTOR *pNormal, uint32 index, CVECTOR *rgbIn, CVECTOR *rgb0) {
+	SVECTORPC colourEffect;
+	SVECTORPC *effect;
+
+	if (index < LIT_NORMAL_CACHE_SIZE) {
+		LitNormal *lit = &litNormalCache[index];
+		effect = &(lit->colourEffect);
+		if (lit->stamp != litNormalStamp) {
+			if (useLampWidth || useLampBounce)
+				LightPolygonEffect(pNormal + index, effect);
+			else
+				gte_NormalColorEffect_pc(pNormal + index, effect);
+			lit->stamp = litNormalStamp;
+		}
+	} else {
+		effect = &colourEffect;
+		if (useLampWidth || useLampBounce)
+			LightPolygonEffect(pNormal + index, effect);
+		else
+			gte_NormalColorEffect_pc(pNormal + index, effect);
+	}
+
+	ApplyColourEffect(effect, rgbIn, rgb0);
+}
+
+// Check of the lit normal cache : while armed, every vertex colour lit
+// through the cache is also lit by the reference routines and both are
+// folded into a hash which is compared once per frame. Only the lit colours
+// are hashed, not the rendered frame, so rasterisation is not covered
+uint32 litNormalCheckFrames = 0;
+
+static uint32 litNormalCheckHash[2];
+static uint32 litNormalCheckMismatches = 0;
+static uint32 litNormalCheckTotal = 0;
+
+inline void HashLitColour(uint32 *hash, CVECTOR *rgb) {
+	// FNV-1a
+	*hash = (*hash ^ rgb->r) * 16777619;
+	*hash = (*hash ^ rgb->g) * 16777619;
+	*hash = (*hash ^ rgb->b) * 16777619;
+}
+
+static void ResetLitNormalCheckHash() {
+	litNormalCheckHash[0] = 2166136261u;
+	litNormalCheckHash[1] = 2166136261u;
+}
+
+static void CheckLitNormal(SVECTOR *n0, CVECTOR *rgbIn, CVECTOR *rgb0) {
+	CVECTOR ref;
+	LIGHTPOLYGON(n0, rgbIn, &ref);
+	HashLitColour(&litNormalCheckHash[0], rgb0);
+	HashLitColour(&litNormalCheckHash[1], &ref);
+}
+
+static void CheckLitNormal3(SVECTOR *n0, SVECTOR *n1, SVECTOR *n2, CVECTOR *rgbIn, CVECTOR *rgb0, CVECTOR *rgb1, CVECTOR *rgb2) {
+	CVECTOR ref0, ref1, ref2;
+	LIGHTPOLYGON3(n0, n1, n2, rgbIn, &ref0, &ref1, &ref2);
+	HashLitColour(&litNormalCheckHash[0], rgb0);
+	HashLitColour(&litNormalCheckHash[0], rgb1);
+	HashLitColour(&litNormalCheckHash[0], rgb2);
+	HashLitColour(&litNormalCheckHash[1], &ref0);
+	HashLitColour(&litNormalCheckHash[1], &ref1);
+	HashLitColour(&litNormalCheckHash[1], &ref2);
+}
+
+void StartLitNormalCheck(uint32 frames) {
+	litNormalCheckFrames = frames;
+	litNormalCheckMismatches = 0;
+	litNormalCheckTotal = 0;
+	ResetLitNormalCheckHash();
+}
+
+void EndLitNormalCheckFrame() {
+	if (litNormalCheckFrames == 0)
+		return;
+
+	if (litNormalCheckHash[0] != litNormalCheckHash[1]) {
+		warning("Lit vertex colours differ from the reference lighting in frame %d: %08x != %08x", litNormalCheckTotal, litNormalCheckHash[0], litNormalCheckHash[1]);
+		litNormalCheckMismatches++;
+	}
+	litNormalCheckTotal++;
+	ResetLitNormalCheckHash();
+
+	if (--litNormalCheckFrames == 0)
+		warning("Lit normal cache check: %d frames, %d mismatched", litNormalCheckTotal, litNormalCheckMismatches);
+}
+
 //----------------------------------------------------------------
 
 /*
@@ -3052,7 +3173,7 @@ void fastDrawGTS3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex) {
 
 // Fast: no options, Flat, Un-Textured, Lit, triangles
 void fastDrawFUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTOR *pNormal) {
-	SVECTOR *n0;
+	uint32 in0;
 	SVECTORPC *v0;
 	SVECTORPC *v1;
 	SVECTORPC *v2;
@@ -3066,6 +3187,8 @@ void fastDrawFUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 	CVECTOR rgb0;
 	uint32 tmp;
 
+	ResetLitNormals();
+
 	pPoly = polyStart;
 	// Loop over each polygon
 	for (i = 0; i < n; i++) {
@@ -3077,7 +3200,7 @@ void fastDrawFUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 		tmp = *pPoly++;
 		v0 = pVertex + (tmp >> 16);
-		n0 = pNormal + (tmp & 0xFFFF);
+		in0 = tmp & 0xFFFF;
 
 		tmp = *pPoly++;
 		v2 = pVertex + (tmp >> 16);
@@ -3111,7 +3234,9 @@ void fastDrawFUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 			continue;
 
 		// Do the flat lighting computation
-		LIGHTPOLYGON(n0, rgbIn, &rgb0);
+		LightNormal(pNormal, in0, rgbIn, &rgb0);
+		if (litNormalCheckFrames)
+			CheckLitNormal(pNormal + in0, rgbIn, &rgb0);
 
 		// Draw untextured polygons
 		POLY_F3 *poly = (POLY_F3 *)drawpacket;
@@ -3142,9 +3267,9 @@ void fastDrawFUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 // Fast: no options, Gouraud, Un-Textured, Lit, triangles
 void fastDrawGUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTOR *pNormal) {
-	SVECTOR *n0;
-	SVECTOR *n1;
-	SVECTOR *n2;
+	uint32 in0;
+	uint32 in1;
+	uint32 in2;
 	SVECTORPC *v0;
 	SVECTORPC *v1;
 	SVECTORPC *v2;
@@ -3161,6 +3286,8 @@ void fastDrawGUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 	CVECTOR rgbIn = {128, 128, 128, 0};
 	CVECTOR rgb0, rgb1, rgb2;
 
+	ResetLitNormals();
+
 	pPoly = polyStart;
 	// Loop over each polygon
 	for (i = 0; i < n; i++) {
@@ -3180,15 +3307,15 @@ void fastDrawGUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 		tmp = *pPoly++;
 		v0 = pVertex + (tmp >> 16);
-		n0 = pNormal + (tmp & 0xFFFF);
+		in0 = tmp & 0xFFFF;
 
 		tmp = *pPoly++;
 		v1 = pVertex + (tmp >> 16);
-		n1 = pNormal + (tmp & 0xFFFF);
+		in1 = tmp & 0xFFFF;
 
 		tmp = *pPoly++;
 		v2 = pVertex + (tmp >> 16);
-		n2 = pNormal + (tmp & 0xFFFF);
+		in2 = tmp & 0xFFFF;
 
 		// Now do RotTransPers3 on the vectors
 		// z0 = RotTransPers3( v0, v1, v2, &sxy0, &sxy1, &sxy2, &p, &flag );
@@ -3219,7 +3346,11 @@ void fastDrawGUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 		// Do the full gouraud computation
 		// NormalColorCol3( n0, n1, n2, &rgbIn, &rgb0, &rgb1, &rgb2 );
-		LIGHTPOLYGON3(n0, n1, n2, &rgbIn, &rgb0, &rgb1, &rgb2);
+		LightNormal(pNormal, in0, &rgbIn, &rgb0);
+		LightNormal(pNormal, in1, &rgbIn, &rgb1);
+		LightNormal(pNormal, in2, &rgbIn, &rgb2);
+		if (litNormalCheckFrames)
+			CheckLitNormal3(pNormal + in0, pNormal + in1, pNormal + in2, &rgbIn, &rgb0, &rgb1, &rgb2);
 
 		POLY_G3 *poly = (POLY_G3 *)drawpacket;
 		// Draw untextured polygons
@@ -3250,7 +3381,7 @@ void fastDrawGUL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 // Fast: no options, Flat, Textured, Lit Triangles
 void fastDrawFTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTOR *pNormal) {
-	SVECTOR *n0;
+	uint32 in0;
 	SVECTORPC *v0;
 	SVECTORPC *v1;
 	SVECTORPC *v2;
@@ -3270,6 +3401,8 @@ void fastDrawFTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 	CVECTOR rgbIn = {128, 128, 128, 0};
 	CVECTOR rgb0;
 
+	ResetLitNormals();
+
 	pPoly = polyStart;
 	// Loop over each polygon
 	for (i = 0; i < n; i++) {
@@ -3298,7 +3431,7 @@ void fastDrawFTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 		tmp = *pPoly++;
 		v0 = pVertex + (tmp >> 16);
-		n0 = pNormal + (tmp & 0xFFFF);
+		in0 = tmp & 0xFFFF;
 
 		tmp = *pPoly++;
 		v1 = pVertex + (tmp & 0xFFFF);
@@ -3333,7 +3466,9 @@ void fastDrawFTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 		// Do the full gouraud computation
 		// NormalColorCol( n0, &rgbIn, &rgb0 );
-		LIGHTPOLYGON(n0, &rgbIn, &rgb0);
+		LightNormal(pNormal, in0, &rgbIn, &rgb0);
+		if (litNormalCheckFrames)
+			CheckLitNormal(pNormal + in0, &rgbIn, &rgb0);
 
 		POLY_FT3 *poly = (POLY_FT3 *)drawpacket;
 		setPolyFT3(poly);
@@ -3360,9 +3495,9 @@ void fastDrawFTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 // Fast : no options : Gouraud, Textured, Lit Triangles
 void fastDrawGTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTOR *pNormal) {
-	SVECTOR *n0;
-	SVECTOR *n1;
-	SVECTOR *n2;
+	uint32 in0;
+	uint32 in1;
+	uint32 in2;
 	SVECTORPC *v0;
 	SVECTORPC *v1;
 	SVECTORPC *v2;
@@ -3403,6 +3538,8 @@ void fastDrawGTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 	POLY_GT3 *poly;
 	uint32 *pPoly;
 
+	ResetLitNormals();
+
 	pPoly = polyStart;
 	// Loop over each polygon
 	for (i = 0; i < n; i++) {
@@ -3428,15 +3565,15 @@ void fastDrawGTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 
 		vt0 = *(pPoly++);
 		v0 = (pVertex + (vt0 >> 16));
-		n0 = (pNormal + (vt0 & 0xFFFF));
+		in0 = vt0 & 0xFFFF;
 
 		vt1 = *(pPoly++);
 		v1 = (pVertex + (vt1 >> 16));
-		n1 = (pNormal + (vt1 & 0xFFFF));
+		in1 = vt1 & 0xFFFF;
 
 		vt2 = *(pPoly++);
 		v2 = (pVertex + (vt2 >> 16));
-		n2 = (pNormal + (vt2 & 0xFFFF));
+		in2 = vt2 & 0xFFFF;
 
 		// The vertices have been pre-transformed into screen space and stored in the vertex pool
 		// The flag value is set to 0x8000 or 0 in the pad structure
@@ -3466,7 +3603,11 @@ void fastDrawGTL3PC(uint32 *polyStart, const u_int n, SVECTORPC *pVertex, SVECTO
 			continue;
 
 		// Do the full gouraud computation
-		LIGHTPOLYGON3(n0, n1, n2, &rgbIn, &rgb0, &rgb1, &rgb2);
+		LightNormal(pNormal, in0, &rgbIn, &rgb0);
+		LightNormal(pNormal, in1, &rgbIn, &rgb1);
+		LightNormal(pNormal, in2, &rgbIn, &rgb2);
+		if (litNormalCheckFrames)
+			CheckLitNormal3(pNormal + in0, pNormal + in1, pNormal + in2, &rgbIn, &rgb0, &rgb1, &rgb2);
 
 		// Try to overlap this with the LIGHTPOLYGON3 !
 		poly = (POLY_GT3 *)drawpacket;
@@ -38,6 +38,15 @@ extern CVECTOR unlitPoly;
 extern unsigned int _drawBface;
 extern unsigned int deadObject;
 
+// Frames left to compare the lit normal cache against the reference lighting
+extern uint32 litNormalCheckFrames;
+
+// Arm the lit normal cache check for a number of frames
+void StartLitNormalCheck(uint32 frames);
+
+// Compare the hashes of the colours lit this frame : called once per frame
+void EndLitNormalCheckFrame();
+
 #if CD_MODE == 0
 
 // Draw a cuboid
@@ -26,6 +26,7 @@
  */
 
 #include "engines/icb/icb.h"
+#include "engines/icb/debugger.h"
 
 #include "common/config-manager.h"
 #include "common/events.h"
@@ -46,6 +47,7 @@ IcbEngine::IcbEngine(OSystem *syst, const ADGameDescription *gameDesc) : Engine(
 	_mixer->setVolumeForSoundType(Audio::Mixer::kMusicSoundType, ConfMan.getInt("music_volume"));
 	_randomSource = new Common::RandomSource("icb");
 	g_icb = this;
+	setDebugger(new Debugger());
 	(void)_gameDescription; // silence warning
 }
 
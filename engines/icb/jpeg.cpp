@@ -62,7 +62,8 @@ void JpegDecoder::Initialize() {
 
 	scan_components = new JpegDecoderComponent *[JpegMaxComponentsPerScan];
 
-	bit_position = 0;
+	bit_buffer = 0;
+	bit_count = 0;
 }
 
 void JpegDecoder::ReadMarker() {
@@ -262,6 +263,9 @@ void JpegDecoder::ReadSequentialNonInterleavedScan() {
 			scan_components[0]->DecodeSequential(*this, row, col);
 		}
 	}
+
+	// Markers are read byte by byte from here on
+	FlushBits();
 }
 
 void JpegDecoder::ResetDcDifferences() {
@@ -281,9 +285,8 @@ void JpegDecoder::ReadImage(unsigned char *inputData, uint32 surface_Id) {
 	eoi_found = false;
 	sof_found = false;
 
-	_bit_count = 0;
-	_buf_pointer = (uint32 *)input_buffer;
-	_end_buf = (uint32 *)(input_buffer + (1024 * 1024)); // blantantly wrong... need to make cash sized buffer
+	bit_buffer = 0;
+	bit_count = 0;
 
 	data = ReadByte();
 	while (!eoi_found) {
@@ -319,27 +322,13 @@ void JpegDecoder::FreeAllocatedResources() {
 
 int JpegDecoder::cGetBit() {
 	// Section F.2.2.5 Figure F.18.
-	// CNT is called bitposition
-	// B is called bitdata
-	if (bit_position == 0) {
-		// We are out of data so read the next byte from the input stream.
-		bit_data = input_buffer[iPos++];
-
-		// Reset the bit read position starting with the highest order bit. We
-		// read high to low.
-		bit_position = sizeof(bit_data) << 3;
-
-		// The value FF is stored as FF00 to distinguish it from markers.
-		// So this bit of code skips the following 0x00 after the 0xff
-		//          if (bit_data == 0xFF)
-		//              iPos++;
-	}
+	// The bit buffer is refilled a byte at a time, reading high to low.
+	// Unlike standard JPEG, the 0xFF bytes of the entropy coded data are
+	// not followed by a stuffed 0x00 in these files.
+	EnsureBits(1);
 
-	// Consume one bit of the input.
-	--bit_position;
-
-	// Shift the value to the low order bit position.
-	uint8 result = (uint8)((bit_data >> bit_position) & 1);
+	int result = PeekBits(1);
+	SkipBits(1);
 
 	return result;
 }
@@ -351,11 +340,14 @@ int JpegDecoder::NextBit() {
 
 // Extracts the next "count" bits from the input stream.
 int JpegDecoder::Receive(unsigned int count) {
-	int result = 0;
-	for (unsigned int ii = 0; ii < count; ++ii) {
-		result <<= 1;
-		result |= cGetBit();
-	}
+	if (count == 0)
+		return 0;
+
+	EnsureBits(count);
+
+	int result = PeekBits(count);
+	SkipBits(count);
+
 	return result;
 }
 
@@ -425,6 +417,18 @@ void JpegHuffmanDecoder::MakeTable(uint8 huffbits[JpegMaxHuffmanCodeLength]) {
 		}
 	}
 
+	// Build the lookahead tables. A code of length N shorter than the
+	// lookahead is the prefix of 2 ^ (lookahead - N) table entries.
+	memset(lookahead_length, 0, sizeof(lookahead_length));
+	for (kk = 0; huffsizes[kk] != 0 && huffsizes[kk] <= JpegHuffmanLookaheadBits; ++kk) {
+		unsigned int shift = JpegHuffmanLookaheadBits - huffsizes[kk];
+		unsigned int first = huffcodes[kk] << shift;
+		for (jj = 0; jj < (1u << shift); ++jj) {
+			lookahead_length[first + jj] = (uint8)huffsizes[kk];
+			lookahead_value[first + jj] = huff_values[kk];
+		}
+	}
+
 	// Section F.2.2. Figure F.15
 	// Create three arrays.
 	// mincode [n] : The smallest Huffman code of length n + 1.
@@ -455,17 +459,34 @@ int JpegHuffmanDecoder::Decode(JpegDecoder &decoder) {
 	// This function decodes the next byte in the input stream using this
 	// Huffman table.
 
-	// Section A F.2.2.3 Figure F.16
+	// Most codes are short enough to be decoded with a single lookup
+	decoder.EnsureBits(JpegHuffmanLookaheadBits);
+	unsigned int lookahead = decoder.PeekBits(JpegHuffmanLookaheadBits);
+	unsigned int length = lookahead_length[lookahead];
+	if (length != 0) {
+		decoder.SkipBits(length);
+		return lookahead_value[lookahead];
+	}
 
-	uint16 code = (uint16)decoder.NextBit();
-	int codelength; // Called I in the standard.
+	// The longer codes all start with the lookahead bits
+	decoder.SkipBits(JpegHuffmanLookaheadBits);
+	return DecodeSlow(decoder, (uint16)lookahead, JpegHuffmanLookaheadBits - 1);
+}
+
+int JpegHuffmanDecoder::DecodeSlow(JpegDecoder &decoder, uint16 code, int codelength) {
+	// Section A F.2.2.3 Figure F.16
+	// codelength is called I in the standard.
 
 	// Here we are taking advantage of the fact that 1 bits are used as
 	// a prefix to the longer codes.
-	for (codelength = 0; (code > maxcode[codelength] && codelength < JpegMaxHuffmanCodeLength); ++codelength) {
+	for (; codelength < (int)JpegMaxHuffmanCodeLength && code > maxcode[codelength]; ++codelength) {
 		code = (uint16)((code << 1) | decoder.NextBit());
 	}
 
+	// Invalid code, the input data is corrupt
+	if (codelength >= (int)JpegMaxHuffmanCodeLength)
+		return 0;
+
 	// Now we have a Huffman code of length (codelength + 1) that
 	// is somewhere in the range
 	// mincode [codelength]..maxcode [codelength].
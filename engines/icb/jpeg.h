@@ -8,16 +8,6 @@ namespace ICB {
 
 class _surface;
 
-static uint32 _bit_count;
-static uint32 *_buf_pointer;
-static uint32 *_end_buf;
-
-#ifdef _WIN32
-static __int64 safeMM0 = 0;
-#else
-static __int64_t safeMM0 = 0;
-#endif
-
 const int JpegMaxHuffmanTables = 4;
 const int MaxQuantizationTables = 4;
 const int JpegMaxComponentsPerFrame = 255;
@@ -35,6 +25,7 @@ const int JpegMax8BitQuantizationValue = 255;
 const int JpegMinQuantizationValue = 1;
 const unsigned int JpegMaxHuffmanCodeLength = 16;
 const unsigned int JpegMaxNumberOfHuffmanCodes = 256;
+const unsigned int JpegHuffmanLookaheadBits = 9;
 extern const unsigned int JpegZigZagInputOrderCodes[JpegSampleSize];
 extern const unsigned int JpegZigZagOutputOrderCodes[JpegSampleSize];
 typedef int16 JpegDecoderCoefficientBlock[JpegSampleWidth][JpegSampleWidth];
@@ -141,17 +132,41 @@ public:
 	inline uint8 ReadByte() {
 		uint8 value = input_buffer[iPos];
 		iPos += sizeof(uint8);
-		bit_position = 0;
 		return value;
 	}
 
 	inline uint16 ReadWord() {
-		bit_position = 0;
 		uint16 value = *((uint16 *)(&input_buffer[iPos]));
 		iPos += sizeof(uint16);
 		return value;
 	}
 
+	// Make sure at least "count" (up to 25) bits are in the bit buffer.
+	// Bytes are only fetched when needed so we never read further than
+	// the end of the entropy coded data and the marker following it.
+	inline void EnsureBits(int count) {
+		while (bit_count < count) {
+			bit_buffer |= (uint32)input_buffer[iPos++] << (24 - bit_count);
+			bit_count += 8;
+		}
+	}
+
+	// Returns the next "count" (1 to 25) bits without consuming them.
+	inline unsigned int PeekBits(int count) const { return bit_buffer >> (32 - count); }
+
+	inline void SkipBits(int count) {
+		bit_buffer <<= count;
+		bit_count -= count;
+	}
+
+	// Give back the whole bytes still in the bit buffer at the end of
+	// the entropy coded data, and discard the remaining bits.
+	inline void FlushBits() {
+		iPos -= bit_count >> 3;
+		bit_buffer = 0;
+		bit_count = 0;
+	}
+
 	int NextBit();
 	int Receive(unsigned int count);
 
@@ -176,9 +191,9 @@ public:
 	// Quantization tables
 	JpegDecoderQuantizationTable *quantization_tables;
 
-	// Bit I/O state
-	int bit_position;       // Called CNT in Section F.2.2.5
-	unsigned char bit_data; // Called B in Section F.2.2.5
+	// Bit I/O state. The next bit to read is the most significant one.
+	uint32 bit_buffer;
+	int bit_count;
 
 	bool eoi_found;
 	bool sof_found;
@@ -230,6 +245,10 @@ public:
 	// Function to decode the next value in the input stream.
 	int Decode(JpegDecoder &);
 
+	// Function to decode the next value in the input stream one bit
+	// at a time, once the first "codelength" + 1 bits are in "code".
+	int DecodeSlow(JpegDecoder &, uint16 code, int codelength);
+
 	// This function builds the structures needed for Huffman
 	// decoding after the table data has been read.
 	void MakeTable(uint8 huffbits[JpegMaxHuffmanCodeLength]);
@@ -242,6 +261,12 @@ public:
 	uint8 valptr[JpegMaxHuffmanCodeLength];
 	// Huffman values
 	uint8 huff_values[JpegMaxNumberOfHuffmanCodes];
+
+	// Lookup tables indexed by the next JpegHuffmanLookaheadBits bits of
+	// input, for the codes which are no longer than that. A length of
+	// zero means the code is longer and has to be decoded bit by bit.
+	uint8 lookahead_length[1 << JpegHuffmanLookaheadBits];
+	uint8 lookahead_value[1 << JpegHuffmanLookaheadBits];
 };
 
 //  Title:  JPEG Decoder Quantization Table Class Implementation
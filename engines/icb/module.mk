@@ -19,6 +19,7 @@ MODULE_OBJS := \
 	console_pc.o \
 	custom_logics.o \
 	debug.o \
+	debugger.o \
 	debug_pc.o \
 	detection.o \
 	direct_input.o \
@@ -406,7 +406,7 @@ void InitEngine(const char *lpCmdLine) {
 	Memory_stats();
 
 	// Animations
-	rs1 = new res_man(ANIMATION_BUFFER_SIZE, false); // TODO: Should be true, but threads are broken atm.
+	rs1 = new res_man(ANIMATION_BUFFER_SIZE, true);
 	rs1->Set_auto_timeframe_advance();
 	rs_anims = rs1;
 
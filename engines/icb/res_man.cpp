@@ -65,61 +65,108 @@ int16 res_man::Find_space(uint32 len) {
 
 	// gets block into correct size and adjusts child downward if free or spawns a space
 
-	int16 cur_block = 0;
+	int16 cur_block;
 	uint32 slack;
 	int16 child;
 	uint16 spawn;
 
-	do {
-		if (mem_list[cur_block].state == MEM_free) { // is current block a free block?
-			if (mem_list[cur_block].size > len) {
-				//                              free block is bigger than required so split it
+	// try the smallest free blocks known to be big enough first
+	cur_block = FindFreeHint(len);
 
-				child = mem_list[cur_block].child;
-				slack = mem_list[cur_block].size - len;
-
-				mem_list[cur_block].size = len;
-				total_free_memory -= len; // adjust total free
-
-				if (child == -1) { // this is last block - so spawn the gap
-					spawn = Fetch_spawn(cur_block); // spawn a new MEM_free block
-
-					mem_list[cur_block].child = spawn; // our new baby
-					mem_list[spawn].child = -1; // spawned becomes the new end block
-					mem_list[spawn].size = slack; //
-					mem_list[spawn].ad = mem_list[cur_block].ad + len;
-
-					return (cur_block);
-				} else if (mem_list[child].state == MEM_free) { // merge the free child downwards into the new void
-					mem_list[child].ad -= slack; // address moves down
-					mem_list[child].size += slack; // size goes up
-					return (cur_block);
-				} else if (mem_list[child].state == MEM_in_use) { // we must spawn a new block to span the new void
-					spawn = Fetch_spawn(cur_block); // spawn a new MEM_free block
-
-					mem_list[cur_block].child = spawn; // our new baby
-					mem_list[spawn].child = child; // spawned is our child and our previous child becomes its child
-					mem_list[child].parent = spawn; // our old child get our new child as its parent
-					mem_list[spawn].size = slack; // spans the void
-					mem_list[spawn].ad = mem_list[cur_block].ad + len;
-
-					return (cur_block);
-				} else { // error
-					Fatal_error("ERROR: Illegal child found by Find_space [file=%s line=%u]", __FILE__, __LINE__);
-				}
+	if (cur_block == -1) {
+		cur_block = 0;
+		do {
+			if ((mem_list[cur_block].state == MEM_free) && (mem_list[cur_block].size >= len)) // is current block a big enough free block?
+				break;
 
-			} else if (mem_list[cur_block].size == len) { // right size - its a miracle
-				//                              we can use this block
+			cur_block = mem_list[cur_block].child; // move to next one along, the current must be floating, locked, or a NULL slot
+		} while (cur_block != -1); // just got next block but the current was the end block
 
-				total_free_memory -= len; // adjust total free
+		if (cur_block == -1)
+			return ((int16)-1);
+	}
 
-				return (cur_block); // this block is big enough - return its id
-			}
+	if (mem_list[cur_block].size > len) {
+		//                              free block is bigger than required so split it
+
+		child = mem_list[cur_block].child;
+		slack = mem_list[cur_block].size - len;
+
+		mem_list[cur_block].size = len;
+		total_free_memory -= len; // adjust total free
+
+		if (child == -1) { // this is last block - so spawn the gap
+			spawn = Fetch_spawn(cur_block); // spawn a new MEM_free block
+
+			mem_list[cur_block].child = spawn; // our new baby
+			mem_list[spawn].child = -1; // spawned becomes the new end block
+			mem_list[spawn].size = slack; //
+			mem_list[spawn].ad = mem_list[cur_block].ad + len;
+			AddFreeHint(spawn);
+
+			return (cur_block);
+		} else if (mem_list[child].state == MEM_free) { // merge the free child downwards into the new void
+			mem_list[child].ad -= slack; // address moves down
+			mem_list[child].size += slack; // size goes up
+			AddFreeHint(child);
+			return (cur_block);
+		} else if (mem_list[child].state == MEM_in_use) { // we must spawn a new block to span the new void
+			spawn = Fetch_spawn(cur_block); // spawn a new MEM_free block
+
+			mem_list[cur_block].child = spawn; // our new baby
+			mem_list[spawn].child = child; // spawned is our child and our previous child becomes its child
+			mem_list[child].parent = spawn; // our old child get our new child as its parent
+			mem_list[spawn].size = slack; // spans the void
+			mem_list[spawn].ad = mem_list[cur_block].ad + len;
+			AddFreeHint(spawn);
+
+			return (cur_block);
+		} else { // error
+			Fatal_error("ERROR: Illegal child found by Find_space [file=%s line=%u]", __FILE__, __LINE__);
 		}
-		cur_block = mem_list[cur_block].child; // move to next one along, the current must be floating, locked, or a NULL slot
+	}
 
-	} while (cur_block != -1); // just got next block but the current was the end block
+	//                              right size - its a miracle
+	//                              we can use this block
+	total_free_memory -= len; // adjust total free
 
+	return (cur_block); // this block is big enough - return its id
+}
+
+// Remember a free block so Find_space doesn't have to walk the whole pool
+void res_man::AddFreeHint(int16 block) {
+	int32 c = FreeClass(mem_list[block].size);
+
+	// if the class is full the block can still be found the slow way
+	if (num_free_hints[c] < RM_FREE_HINTS)
+		free_hints[c][num_free_hints[c]++] = block;
+}
+
+// Find a free block of at least len bytes from the hints
+// starting with the smallest size class that could hold it
+int16 res_man::FindFreeHint(uint32 len) {
+	int32 c, i;
+	int16 block;
+
+	for (c = FreeClass(len); c < RM_FREE_CLASSES; c++) {
+		i = num_free_hints[c];
+		while (i > 0) {
+			i--;
+			block = free_hints[c][i];
+
+			// the block has been used or merged since : forget it
+			if (mem_list[block].state != MEM_free) {
+				free_hints[c][i] = free_hints[c][--num_free_hints[c]];
+				continue;
+			}
+
+			if (mem_list[block].size >= len) {
+				// whatever is left over after the split is hinted again
+				free_hints[c][i] = free_hints[c][--num_free_hints[c]];
+				return block;
+			}
+		}
+	}
 	return ((int16)-1);
 }
 
@@ -154,10 +201,6 @@ uint16 res_man::Fetch_spawn(uint16 parent) {
 void res_man::Defrag() {
 	// probably just enough space exists so do a total defrag
 
-	int16 cur_block = 0;
-	uint32 temp;
-	int16 child, grandchild;
-
 	bool8 debug_state = zdebug;
 #ifdef _PSX
 #else
@@ -167,11 +210,37 @@ void res_man::Defrag() {
 	Tdebug("defrag.txt", "\ndefrag");
 
 	amount_of_defrags++;
+	total_defrags++;
 
 	// just to be on the safe side, finish all async stuff, we can't risk any async going to addresses we are moving about...
 
 	async_flush();
 
+	uint32 time = g_system->getMillis();
+
+	// nothing can be moved more than once so this compacts the whole pool
+	Compact(total_pool);
+
+	time = g_system->getMillis() - time;
+	defrag_time += time;
+	if (time > max_defrag_time)
+		max_defrag_time = time;
+
+	zdebug = debug_state;
+}
+
+uint32 res_man::Compact(uint32 max_bytes) {
+	// float the free space to the top moving at most max_bytes of resources
+	// blocks still being loaded by the async loader stop the compaction
+
+	int16 cur_block = 0;
+	uint32 temp;
+	uint32 moved = 0;
+	int16 child, grandchild;
+
+	if (no_defrag)
+		return 0;
+
 	do {
 
 		Tdebug("defrag.txt", "\nlooking at bloc %d", cur_block);
@@ -184,8 +253,7 @@ void res_man::Defrag() {
 			//                      end found? yes then finish
 			if (mem_list[cur_block].child == -1) {
 				Tdebug("defrag.txt", "  we are end - so end");
-				zdebug = debug_state;
-				return;
+				break;
 			}
 
 			//       is our child also free
@@ -211,8 +279,7 @@ void res_man::Defrag() {
 				// we could now be end block
 				if (mem_list[cur_block].child == -1) {
 					Tdebug("defrag.txt", "   our new child is end - so end");
-					zdebug = debug_state;
-					return;
+					break;
 				}
 				// if not then next HAS to be a MEM-in-use
 				child = mem_list[cur_block].child;
@@ -220,19 +287,22 @@ void res_man::Defrag() {
 
 			//                      is our child in use - i.e. a real resource
 			if (mem_list[child].state == MEM_in_use) {
+				// done enough for now or the child is still being loaded
+				if ((moved >= max_bytes) || (mem_list[child].protect))
+					break;
+
 				Tdebug("defrag.txt", "  child is in use - we swap");
 				//                      ok, child is a normal block - swap it around, so data moves to bottom
 
-				child = mem_list[cur_block].child; // for readability
-
 //                      physically move memory
 #if _PC
-				memcpy(mem_list[cur_block].ad, mem_list[child].ad, mem_list[child].size); // dest, src, len
+				memmove(mem_list[cur_block].ad, mem_list[child].ad, mem_list[child].size); // dest, src, len
 #endif
 #if _PSX
 				// Copy 8 bytes at a time
 				memcpy((uint32 *)mem_list[cur_block].ad, (uint32 *)mem_list[child].ad, mem_list[child].size);
 #endif
+				moved += mem_list[child].size;
 
 				mem_list[cur_block].state = MEM_in_use; // we now have memory
 				mem_list[child].state = MEM_free; // child is now free
@@ -240,6 +310,12 @@ void res_man::Defrag() {
 				mem_list[cur_block].url_hash = mem_list[child].url_hash;
 				mem_list[cur_block].cluster_hash = mem_list[child].cluster_hash;
 				mem_list[cur_block].total_hash = mem_list[child].total_hash;
+				mem_list[cur_block].protect = 0;
+
+				// the child no longer holds the file so lookups must not find it there
+				mem_list[child].url_hash = NULL_HASH;
+				mem_list[child].cluster_hash = NULL_HASH;
+				mem_list[child].total_hash = NULL_HASH;
 
 				// we get the age of the child block
 				mem_list[cur_block].age = mem_list[child].age;
@@ -252,16 +328,38 @@ void res_man::Defrag() {
 				//                      reset address of child
 				mem_list[child].ad = mem_list[cur_block].ad + mem_list[cur_block].size;
 			} else
-				Fatal_error("defrag confused! child is %d");
+				Fatal_error("defrag confused! child is %d", child);
 		}
 
 		cur_block = mem_list[cur_block].child; // move to next one along, the current must be floating, locked, or a NULL slot
 	} while (cur_block != -1); // just got next block but the current was the end block
 
 	Tdebug("defrag.txt", "got to end");
-	zdebug = debug_state;
 
-	// finished - should be done.
+	// the free space we have gathered up
+	if ((cur_block != -1) && (mem_list[cur_block].state == MEM_free))
+		AddFreeHint(cur_block);
+
+	compacted_bytes += moved;
+
+	return moved;
+}
+
+int16 res_man::Compact_for_space(uint32 len) {
+	// move resources down a bit at a time until there is a free block of len bytes
+	// only when that doesn't work (blocks still being loaded are in the way) do a full defrag
+
+	int16 search;
+
+	while (Compact()) {
+		if ((search = Find_space(len)) != -1) {
+			amount_of_defrags++;
+			return search;
+		}
+	}
+
+	Defrag();
+	return Find_space(len);
 }
 
 void res_man::Initialise(uint32 memory_tot, uint32 threadFlag) {
@@ -283,12 +381,19 @@ void res_man::Initialise(uint32 memory_tot, uint32 threadFlag) {
 		hasThread = 0;
 
 	amount_of_defrags = 0;
+	total_defrags = 0;
+	defrag_time = 0;
+	max_defrag_time = 0;
+	compacted_bytes = 0;
 
 	Tdebug("resman.txt", "made resman - %d", total_pool);
 }
 //------------------------------------------------------------------------------------
 void res_man::Reset() { // trash all resources
 
+	// make sure nothing is still being loaded into the pool
+	async_flush();
+
 	// set all to unused
 	uint j;
 	for (j = 0; j < max_mem_blocks; j++) {
@@ -313,16 +418,21 @@ void res_man::Reset() { // trash all resources
 
 	//      set to no files currently open
 	number_files_open = 0;
+
+	// the whole pool is one free block
+	for (j = 0; j < RM_FREE_CLASSES; j++)
+		num_free_hints[j] = 0;
+	AddFreeHint(0);
 }
 
 res_man::~res_man() {
 	Zdebug("*resman destructing*");
 
-	delete[] memory_base;
-	delete[] mem_list;
-
 	// close async thread.
 	CloseAsync();
+
+	delete[] memory_base;
+	delete[] mem_list;
 }
 
 uint32 res_man::Fetch_old_memory(int number_of_cycles) {
@@ -353,6 +463,31 @@ uint32 res_man::Fetch_old_memory(int number_of_cycles) {
 	return amount;
 }
 
+void res_man::Fetch_pool_stats(RMPoolStats *stats) {
+	int16 search = 0;
+
+	stats->total_pool = total_pool;
+	stats->free_memory = total_free_memory;
+	stats->largest_free_block = 0;
+	stats->free_blocks = 0;
+	stats->used_blocks = total_blocks;
+	stats->max_blocks = max_mem_blocks;
+	stats->files_open = number_files_open;
+	stats->defrags = total_defrags;
+	stats->defrag_time = defrag_time;
+	stats->max_defrag_time = max_defrag_time;
+	stats->compacted = compacted_bytes;
+
+	do {
+		if (mem_list[search].state == MEM_free) {
+			stats->free_blocks++;
+			if (mem_list[search].size > stats->largest_free_block)
+				stats->largest_free_block = mem_list[search].size;
+		}
+		search = mem_list[search].child;
+	} while (search != -1);
+}
+
 // If hash or cluster_hash == NULL_HASH then the hash of url/cluster_url
 // is computed and stored in hash/cluster_hash
 uint8 *res_man::Res_open(const char *url, uint32 &url_hash, const char *cluster, uint32 &cluster_hash,
@@ -389,9 +524,13 @@ uint8 *res_man::Res_open(const char *url, uint32 &url_hash, const char *cluster,
 // If hash or cluster_hash == NULL_HASH then the hash of url/cluster_url
 // is computed and stored in hash/cluster_hash
 uint8 *res_man::Res_async_open(const char *url, uint32 &url_hash, const char *cluster, uint32 &cluster_hash, int compressed) {
-	// pc does not have async for now (well i know it does but i'm switching it off)
+	// without the loader thread just load it now
 #if _PC
-	return Res_open(url, url_hash, cluster, cluster_hash, compressed);
+	if (!hasThread)
+		return Res_open(url, url_hash, cluster, cluster_hash, compressed);
+
+	// keep the queue moving
+	async_checkArray();
 #endif
 
 	// if this is a cluster then fatal error (cant res_async_open a cluster directly like you can open one)
@@ -442,7 +581,6 @@ res_man::res_man() {
 	max_mem_blocks = 0;
 	mem_list = NULL;
 	hResManMutex = NULL;
-	hRunMutex = NULL;
 }
 
 res_man::res_man(uint32 memory_tot, uint32 threadFlag) {
@@ -455,7 +593,6 @@ res_man::res_man(uint32 memory_tot, uint32 threadFlag) {
 	mem_offset_list = new mem_offset[max_mem_blocks];
 	num_mem_offsets = 0;
 	hResManMutex = NULL;
-	hRunMutex = NULL;
 	warning("res_man constructor");
 	// Setup everything up correctly
 	Initialise(memory_tot, threadFlag);
@@ -498,6 +635,10 @@ void res_man::Res_purge(const char *url, uint32 url_hash, const char *cluster, u
 				mem_list[search].protect = 0;
 			DiscUpdateQueue();
 		}
+#else
+		// the loader must not write into a purged block
+		if (mem_list[search].protect)
+			async_flush();
 #endif
 
 		//  one less file open
@@ -541,9 +682,11 @@ void res_man::Res_purge(const char *url, uint32 url_hash, const char *cluster, u
 			mem_list[search].state = MEM_null; // we're gone and can be used again later
 
 			total_blocks--; // one less block
+			AddFreeHint(parent);
 		} else { // we cant merge into our parent because it isnt free (or we are block 0) so we become
 			// a MEM_free floating block with no file
 			mem_list[search].state = MEM_free; // block remains but is free to be defragged
+			AddFreeHint(search);
 		}
 
 		return;
@@ -661,6 +804,8 @@ void res_man::Res_purge_all() {
 
 	Zdebug("---purging ALL---");
 
+	async_flush();
+
 	search = 0;
 	do {
 		if (mem_list[search].state == MEM_in_use) { // if a used block with a file...
@@ -718,9 +863,11 @@ void res_man::Res_purge_all() {
 				mem_list[search].state = MEM_null; // we're gone and can be used again later
 
 				total_blocks--; // one less block
+				AddFreeHint(parent);
 			} else { // we cant merge into our parent because it isnt free (or we are block 0) so we become
 				// a MEM_free floating block with no file
 				mem_list[search].state = MEM_free; // block remains but is free to be defragged
+				AddFreeHint(search);
 			}
 		}
 
@@ -792,6 +939,20 @@ uint8 *res_man::Internal_open(RMParams *params, int *ret_len) {
 
 			mem_list[search].protect = 0; // no int32er preloading because it's done...
 		}
+#else
+		// if the async loader is still busy with it either wait for it (if mode is now) or return 0x00000000 (if mode is async)
+		if (mem_list[search].protect) {
+			async_checkArray();
+			if (params->mode == RM_ASYNCLOAD) {
+				if (mem_list[search].protect)
+					return (uint8 *)0x00000000; // not finished return 0
+			} else {
+				while (mem_list[search].protect) {
+					async_wait();
+					async_checkArray();
+				}
+			}
+		}
 #endif
 		if (ret_len)
 			*ret_len = mem_list[search].size;
@@ -917,8 +1078,8 @@ uint32 res_man::FindMemBlock(uint32 adj_len, RMParams *params) {
 		//    could not find a big enough single block
 		if ((free_mblocks == 1) && (total_free_memory >= adj_len)) {
 			// enough memory does exist though
-			Defrag(); // float the free space to the top
-			if ((search = Find_space(adj_len)) == -1) {
+			// float the free space to the top
+			if ((search = Compact_for_space(adj_len)) == -1) {
 				Fatal_error("%d MAJOR ERROR mem full after defrag free_mblocks %d total_free_memory %d adj_len %d", id, free_mblocks, total_free_memory, adj_len);
 			}
 
@@ -1056,10 +1217,12 @@ uint32 res_man::FindMemBlock(uint32 adj_len, RMParams *params) {
 							mem_list[search].state = MEM_null; // we're gone and can be used again later
 
 							total_blocks--; // one less block
+							AddFreeHint(parent);
 
 							search = mem_list[parent].child; // continue the search from our parent new child - was ours remember
 						} else { // we cant merge into our parent because it isnt free so we become a MEM_free floating block with no file
 							mem_list[search].state = MEM_free; // block remains but is free to be defragged
+							AddFreeHint(search);
 							search = mem_list[search].child; // move on to the next file
 						}
 					} else { // move to next if current not oldest and free
@@ -1078,10 +1241,10 @@ uint32 res_man::FindMemBlock(uint32 adj_len, RMParams *params) {
 
 			//       ok, we've made enough space
 			Tdebug("make_space.txt", "made space - doing a defrag");
-			Defrag();
+			search = Compact_for_space(adj_len);
 
 			Tdebug("make_space.txt", "done the defrag");
-			if ((search = Find_space(adj_len)) == -1)
+			if (search == -1)
 				Fatal_error("MAJOR ERROR mem full after defrag??");
 
 			Tdebug("make_space.txt", "Find_space %d worked", adj_len);
@@ -77,6 +77,14 @@ extern uint32 MAX_MEM_BLOCKS;
 
 #define MAKE_TOTAL_HASH(c, f) (2 * c + f)
 
+// Free blocks are remembered in power of two size classes starting at 1K
+#define RM_FREE_CLASSES 16
+#define RM_FREE_CLASS_SHIFT 10
+#define RM_FREE_HINTS 32
+
+// How much memory the compactor moves at a time when an allocation finds no big enough block
+#define RM_COMPACT_BYTES (512 * 1024)
+
 typedef struct {
 	uint32 url_hash;     // hash value of the url name
 	uint32 cluster_hash; // hash value of the cluster the url beint32s to
@@ -97,6 +105,21 @@ typedef struct {
 	int32 search;
 } mem_offset;
 
+// Snapshot of the state of the memory pool for debugging
+typedef struct {
+	uint32 total_pool;
+	uint32 free_memory;
+	uint32 largest_free_block;
+	uint32 free_blocks;
+	uint32 used_blocks;
+	uint32 max_blocks;
+	uint32 files_open;
+	uint32 defrags;
+	uint32 defrag_time;     // total ms spent in Defrag
+	uint32 max_defrag_time; // longest Defrag in ms
+	uint32 compacted;       // bytes moved by the compactor
+} RMPoolStats;
+
 // Put the res_man params in a structure to prevent passing lots of the same arguements
 // from function to function
 typedef struct RMParams {
@@ -114,6 +137,7 @@ typedef struct RMParams {
 	int cdpos;
 #else
 	Common::SeekableReadStream *_stream;
+	int packedLen; // size of a zipped file in the cluster for the async loader
 #endif
 	uint8 not_ready_yet; // are not ready yet
 } RMParams;
@@ -135,6 +159,15 @@ class res_man {
 
 	uint32 hasThread;
 
+	// possibly stale free blocks by size class, validated when used
+	int16 free_hints[RM_FREE_CLASSES][RM_FREE_HINTS];
+	uint8 num_free_hints[RM_FREE_CLASSES];
+
+	uint32 total_defrags;
+	uint32 defrag_time;
+	uint32 max_defrag_time;
+	uint32 compacted_bytes;
+
 #ifdef _PC
 	rcActArray<async_PacketType> async_fnArray;
 #endif
@@ -145,11 +178,9 @@ public:
 #ifdef _PC
 	async_PacketType async_data;
 #endif
-	int32 async_loading;
+	int32 async_loading; // 0 = idle, 1 = waiting for the loader, 2 = a chunk is being loaded, 3 = part loaded
 	int32 async_done;
-	//SDL_Thread *hThread; // TODO: Fix threading
 	Common::Mutex *hResManMutex;
-	Common::Mutex *hRunMutex;
 	res_man();
 	res_man(uint32 memory_tot, uint32 threadFlag);
 	res_man(uint8 *base, uint32 size);
@@ -173,7 +204,7 @@ public:
 	int32 async_checkArray();
 	void async_flush();
 #ifdef _PC
-	void async_addFile(const int8 *fn, uint8 *p, int32 size, int32 zipped, int32 memListNo);
+	void async_addFile(const int8 *fn, uint8 *p, int32 size, int32 zipped, int32 memListNo, int32 seekpos, int32 packedSize);
 	void RegisterAsync(const int32 n);
 #endif
 
@@ -218,11 +249,15 @@ public:
 	uint32 Fetch_max_mem_blocks();
 
 	uint32 Fetch_old_memory(int number_of_cycles);
+	void Fetch_pool_stats(RMPoolStats *stats);
 
 	// For testing purposes wanted to call Defrag from console
 	// so made it public function
 	void Defrag();
 
+	// Move at most max_bytes of resources down into the free space, returns the amount moved
+	uint32 Compact(uint32 max_bytes = RM_COMPACT_BYTES);
+
 	// To aid debugging messages
 	inline void Id(int newId);
 	inline int Id();
@@ -257,6 +292,10 @@ public:
 	uint8 *LoadFile(int32 &cluster_search, RMParams *params);
 
 	int16 Find_space(uint32 len);
+	int16 Compact_for_space(uint32 len);
+	inline int32 FreeClass(uint32 len);
+	void AddFreeHint(int16 block);
+	int16 FindFreeHint(uint32 len);
 	uint16 Fetch_spawn(uint16 parent);
 	void OpenAsync();
 	void CloseAsync();
@@ -265,6 +304,9 @@ public:
 	//              async
 	async_PacketType async_shiftArray();
 	void async_setLoading(async_PacketType s);
+	void async_wait();
+
+	pxString ClusterPath(const char *cluster);
 #endif
 
 	bool8 auto_time_advance; // if true then time stamp is automatically imcremented as a file is opened
@@ -311,6 +353,18 @@ inline int32 res_man::FindMemSearch(uint32 total_hash) { // returns a search fil
 		return mem_offset_list[i].search;
 }
 
+// size class for the free block hints
+inline int32 res_man::FreeClass(uint32 len) {
+	int32 c = 0;
+
+	len >>= RM_FREE_CLASS_SHIFT;
+	while ((len > 1) && (c < RM_FREE_CLASSES - 1)) {
+		len >>= 1;
+		c++;
+	}
+	return c;
+}
+
 inline uint8 *res_man::Get_memory_base() {
 	return memory_base;
 }
@@ -65,6 +65,8 @@
 #include "common/textconsole.h"
 #include "common/config-manager.h"
 #include "common/memstream.h"
+#include "common/timer.h"
+#include "common/zlib.h"
 namespace ICB {
 
 #ifdef _PC
@@ -122,100 +124,174 @@ FILE *openDiskFileForBinaryWrite(const char *filename) {
 	}
 }
 
-// Thread procedure take files and load them
-int async_loadThread(void *v) {
-	FILE *in;
-	res_man *rm = (res_man *)v;
+// Only one resource manager can own the loader timer proc
+static res_man *async_resMan = NULL;
+
+// How much the loader reads or inflates per step, so the timer thread
+// it shares with the sound isn't held up by large files
+#define ASYNC_CHUNK_SIZE (64 * 1024)
+
+// The file being loaded : it is loaded a chunk at a time
+typedef struct {
+	FILE *file;
+	uint8 *packed;                         // the compressed data of a zipped file
+	int32 packedRead;                      // how much of packed has been read
+	Common::SeekableReadStream *zipStream; // inflates packed
+	int32 done;                            // how much of the file is in the pool
+	pxString error;                        // reported by the game thread
+} async_LoadState;
+
+static async_LoadState async_state;
+
+static void async_closeLoad() {
+	if (async_state.file)
+		fclose(async_state.file);
+	free(async_state.packed);
+	delete async_state.zipStream;
+	async_state.file = NULL;
+	async_state.packed = NULL;
+	async_state.zipStream = NULL;
+}
 
-	int8 *fn = NULL;
-	uint8 *p;
-	int32 z;
-	int32 size;
-	int32 newSize;
+// Do the next chunk of the file, returns TRUE8 when it is done
+static bool8 async_loadChunk(async_PacketType &packet) {
+	if (async_state.file == NULL) {
+		async_state.file = openDiskFileForBinaryRead(packet.fn.c_str());
+		if ((async_state.file == NULL) || (fseek(async_state.file, packet.seekpos, SEEK_SET) != 0)) {
+			async_state.error.Format("ASYNC: Could not fseek to %d bytes in %s", packet.seekpos, packet.fn.c_str());
+			return TRUE8;
+		}
+		if (packet.zipped)
+			async_state.packed = (uint8 *)malloc(packet.packedSize);
+	}
 
-	Zdebug(100, "ASYNC: Thread active...\n");
-	for (;;) {
-		g_system->delayMillis(10); // Sleep(10);
-		rm->hResManMutex->lock(); // if ( WaitForSingleObject(rm->hResManMutex,INFINITE)!=WAIT_TIMEOUT )
-		{
-			if (rm->async_loading == 1) {
-				z = rm->async_data.zipped;
-				fn = new int8[1 + strlen(rm->async_data.fn)];
-				strcpy((char *)fn, rm->async_data.fn);
-				p = rm->async_data.p;
-				size = rm->async_data.size;
-
-				rm->hResManMutex->unlock(); // ReleaseMutex(rm->hResManMutex);
-
-				if (z)
-					memUncompress(p, (const char *)fn); // TODO: Use wrapCompressedStream to solve?
-				else {
-					uint32 timer = g_system->getMillis();
-					in = openDiskFileForBinaryRead((char *)fn);
-					newSize = size;
-					while (newSize != 0) {
-						if (newSize > 1024) {
-							fread(p, 1, 1024, in);
-							p += 1024;
-							newSize -= 1024;
-						} else {
-							fread(p, 1, newSize, in);
-							p += newSize;
-							newSize = 0;
-						}
-					}
-					fclose(in);
-
-					timer = g_system->getMillis() - timer;
-					Zdebug(100, "%d", timer);
-				}
-
-				rm->hResManMutex->lock(); // WaitForSingleObject(rm->hResManMutex,INFINITE);
-				rm->async_loading = 0;
-				rm->async_done = 1;
-				rm->hResManMutex->unlock(); // ReleaseMutex(rm->hResManMutex);
-
-			} else {
-				rm->hResManMutex->unlock(); // ReleaseMutex(rm->hResManMutex);
-
-				//				if (SDL_TryLockMutex(rm->hRunMutex) != SDL_MUTEX_TIMEDOUT) { //if ( WaitForSingleObject(rm->hRunMutex,0)!=WAIT_TIMEOUT
-				//)
-				rm->hRunMutex->lock(); // TODO: Fix this.
-				{
-					if (fn)
-						delete[] fn;
-
-					Zdebug("ASYNC: thread ending...\n");
-					return 0;
-				}
-			}
+	// Read in the compressed data, then inflate it into the pool
+	if ((packet.zipped) && (async_state.packedRead < packet.packedSize)) {
+		int32 len = MIN<int32>(ASYNC_CHUNK_SIZE, packet.packedSize - async_state.packedRead);
+		if (fread(async_state.packed + async_state.packedRead, 1, len, async_state.file) != (size_t)len) {
+			async_state.error.Format("ASYNC: Failed to read %d bytes from %s", packet.packedSize, packet.fn.c_str());
+			return TRUE8;
 		}
+		async_state.packedRead += len;
+		if (async_state.packedRead < packet.packedSize)
+			return FALSE8;
+
+		// The uncompressed length is stored before the data
+		async_state.zipStream = Common::wrapCompressedReadStream(new Common::MemoryReadStream(async_state.packed, packet.packedSize, DisposeAfterUse::YES));
+		async_state.packed = NULL;
+		if ((int32)async_state.zipStream->readUint32LE() != packet.size) {
+			async_state.error.Format("ASYNC: Bad zipped file %s at %d", packet.fn.c_str(), packet.seekpos);
+			return TRUE8;
+		}
+		return FALSE8;
+	}
+
+	int32 len = MIN<int32>(ASYNC_CHUNK_SIZE, packet.size - async_state.done);
+	int32 got;
+	if (packet.zipped)
+		got = async_state.zipStream->read(packet.p + async_state.done, len);
+	else
+		got = fread(packet.p + async_state.done, 1, len, async_state.file);
+
+	if (got != len) {
+		async_state.error.Format("ASYNC: Failed to read %d bytes from %s", packet.size, packet.fn.c_str());
+		return TRUE8;
+	}
+	async_state.done += len;
+
+	return (bool8)(async_state.done == packet.size);
+}
+
+// Load the next chunk of the file described by async_data into the memory pool
+// Returns FALSE8 if a chunk is already being loaded by another thread
+static bool8 async_loadPacket(res_man *rm) {
+	async_PacketType packet;
+
+	rm->hResManMutex->lock();
+	if ((rm->async_loading != 1) && (rm->async_loading != 3)) {
+		bool8 busy = (bool8)(rm->async_loading == 2);
+		rm->hResManMutex->unlock();
+		return (bool8)!busy;
+	}
+	// Claim the packet so nobody else loads it as well
+	if (rm->async_loading == 1) {
+		async_state.packedRead = 0;
+		async_state.done = 0;
+		async_state.error = "";
+	}
+	rm->async_loading = 2;
+	packet = rm->async_data;
+	rm->hResManMutex->unlock();
+
+	bool8 finished = async_loadChunk(packet);
+	if (finished)
+		async_closeLoad();
+
+	rm->hResManMutex->lock();
+	if (finished) {
+		rm->async_loading = 0;
+		rm->async_done = 1;
+	} else {
+		rm->async_loading = 3;
 	}
+	rm->hResManMutex->unlock();
 
-	return 0;
+	return TRUE8;
+}
+
+// Timer procedure take files and load them
+// It runs on the timer thread so file reads & decompression are done off the game thread
+static void async_loadThread(void *v) {
+	async_loadPacket((res_man *)v);
+}
+
+// The uncompressed length of a zipped file in a cluster
+// It is at the start of the data so only the beginning of the file is read
+static int32 zipEntryLength(const char *clusterPath, int32 offset, int32 size) {
+	FILE *in = openDiskFileForBinaryRead(clusterPath);
+	if ((in == NULL) || (fseek(in, offset, SEEK_SET) != 0))
+		Fatal_error("Could not fseek to %d bytes in %s", offset, clusterPath);
+
+	int32 headSize = MIN<int32>(size, 1024);
+	int32 len = 0;
+	for (;;) {
+		uint8 *head = (uint8 *)malloc(headSize);
+		if (fread(head, 1, headSize, in) != (size_t)headSize)
+			Fatal_error("Failed to read %d bytes from %s", headSize, clusterPath);
+
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(new Common::MemoryReadStream(head, headSize, DisposeAfterUse::YES));
+		len = (int32)stream->readUint32LE();
+		bool ok = !stream->err() && !stream->eos();
+		delete stream;
+
+		// the whole file is only needed if its start doesn't inflate on its own
+		if (ok || (headSize == size))
+			break;
+		headSize = size;
+		fseek(in, offset, SEEK_SET);
+	}
+	fclose(in);
+
+	return len;
 }
 
 void res_man::OpenAsync() {
+	async_loading = 0;
+	async_done = 0;
+
+	if (async_resMan) {
+		warning("res_man::OpenAsync() loader already in use : loading synchronously");
+		hasThread = 0;
+		return;
+	}
+
 	Zdebug("starting ASYNC");
 	hasThread = 1;
-	// hRunMutex=CreateMutex(NULL,TRUE,NULL);
-	hRunMutex = new Common::Mutex();
-	hRunMutex->lock();
+	async_resMan = this;
 
-	// hResManMutex=CreateMutex(NULL,FALSE,NULL);
 	hResManMutex = new Common::Mutex();
 
-	//_beginthread(async_loadThread,0,this);
-	warning("TODO: Fix threading");
-#if 0
-	hThread = NULL;
-	//hThread = SDL_CreateThread(async_loadThread, "async_loadThread", (void *)this);
-	if (!hThread) {
-		printf("ERROR: res_man::OpenAsync() Couldn't create thread");
-	}
-#endif
-	async_loading = 0;
-	async_done = 0;
+	g_system->getTimerManager()->installTimerProc(async_loadThread, 10000, this, "icbAsyncLoad");
 }
 
 void res_man::CloseAsync() {
@@ -223,17 +299,15 @@ void res_man::CloseAsync() {
 	if (hasThread) {
 		Zdebug("ASYNC: shutting down\n");
 
-		hRunMutex->unlock(); // ReleaseMutex(hRunMutex);
-		// SDL_Delay(50);    //Sleep(50);
+		async_flush();
+
+		// the timer manager waits for a running proc before removing it
+		g_system->getTimerManager()->removeTimerProc(async_loadThread);
+		async_resMan = NULL;
+		hasThread = 0;
 
-		warning("TODO: Fix threading");
-#if 0
-		//wait for thread to finish
-		SDL_WaitThread(hThread, NULL);
-		hThread = NULL;
-#endif
-		delete hRunMutex; // CloseHandle(hRunMutex);
 		delete hResManMutex; // CloseHandle(hResManMutex);
+		hResManMutex = NULL;
 	}
 }
 
@@ -263,13 +337,15 @@ async_PacketType res_man::async_shiftArray() {
 }
 
 // Add item to list
-void res_man::async_addFile(const int8 *fn, uint8 *p, int32 size, int32 zipped, int32 memListNo) {
+void res_man::async_addFile(const int8 *fn, uint8 *p, int32 size, int32 zipped, int32 memListNo, int32 seekpos, int32 packedSize) {
 	async_PacketType a;
 	a.fn = (char *)const_cast<int8 *>(fn);
 	a.p = p;
 	a.size = size;
 	a.zipped = zipped;
 	a.memListNo = memListNo;
+	a.seekpos = seekpos;
+	a.packedSize = packedSize;
 	async_fnArray.Add(a);
 }
 
@@ -297,6 +373,9 @@ int32 res_man::async_checkArray() {
 		if (async_done == 1) {
 			async_done = 0;
 			hResManMutex->unlock(); // ReleaseMutex(hResManMutex);
+			// the loader can't stop the game from the timer thread
+			if (!async_state.error.IsEmpty())
+				Fatal_error("%s", async_state.error.c_str());
 			async_shiftArray();
 			i--;
 			RegisterAsync(async_data.memListNo);
@@ -314,7 +393,14 @@ int32 res_man::async_checkArray() {
 void res_man::async_flush() {
 	Zdebug("ASYNC: flushing (%d items)\n", async_fnArray.GetNoItems());
 	while (async_checkArray() != 0)
-		;
+		async_wait();
+}
+
+// Wait for the current file : rather than waiting for the loader to get
+// round to it load it here if it hasn't been started yet
+void res_man::async_wait() {
+	if (!async_loadPacket(this))
+		g_system->delayMillis(1);
 }
 
 void Memory_stats() {
@@ -385,7 +471,9 @@ uint8 *res_man::AllocMemory(uint32 &memory_tot) {
 	return memory_b;
 }
 
-void res_man::RegisterAsync(const int32) {
+// The async loader has finished with this block
+void res_man::RegisterAsync(const int32 n) {
+	mem_list[n].protect = 0;
 }
 
 uint32 res_man::Fetch_size(const char * /*url*/, uint32 url_hash, const char *cluster, uint32 cluster_hash) {
@@ -479,16 +567,36 @@ void res_man::ReadFile(const char * /*url*/, RMParams *params) {
 		params->_stream = NULL;
 
 		mem_list[params->search].protect = 0;
+	} else {
+		// Hand the file over to the async loader, the block is protected until it has arrived
+		pxString clusterPath = ClusterPath(params->cluster);
+
+		delete params->_stream; // the loader opens its own handle
+		params->_stream = NULL;
+
+		Tdebug("clusters.txt", "  Queue %d bytes from pos %d", params->len, params->seekpos);
+
+		async_addFile((const int8 *)clusterPath.c_str(), mem_list[params->search].ad, params->len, params->zipped, params->search, params->seekpos, params->packedLen);
+		mem_list[params->search].protect = 1;
+
+		// Get it started
+		async_checkArray();
 	}
 }
 
-const char *res_man::OpenFile(int32 &cluster_search, RMParams *params) {
+// The full path of a cluster file
+pxString res_man::ClusterPath(const char *cluster) {
 	pxString rootPath(root);
-	pxString clusterName(params->cluster);
+	pxString clusterName(cluster);
 	clusterName.ToLower();
 
 	pxString clusterPath = rootPath + clusterName;
 	clusterPath.ConvertPath();
+	return clusterPath;
+}
+
+const char *res_man::OpenFile(int32 &cluster_search, RMParams *params) {
+	pxString clusterPath = ClusterPath(params->cluster);
 
 	// Are we are trying to open a cluster
 	if (params->url_hash == NULL_HASH) {
@@ -522,6 +630,18 @@ const char *res_man::OpenFile(int32 &cluster_search, RMParams *params) {
 		Fatal_error("res_man::OpenFile couldn't find url %X in cluster %s %X", params->url_hash, params->cluster, params->cluster_hash);
 	}
 
+	// The async loader opens the cluster itself
+	if (params->mode == RM_ASYNCLOAD) {
+		params->_stream = NULL;
+		params->seekpos = hn->offset;
+		if (params->zipped) {
+			params->packedLen = hn->size;
+			params->len = zipEntryLength(clusterPath.c_str(), hn->offset, hn->size);
+		} else
+			params->len = hn->size;
+		return NULL;
+	}
+
 	// This has to be done here because GetFileHeader can read in data which closes the file
 	// whose handle is stored in params->fh
 
@@ -555,10 +675,13 @@ HEADER_NORMAL *res_man::GetFileHeader(int32 &cluster_search, RMParams *params) {
 		params->url_hash = NULL_HASH;
 		uint32 compression = params->compressed; // Cluster headers are not compressed
 		params->compressed = params->zipped = FALSE8;
+		uint32 mode = params->mode; // The header is needed right now
+		params->mode = RM_LOADNOW;
 		clu = (Cluster_API *)LoadFile(cluster_search, params);
 		cluster_search = params->search;
 		params->url_hash = url_hash;
 		params->compressed = params->zipped = compression; // Restore compression
+		params->mode = mode;
 	} else {
 		// The cluster is in the memory pool at position cluster_search
 		clu = (Cluster_API *)mem_list[cluster_search].ad;
@@ -652,12 +775,7 @@ void res_man::Res_open_mini_cluster(const char *cluster_url, uint32 &cluster_has
 
 	// DiscRead(mem_list[mem_block].ad,(clu->hn)->offset,mem_needed,NULL,clu->ho.cdpos);
 
-	pxString rootPath(root);
-	pxString clusterName(fake_cluster_url);
-	clusterName.ToLower();
-
-	pxString clusterPath = rootPath + clusterName;
-	clusterPath.ConvertPath();
+	pxString clusterPath = ClusterPath(fake_cluster_url);
 
 	Common::SeekableReadStream *stream;
 
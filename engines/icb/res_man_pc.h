@@ -40,6 +40,8 @@ typedef struct async_PacketType {
 	int32 size;
 	int32 zipped;
 	int32 memListNo;
+	int32 seekpos;
+	int32 packedSize; // size of a zipped file in the cluster
 } async_PacketType;
 
 bool checkFileExists(const char *fullpath);
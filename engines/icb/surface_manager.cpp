@@ -29,6 +29,7 @@
 #include "engines/icb/surface_manager.h"
 #include "engines/icb/mission.h"
 #include "engines/icb/global_objects.h"
+#include "engines/icb/drawpoly_pc.h"
 
 #include "common/config-manager.h"
 #include "common/rect.h"
@@ -306,6 +307,8 @@ void _surface_manager::Reset_Effects() {
 }
 
 void _surface_manager::Flip() {
+	EndLitNormalCheckFrame();
+
 	// Draw Frame rate monitor if it's switched on
 	static uint32 g_fpsCounter = 0;
 	static float g_fpsTotalTime = 0.0f;
@@ -328,6 +328,14 @@ void FrameLimiter::startFrame() {
 	_startFrameTime = _system->getMillis();
 }
 
+uint FrameLimiter::getTimeLeft() const {
+	// With vsync the swap waits for the display, assume it refreshes at 60 Hz
+	uint frameLength = _enabled ? _speedLimitMs : 1000 / 60;
+	uint frameDuration = _system->getMillis() - _startFrameTime;
+
+	return frameDuration < frameLength ? frameLength - frameDuration : 0;
+}
+
 void FrameLimiter::delayBeforeSwap() {
 	uint endFrameTime = _system->getMillis();
 	uint frameDuration = endFrameTime - _startFrameTime;
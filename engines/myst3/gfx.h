@@ -210,6 +210,9 @@ public:
 
 	void startFrame();
 	void delayBeforeSwap();
+
+	/** The time in ms until the current frame is due to be shown */
+	uint getTimeLeft() const;
 private:
 	OSystem *_system;
 
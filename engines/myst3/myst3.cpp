@@ -41,6 +41,7 @@
 #include "engines/myst3/myst3.h"
 #include "engines/myst3/nodecube.h"
 #include "engines/myst3/nodeframe.h"
+#include "engines/myst3/prefetch.h"
 #include "engines/myst3/scene.h"
 #include "engines/myst3/state.h"
 #include "engines/myst3/cursor.h"
@@ -67,7 +68,7 @@ Myst3Engine::Myst3Engine(OSystem *syst, const Myst3GameDescription *version) :
 		_db(0), _scriptEngine(0),
 		_state(0), _node(0), _scene(0), _archiveNode(0),
 		_cursor(0), _inventory(0), _gfx(0), _menu(0),
-		_rnd(0), _sound(0), _ambient(0),
+		_rnd(0), _sound(0), _ambient(0), _nodePrefetcher(0),
 		_inputSpacePressed(false), _inputEnterPressed(false),
 		_inputEscapePressed(false), _inputTildePressed(false),
 		_inputEscapePressedNotConsumed(false),
@@ -119,6 +120,7 @@ Myst3Engine::~Myst3Engine() {
 	delete _inventory;
 	delete _cursor;
 	delete _scene;
+	delete _nodePrefetcher;
 	delete _archiveNode;
 	delete _db;
 	delete _scriptEngine;
@@ -169,6 +171,7 @@ Common::Error Myst3Engine::run() {
 		_menu = new PagingMenu(this);
 	}
 	_archiveNode = new Archive();
+	_nodePrefetcher = new NodePrefetcher(this);
 
 	_system->showMouse(false);
 
@@ -216,6 +219,7 @@ Common::Error Myst3Engine::run() {
 	}
 
 	unloadNode();
+	_nodePrefetcher->clear();
 
 	_archiveNode->close();
 	_gfx->freeFont();
@@ -759,6 +763,11 @@ void Myst3Engine::drawFrame(bool noSwap) {
 	_gfx->flipBuffer();
 
 	if (!noSwap) {
+		// Use the time left before the next frame to decode
+		// the faces of the nodes the player may go to next
+		if (_nodePrefetcher)
+			_nodePrefetcher->decodeFaces(_frameLimiter->getTimeLeft());
+
 		_frameLimiter->delayBeforeSwap();
 		_system->updateScreen();
 		_state->updateFrameCounters();
@@ -867,6 +876,11 @@ void Myst3Engine::loadNode(uint16 nodeID, uint32 roomID, uint32 ageID) {
 		return; // The main init script does not load a node
 	}
 
+	if (_state->getViewType() == kCube) {
+		NodePtr nodeData = _db->getNodeData(_state->getLocationNode(), roomID, ageID);
+		_nodePrefetcher->scheduleNeighbours(nodeData, newRoomName);
+	}
+
 	// The effects can only be created after running the node init scripts
 	_node->initEffects();
 	_shakeEffect = ShakeEffect::create(this);
@@ -1403,13 +1417,10 @@ Graphics::Surface *Myst3Engine::decodeJpeg(const ResourceDescription *jpegDesc)
 		error("Could not decode Myst III JPEG");
 	delete jpegStream;
 
-	const Graphics::Surface *bitmap = jpeg.getSurface();
-	assert(bitmap->format == Texture::getRGBAPixelFormat());
+	assert(jpeg.getSurface()->format == Texture::getRGBAPixelFormat());
 
-	// JPEGDecoder owns the decoded surface, we have to make a copy...
-	Graphics::Surface *rgbaSurface = new Graphics::Surface();
-	rgbaSurface->copyFrom(*bitmap);
-	return rgbaSurface;
+	// The pixels are decoded straight into the surface we return
+	return jpeg.releaseSurface();
 }
 
 int16 Myst3Engine::openDialog(uint16 id) {
@@ -80,6 +80,7 @@ class ShakeEffect;
 class RotationEffect;
 class Transition;
 class FrameLimiter;
+class NodePrefetcher;
 struct NodeData;
 struct Myst3GameDescription;
 
@@ -103,6 +104,7 @@ public:
 	Database *_db;
 	Sound *_sound;
 	Ambient *_ambient;
+	NodePrefetcher *_nodePrefetcher;
 	
 	Common::RandomSource *_rnd;
 
@@ -21,8 +21,11 @@
  */
 
 #include "engines/myst3/archive.h"
+#include "engines/myst3/database.h"
 #include "engines/myst3/nodecube.h"
 #include "engines/myst3/myst3.h"
+#include "engines/myst3/prefetch.h"
+#include "engines/myst3/state.h"
 
 #include "common/debug.h"
 
@@ -32,13 +35,23 @@ NodeCube::NodeCube(Myst3Engine *vm, uint16 id) :
 		Node(vm, id) {
 	_is3D = true;
 
+	Common::String roomName = _vm->_db->getRoomName(_vm->_state->getLocationRoom(), _vm->_state->getLocationAge());
+
 	for (int i = 0; i < 6; i++) {
+		_faces[i] = new Face(_vm);
+
+		// Use the face decoded ahead of time when moving to a neighbour node
+		Graphics::Surface *bitmap = _vm->_nodePrefetcher->takeFace(roomName, id, i);
+		if (bitmap) {
+			_faces[i]->setTextureFromBitmap(bitmap);
+			continue;
+		}
+
 		ResourceDescription jpegDesc = _vm->getFileDescription("", id, i + 1, Archive::kCubeFace);
 
 		if (!jpegDesc.isValid())
 			error("Face %d does not exist", id);
 
-		_faces[i] = new Face(_vm);
 		_faces[i]->setTextureFromJPEG(&jpegDesc);
 	}
 }
@@ -0,0 +1,194 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the AUTHORS
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/myst3/prefetch.h"
+#include "engines/myst3/database.h"
+#include "engines/myst3/hotspot.h"
+#include "engines/myst3/myst3.h"
+
+#include "common/algorithm.h"
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "graphics/surface.h"
+
+namespace Myst3 {
+
+NodePrefetcher::NodePrefetcher(Myst3Engine *vm) :
+		_vm(vm),
+		_decodeTime(0) {
+}
+
+NodePrefetcher::~NodePrefetcher() {
+	clear();
+}
+
+void NodePrefetcher::freeNode(CachedNode &node) {
+	for (uint i = 0; i < kFaceCount; i++) {
+		if (node.faces[i]) {
+			node.faces[i]->free();
+			delete node.faces[i];
+			node.faces[i] = nullptr;
+		}
+	}
+}
+
+void NodePrefetcher::clear() {
+	for (uint i = 0; i < _nodes.size(); i++) {
+		freeNode(_nodes[i]);
+	}
+	_nodes.clear();
+	_roomName.clear();
+}
+
+void NodePrefetcher::addNeighbour(uint16 nodeID, uint16 currentNodeID) {
+	if (nodeID == currentNodeID || _nodes.size() >= kMaxCachedNodes)
+		return;
+
+	for (uint i = 0; i < _nodes.size(); i++) {
+		if (_nodes[i].id == nodeID)
+			return;
+	}
+
+	// Only cube nodes are worth prefetching, frames are small and cheap to decode
+	ResourceDescription jpegDesc = _vm->getFileDescription(_roomName, nodeID, 1, Archive::kCubeFace);
+	if (!jpegDesc.isValid())
+		return;
+
+	CachedNode node;
+	node.id = nodeID;
+	for (uint i = 0; i < kFaceCount; i++) {
+		node.faces[i] = nullptr;
+	}
+
+	_nodes.push_back(node);
+}
+
+void NodePrefetcher::scheduleNeighbours(const NodePtr &nodeData, const Common::String &roomName) {
+	if (roomName != _roomName) {
+		clear();
+		_roomName = roomName;
+	}
+
+	// Keep the cached nodes which are still reachable, in the order they were
+	// originally scheduled, and drop the others
+	Common::Array<CachedNode> previousNodes = _nodes;
+	_nodes.clear();
+
+	Common::Array<uint16> neighbours;
+	for (uint i = 0; i < nodeData->hotspots.size(); i++) {
+		const Common::Array<Opcode> &script = nodeData->hotspots[i].script;
+
+		for (uint j = 0; j < script.size(); j++) {
+			const Opcode &opcode = script[j];
+
+			switch (opcode.op) {
+			case 136: // goToNodeTransition
+			case 137: // goToNodeTrans2
+			case 138: // goToNodeTrans1
+			case 140: // zipToNode
+			case 164: // changeNode
+				// Negative values are variable references, we can't know their value ahead of time
+				if (!opcode.args.empty() && opcode.args[0] > 0)
+					neighbours.push_back(opcode.args[0]);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	for (uint i = 0; i < previousNodes.size(); i++) {
+		bool reachable = previousNodes[i].id != nodeData->id
+				&& Common::find(neighbours.begin(), neighbours.end(), previousNodes[i].id) != neighbours.end();
+
+		if (reachable && _nodes.size() < kMaxCachedNodes) {
+			_nodes.push_back(previousNodes[i]);
+		} else {
+			freeNode(previousNodes[i]);
+		}
+	}
+
+	for (uint i = 0; i < neighbours.size(); i++) {
+		addNeighbour(neighbours[i], nodeData->id);
+	}
+
+	debugC(kDebugNode, "Prefetching %d nodes", _nodes.size());
+}
+
+void NodePrefetcher::decodeFaces(uint timeLeft) {
+	uint startTime = g_system->getMillis();
+
+	while (true) {
+		uint decodeStartTime = g_system->getMillis();
+		if (decodeStartTime - startTime + _decodeTime >= timeLeft)
+			break;
+
+		if (!decodeNextFace())
+			break;
+
+		uint duration = g_system->getMillis() - decodeStartTime;
+		_decodeTime = MAX(duration, _decodeTime * 3 / 4);
+	}
+}
+
+bool NodePrefetcher::decodeNextFace() {
+	for (uint i = 0; i < _nodes.size(); i++) {
+		CachedNode &node = _nodes[i];
+
+		for (uint j = 0; j < kFaceCount; j++) {
+			if (node.faces[j])
+				continue;
+
+			ResourceDescription jpegDesc = _vm->getFileDescription(_roomName, node.id, j + 1, Archive::kCubeFace);
+			if (!jpegDesc.isValid()) {
+				// Incomplete node, don't try to prefetch it anymore
+				freeNode(node);
+				_nodes.remove_at(i);
+				return false;
+			}
+
+			node.faces[j] = Myst3Engine::decodeJpeg(&jpegDesc);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+Graphics::Surface *NodePrefetcher::takeFace(const Common::String &roomName, uint16 nodeID, uint face) {
+	if (roomName != _roomName)
+		return nullptr;
+
+	for (uint i = 0; i < _nodes.size(); i++) {
+		if (_nodes[i].id != nodeID)
+			continue;
+
+		Graphics::Surface *surface = _nodes[i].faces[face];
+		_nodes[i].faces[face] = nullptr;
+		return surface;
+	}
+
+	return nullptr;
+}
+
+} // End of namespace Myst3
@@ -0,0 +1,106 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the AUTHORS
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef PREFETCH_H_
+#define PREFETCH_H_
+
+#include "common/array.h"
+#include "common/ptr.h"
+#include "common/str.h"
+
+namespace Graphics {
+struct Surface;
+}
+
+namespace Myst3 {
+
+class Myst3Engine;
+struct NodeData;
+
+typedef Common::SharedPtr<NodeData> NodePtr;
+
+/**
+ * Decodes ahead of time the cube faces of the nodes the player
+ * can reach from the current node.
+ *
+ * The destinations of the current node's hotspots are queued when the node
+ * is loaded. Their faces are then decoded in the time each frame has left before
+ * it is shown, into a bounded cache. When the player moves to one of those nodes,
+ * its faces are handed over to the new node instead of being decoded again.
+ *
+ * The decoding is done on the game thread rather than in a timer proc, as decoding
+ * a face takes several milliseconds and the timer procs, including the audio ones,
+ * all share a single thread.
+ */
+class NodePrefetcher {
+public:
+	NodePrefetcher(Myst3Engine *vm);
+	~NodePrefetcher();
+
+	/**
+	 * Queue the cube nodes reachable from the hotspots of a node for prefetching,
+	 * and drop the cached nodes which are no longer reachable.
+	 */
+	void scheduleNeighbours(const NodePtr &nodeData, const Common::String &roomName);
+
+	/**
+	 * Decode pending faces for as long as they are expected to fit in the given time.
+	 *
+	 * @param timeLeft the time in ms the current frame has left
+	 */
+	void decodeFaces(uint timeLeft);
+
+	/**
+	 * Take ownership of a prefetched face.
+	 *
+	 * @return the decoded face, or nullptr when it is not in the cache
+	 */
+	Graphics::Surface *takeFace(const Common::String &roomName, uint16 nodeID, uint face);
+
+	/** Empty the cache and the pending queue */
+	void clear();
+
+private:
+	static const uint kFaceCount = 6;
+	static const uint kMaxCachedNodes = 4;
+
+	struct CachedNode {
+		uint16 id;
+		Graphics::Surface *faces[kFaceCount];
+	};
+
+	Myst3Engine *_vm;
+
+	Common::String _roomName;
+	Common::Array<CachedNode> _nodes;
+
+	/** Recent time in ms it took to decode a face, decaying slowly after spikes */
+	uint _decodeTime;
+
+	bool decodeNextFace();
+	void freeNode(CachedNode &node);
+	void addNeighbour(uint16 nodeID, uint16 currentNodeID);
+};
+
+} // End of namespace Myst3
+
+#endif // PREFETCH_H_
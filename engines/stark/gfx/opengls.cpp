@@ -130,6 +130,7 @@ void OpenGLSDriver::clearScreen() {
 
 void OpenGLSDriver::flipBuffer() {
 	g_system->updateScreen();
+	OpenGL::Shader::endFrame();
 }
 
 Texture *OpenGLSDriver::createTexture(const Graphics::Surface *surface, const byte *palette) {
@@ -0,0 +1,334 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/algorithm.h"
+#include "common/math.h"
+#include "common/util.h"
+#include "engines/wintermute/ad/ad_geometry_bvh.h"
+#include "engines/wintermute/base/gfx/3ds/mesh3ds.h"
+
+namespace Wintermute {
+
+struct AdGeometryBVH::CenterLess {
+	const Common::Array<Triangle> &_triangles;
+	int _axis;
+
+	CenterLess(const Common::Array<Triangle> &triangles, int axis) : _triangles(triangles), _axis(axis) {}
+
+	bool operator()(uint32 a, uint32 b) const {
+		float ca = _triangles[a]._center.getValue(_axis);
+		float cb = _triangles[b]._center.getValue(_axis);
+		return ca < cb || (ca == cb && a < b);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+AdGeometryBVH::AdGeometryBVH() : _epsilon(0.0f) {
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::clear() {
+	_triangles.clear();
+	_order.clear();
+	_nodes.clear();
+	_epsilon = 0.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::addMesh(Mesh3DS *mesh, int owner) {
+	if (!mesh) {
+		return;
+	}
+
+	for (int i = 0; i < mesh->faceCount(); i++) {
+		uint16 *face = mesh->getFace(i);
+		Triangle triangle;
+
+		for (int j = 0; j < 3; j++) {
+			float *v = mesh->getVertexPosition(face[j]);
+			triangle._v[j] = Math::Vector3d(v[0], v[1], v[2]);
+		}
+
+		triangle._center = (triangle._v[0] + triangle._v[1] + triangle._v[2]) / 3.0f;
+		triangle._owner = owner;
+		triangle._active = true;
+		_triangles.push_back(triangle);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::build() {
+	_order.resize(_triangles.size());
+	for (uint32 i = 0; i < _triangles.size(); i++) {
+		_order[i] = i;
+	}
+
+	_nodes.clear();
+	if (_triangles.empty()) {
+		return;
+	}
+
+	_nodes.reserve(2 * (_triangles.size() / kMaxLeafTriangles) + 1);
+	_nodes.push_back(Node());
+	buildNode(0, 0, _triangles.size());
+
+	refit();
+
+	// The intersection tests work on rounded values, so make the boxes a
+	// little larger than the scene needs
+	float extent = 0.0f;
+	for (int axis = 0; axis < 3; axis++) {
+		extent = MAX(extent, _nodes[0]._max[axis] - _nodes[0]._min[axis]);
+	}
+	_epsilon = extent * 0.0001f + 0.001f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::buildNode(uint32 index, uint32 first, uint32 count) {
+	_nodes[index]._activeCount = 0;
+
+	if (count <= kMaxLeafTriangles) {
+		_nodes[index]._first = first;
+		_nodes[index]._count = count;
+		return;
+	}
+
+	// Split at the median of the triangle centers along the longest axis,
+	// which keeps the tree balanced and its depth logarithmic
+	Math::Vector3d minCenter = _triangles[_order[first]]._center;
+	Math::Vector3d maxCenter = minCenter;
+	for (uint32 i = first + 1; i < first + count; i++) {
+		const Math::Vector3d &center = _triangles[_order[i]]._center;
+		for (int axis = 0; axis < 3; axis++) {
+			minCenter.setValue(axis, MIN(minCenter.getValue(axis), center.getValue(axis)));
+			maxCenter.setValue(axis, MAX(maxCenter.getValue(axis), center.getValue(axis)));
+		}
+	}
+
+	int axis = 0;
+	for (int i = 1; i < 3; i++) {
+		if (maxCenter.getValue(i) - minCenter.getValue(i) > maxCenter.getValue(axis) - minCenter.getValue(axis)) {
+			axis = i;
+		}
+	}
+
+	Common::sort(_order.begin() + first, _order.begin() + first + count, CenterLess(_triangles, axis));
+
+	uint32 left = _nodes.size();
+	_nodes.push_back(Node());
+	_nodes.push_back(Node());
+	_nodes[index]._first = left;
+	_nodes[index]._count = 0;
+
+	uint32 half = count / 2;
+	buildNode(left, first, half);
+	buildNode(left + 1, first + half, count - half);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::refit() {
+	// Children always come after their parent, so going backwards updates
+	// them first. Boxes only cover the active triangles.
+	for (int i = _nodes.size() - 1; i >= 0; i--) {
+		Node &node = _nodes[i];
+
+		for (int axis = 0; axis < 3; axis++) {
+			node._min[axis] = FLT_MAX;
+			node._max[axis] = -FLT_MAX;
+		}
+		node._activeCount = 0;
+
+		if (node._count) {
+			for (uint32 j = node._first; j < node._first + node._count; j++) {
+				const Triangle &triangle = _triangles[_order[j]];
+				if (!triangle._active) {
+					continue;
+				}
+
+				for (int k = 0; k < 3; k++) {
+					for (int axis = 0; axis < 3; axis++) {
+						node._min[axis] = MIN(node._min[axis], triangle._v[k].getValue(axis));
+						node._max[axis] = MAX(node._max[axis], triangle._v[k].getValue(axis));
+					}
+				}
+				node._activeCount++;
+			}
+		} else {
+			for (uint32 j = node._first; j < node._first + 2; j++) {
+				const Node &child = _nodes[j];
+				if (!child._activeCount) {
+					continue;
+				}
+
+				for (int axis = 0; axis < 3; axis++) {
+					node._min[axis] = MIN(node._min[axis], child._min[axis]);
+					node._max[axis] = MAX(node._max[axis], child._max[axis]);
+				}
+				node._activeCount += child._activeCount;
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::setOwnerActive(int owner, bool active) {
+	bool changed = false;
+
+	for (uint32 i = 0; i < _triangles.size(); i++) {
+		if (_triangles[i]._owner == owner && _triangles[i]._active != active) {
+			_triangles[i]._active = active;
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		refit();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::queryVerticalLine(float x, float z, float maxY, Common::Array<uint32> &result) const {
+	result.clear();
+	if (_nodes.empty()) {
+		return;
+	}
+
+	uint32 stack[kMaxDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize) {
+		const Node &node = _nodes[stack[--stackSize]];
+
+		if (!node._activeCount ||
+		    x < node._min[0] - _epsilon || x > node._max[0] + _epsilon ||
+		    z < node._min[2] - _epsilon || z > node._max[2] + _epsilon ||
+		    node._min[1] - _epsilon > maxY) {
+			continue;
+		}
+
+		if (node._count) {
+			for (uint32 i = node._first; i < node._first + node._count; i++) {
+				if (_triangles[_order[i]]._active) {
+					result.push_back(_order[i]);
+				}
+			}
+		} else {
+			stack[stackSize++] = node._first;
+			stack[stackSize++] = node._first + 1;
+		}
+	}
+
+	sortResult(result);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::querySegment(const Math::Vector3d &start, const Math::Vector3d &end, Common::Array<uint32> &result) const {
+	Math::Vector3d direction = end - start;
+	queryLine(start.getData(), direction.getData(), 0.0f, 1.0f, result);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::queryLine(const Math::Vector3d &origin, const Math::Vector3d &direction, Common::Array<uint32> &result) const {
+	queryLine(origin.getData(), direction.getData(), -FLT_MAX, FLT_MAX, result);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::queryLine(const float *origin, const float *direction, float tMin, float tMax, Common::Array<uint32> &result) const {
+	result.clear();
+	if (_nodes.empty()) {
+		return;
+	}
+
+	uint32 stack[kMaxDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize) {
+		const Node &node = _nodes[stack[--stackSize]];
+
+		if (!node._activeCount || !lineHitsNode(node, origin, direction, tMin, tMax)) {
+			continue;
+		}
+
+		if (node._count) {
+			for (uint32 i = node._first; i < node._first + node._count; i++) {
+				if (_triangles[_order[i]]._active) {
+					result.push_back(_order[i]);
+				}
+			}
+		} else {
+			stack[stackSize++] = node._first;
+			stack[stackSize++] = node._first + 1;
+		}
+	}
+
+	sortResult(result);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::queryAll(Common::Array<uint32> &result) const {
+	result.clear();
+	for (uint32 i = 0; i < _triangles.size(); i++) {
+		if (_triangles[i]._active) {
+			result.push_back(i);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool AdGeometryBVH::lineHitsNode(const Node &node, const float *origin, const float *direction, float tMin, float tMax) const {
+	for (int axis = 0; axis < 3; axis++) {
+		float lo = node._min[axis] - _epsilon;
+		float hi = node._max[axis] + _epsilon;
+
+		if (ABS(direction[axis]) < 0.000001f) {
+			if (origin[axis] < lo || origin[axis] > hi) {
+				return false;
+			}
+			continue;
+		}
+
+		float inv = 1.0f / direction[axis];
+		float t0 = (lo - origin[axis]) * inv;
+		float t1 = (hi - origin[axis]) * inv;
+		if (t0 > t1) {
+			SWAP(t0, t1);
+		}
+
+		tMin = MAX(tMin, t0);
+		tMax = MIN(tMax, t1);
+		if (tMin > tMax) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdGeometryBVH::sortResult(Common::Array<uint32> &result) const {
+	// Callers test the triangles in the order of the brute force scan
+	Common::sort(result.begin(), result.end());
+}
+
+} // namespace Wintermute
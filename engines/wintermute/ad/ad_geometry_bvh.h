@@ -0,0 +1,104 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WINTERMUTE_AD_GEOMETRY_BVH_H
+#define WINTERMUTE_AD_GEOMETRY_BVH_H
+
+#include "common/array.h"
+#include "math/vector3d.h"
+
+namespace Wintermute {
+
+class Mesh3DS;
+
+/**
+ * A bounding volume hierarchy over the triangles of the walk planes or the
+ * blocks of a scene.
+ *
+ * The queries only return the indices of the triangles which may be hit, in
+ * the order in which the meshes were added, so that callers can run the same
+ * exact intersection tests as before and get the same results. Triangles
+ * belong to an owner (the index of their walk plane or block), and the
+ * triangles of inactive owners are left out of the queries.
+ */
+class AdGeometryBVH {
+public:
+	AdGeometryBVH();
+
+	void clear();
+
+	/** Add all triangles of the mesh. Call build() after adding the meshes. */
+	void addMesh(Mesh3DS *mesh, int owner);
+	void build();
+
+	/** Include or leave out the triangles of an owner, refitting the tree. */
+	void setOwnerActive(int owner, bool active);
+
+	uint32 triangleCount() const { return _triangles.size(); }
+	int getOwner(uint32 triangle) const { return _triangles[triangle]._owner; }
+	const Math::Vector3d &getVertex(uint32 triangle, int vertex) const { return _triangles[triangle]._v[vertex]; }
+
+	/** Triangles which the vertical line at (x, z) may hit at a height of up to maxY. */
+	void queryVerticalLine(float x, float z, float maxY, Common::Array<uint32> &result) const;
+	/** Triangles which the segment from start to end may hit. */
+	void querySegment(const Math::Vector3d &start, const Math::Vector3d &end, Common::Array<uint32> &result) const;
+	/** Triangles which the line through origin, in both directions, may hit. */
+	void queryLine(const Math::Vector3d &origin, const Math::Vector3d &direction, Common::Array<uint32> &result) const;
+	/** All triangles of active owners, like a brute force scan would test them. */
+	void queryAll(Common::Array<uint32> &result) const;
+
+private:
+	struct Triangle {
+		Math::Vector3d _v[3];
+		Math::Vector3d _center;
+		int _owner;
+		bool _active;
+	};
+
+	struct Node {
+		float _min[3];
+		float _max[3];
+		uint32 _first; ///< The first entry in _order for leaves, the left child otherwise
+		uint32 _count; ///< The number of triangles for leaves, 0 otherwise
+		uint32 _activeCount;
+	};
+
+	struct CenterLess;
+
+	static const uint32 kMaxLeafTriangles = 4;
+	static const int kMaxDepth = 64; ///< Enough for any tree split at the median
+
+	void buildNode(uint32 index, uint32 first, uint32 count);
+	void refit();
+	bool lineHitsNode(const Node &node, const float *origin, const float *direction, float tMin, float tMax) const;
+	void queryLine(const float *origin, const float *direction, float tMin, float tMax, Common::Array<uint32> &result) const;
+	void sortResult(Common::Array<uint32> &result) const;
+
+	Common::Array<Triangle> _triangles;
+	Common::Array<uint32> _order;
+	Common::Array<Node> _nodes;
+	float _epsilon; ///< Slack for the box tests, so that rounding never culls a hit
+};
+
+} // namespace Wintermute
+
+#endif
@@ -85,6 +85,10 @@ AdSceneGeometry::AdSceneGeometry(BaseGame *gameRef) : BaseObject(gameRef) {
 
 	_lastValuesInitialized = false;
 	_maxLightsWarning = false;
+
+	_bruteForceQueries = false;
+	_recordPositions = false;
+	_nextRecordedPosition = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -107,6 +111,9 @@ void AdSceneGeometry::cleanup() {
 	}
 	_blocks.clear();
 
+	_planeTree.clear();
+	_blockTree.clear();
+
 	for (i = 0; i < _generics.size(); i++) {
 		delete _generics[i];
 	}
@@ -252,6 +259,8 @@ bool AdSceneGeometry::loadFile(const char *filename) {
 
 	SystemClassRegistry::getInstance()->_disabled = false;
 
+	buildGeometryTrees();
+
 	if (_cameras.size() > 0) {
 		setActiveCamera(0, -1.0f, -1.0f, -1.0f);
 	}
@@ -414,8 +423,59 @@ bool AdSceneGeometry::renderShadowGeometry() {
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////
+void AdSceneGeometry::buildGeometryTrees() {
+	_planeTree.clear();
+	for (uint i = 0; i < _planes.size(); i++) {
+		_planeTree.addMesh(_planes[i]->_mesh, i);
+	}
+	_planeTree.build();
+
+	_blockTree.clear();
+	for (uint i = 0; i < _blocks.size(); i++) {
+		_blockTree.addMesh(_blocks[i]->_mesh, i);
+	}
+	_blockTree.build();
+	updateBlockTree();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdSceneGeometry::updateBlockTree() {
+	// walkplanes are used whether they are active or not, only blocks can
+	// be switched off
+	for (uint i = 0; i < _blocks.size(); i++) {
+		_blockTree.setOwnerActive(i, _blocks[i]->_active);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdSceneGeometry::setRecordPositions(bool record) {
+	if (record && !_recordPositions) {
+		_recordedPositions.clear();
+		_nextRecordedPosition = 0;
+	}
+	_recordPositions = record;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AdSceneGeometry::getRecordedPositions(Common::Array<Math::Vector3d> &positions) const {
+	positions.clear();
+	for (uint32 i = 0; i < _recordedPositions.size(); i++) {
+		positions.push_back(_recordedPositions[(_nextRecordedPosition + i) % _recordedPositions.size()]);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 float AdSceneGeometry::getHeightAt(Math::Vector3d pos, float tolerance, bool *intFound) {
+	if (_recordPositions) {
+		if (_recordedPositions.size() < kMaxRecordedPositions) {
+			_recordedPositions.push_back(pos);
+		} else {
+			_recordedPositions[_nextRecordedPosition] = pos;
+			_nextRecordedPosition = (_nextRecordedPosition + 1) % kMaxRecordedPositions;
+		}
+	}
+
 	float ret = pos.y();
 	Math::Vector3d intersection;
 	Math::Vector3d dir = Math::Vector3d(0, -1, 0);
@@ -424,28 +484,29 @@ float AdSceneGeometry::getHeightAt(Math::Vector3d pos, float tolerance, bool *in
 
 	bool intFoundTmp = false;
 
-	for (uint32 i = 0; i < _planes.size(); i++) {
-		for (int j = 0; j < _planes[i]->_mesh->faceCount(); j++) {
-			uint16 *triangle = _planes[i]->_mesh->getFace(j);
-			float *v0 = _planes[i]->_mesh->getVertexPosition(triangle[0]);
-			float *v1 = _planes[i]->_mesh->getVertexPosition(triangle[1]);
-			float *v2 = _planes[i]->_mesh->getVertexPosition(triangle[2]);
-
-			if (lineIntersectsTriangle(pos, dir,
-			                           Math::Vector3d(v0[0], v0[1], v0[2]),
-			                           Math::Vector3d(v1[0], v1[1], v1[2]),
-			                           Math::Vector3d(v2[0], v2[1], v2[2]),
-			                           intersection.x(), intersection.y(), intersection.z())) {
-				if (intersection.y() > pos.y() + tolerance) {
-					continue; // only fall down
-				}
+	if (_bruteForceQueries) {
+		_planeTree.queryAll(_candidates);
+	} else {
+		_planeTree.queryVerticalLine(pos.x(), pos.z(), pos.y() + tolerance, _candidates);
+	}
 
-				if (!intFoundTmp || ABS(ret - pos.y()) > ABS(intersection.y() - pos.y())) {
-					ret = intersection.y();
-				}
+	for (uint32 i = 0; i < _candidates.size(); i++) {
+		uint32 triangle = _candidates[i];
 
-				intFoundTmp = true;
+		if (lineIntersectsTriangle(pos, dir,
+		                           _planeTree.getVertex(triangle, 0),
+		                           _planeTree.getVertex(triangle, 1),
+		                           _planeTree.getVertex(triangle, 2),
+		                           intersection.x(), intersection.y(), intersection.z())) {
+			if (intersection.y() > pos.y() + tolerance) {
+				continue; // only fall down
 			}
+
+			if (!intFoundTmp || ABS(ret - pos.y()) > ABS(intersection.y() - pos.y())) {
+				ret = intersection.y();
+			}
+
+			intFoundTmp = true;
 		}
 	}
 
@@ -456,66 +517,59 @@ float AdSceneGeometry::getHeightAt(Math::Vector3d pos, float tolerance, bool *in
 	return ret;
 }
 
+//////////////////////////////////////////////////////////////////////////
+static bool segmentIntersectsTriangle(const Math::Vector3d &p1, const Math::Vector3d &p2, const Math::Vector3d &v0,
+                                      const Math::Vector3d &v1, const Math::Vector3d &v2, Math::Vector3d &intersection) {
+	float dist;
+
+	if (lineSegmentIntersectsTriangle(p1, p2, v0, v1, v2, intersection, dist)) {
+		if (lineIntersectsTriangle(p1, p1 - p2, v0, v1, v2,
+		                           intersection.x(), intersection.y(), intersection.z())) {
+			return true;
+		}
+
+		if (lineIntersectsTriangle(p2, p2 - p1, v0, v1, v2,
+		                           intersection.x(), intersection.y(), intersection.z())) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool AdSceneGeometry::directPathExists(Math::Vector3d *p1, Math::Vector3d *p2) {
-	// pretty sure this stuff can be somewhat simplified by factoring it out
-	// into some functions but let's leave this to a later point
+	Math::Vector3d intersection;
 
 	// test walkplanes
-	for (uint i = 0; i < _planes.size(); i++) {
-		for (int j = 0; j < _planes[i]->_mesh->faceCount(); j++) {
-			uint16 *triangle = _planes[i]->_mesh->getFace(j);
-			float *v0 = _planes[i]->_mesh->getVertexPosition(triangle[0]);
-			float *v1 = _planes[i]->_mesh->getVertexPosition(triangle[1]);
-			float *v2 = _planes[i]->_mesh->getVertexPosition(triangle[2]);
-			Math::Vector3d intersection;
-			float dist;
-
-			if (lineSegmentIntersectsTriangle(*p1, *p2, Math::Vector3d(v0[0], v0[1], v0[2]),
-			                                  Math::Vector3d(v1[0], v1[1], v1[2]),
-			                                  Math::Vector3d(v2[0], v2[1], v2[2]),
-			                                  intersection, dist)) {
-				if (lineIntersectsTriangle(*p1, *p1 - *p2, v0, v1, v2,
-				                           intersection.x(), intersection.y(), intersection.z())) {
-					return false;
-				}
+	if (_bruteForceQueries) {
+		_planeTree.queryAll(_candidates);
+	} else {
+		_planeTree.querySegment(*p1, *p2, _candidates);
+	}
 
-				if (lineIntersectsTriangle(*p2, *p2 - *p1, v0, v1, v2,
-				                           intersection.x(), intersection.y(), intersection.z())) {
-					return false;
-				}
-			}
+	for (uint32 i = 0; i < _candidates.size(); i++) {
+		uint32 triangle = _candidates[i];
+
+		if (segmentIntersectsTriangle(*p1, *p2, _planeTree.getVertex(triangle, 0), _planeTree.getVertex(triangle, 1),
+		                              _planeTree.getVertex(triangle, 2), intersection)) {
+			return false;
 		}
 	}
 
-	// test blocks
-	for (uint i = 0; i < _blocks.size(); i++) {
-		if (!_blocks[i]->_active) {
-			continue;
-		}
+	// test blocks, the tree leaves out the inactive ones
+	if (_bruteForceQueries) {
+		_blockTree.queryAll(_candidates);
+	} else {
+		_blockTree.querySegment(*p1, *p2, _candidates);
+	}
 
-		for (int j = 0; j < _blocks[i]->_mesh->faceCount(); j++) {
-			uint16 *triangle = _blocks[i]->_mesh->getFace(j);
-			float *v0 = _blocks[i]->_mesh->getVertexPosition(triangle[0]);
-			float *v1 = _blocks[i]->_mesh->getVertexPosition(triangle[1]);
-			float *v2 = _blocks[i]->_mesh->getVertexPosition(triangle[2]);
-			Math::Vector3d intersection;
-			float dist;
-
-			if (lineSegmentIntersectsTriangle(*p1, *p2, Math::Vector3d(v0[0], v0[1], v0[2]),
-			                                  Math::Vector3d(v1[0], v1[1], v1[2]),
-			                                  Math::Vector3d(v2[0], v2[1], v2[2]),
-			                                  intersection, dist)) {
-				if (lineIntersectsTriangle(*p1, *p1 - *p2, v0, v1, v2,
-				                           intersection.x(), intersection.y(), intersection.z())) {
-					return false;
-				}
+	for (uint32 i = 0; i < _candidates.size(); i++) {
+		uint32 triangle = _candidates[i];
 
-				if (lineIntersectsTriangle(*p2, *p2 - *p1, v0, v1, v2,
-				                           intersection.x(), intersection.y(), intersection.z())) {
-					return false;
-				}
-			}
+		if (segmentIntersectsTriangle(*p1, *p2, _blockTree.getVertex(triangle, 0), _blockTree.getVertex(triangle, 1),
+		                              _blockTree.getVertex(triangle, 2), intersection)) {
+			return false;
 		}
 	}
 
@@ -524,30 +578,20 @@ bool AdSceneGeometry::directPathExists(Math::Vector3d *p1, Math::Vector3d *p2) {
 
 //////////////////////////////////////////////////////////////////////////
 Math::Vector3d AdSceneGeometry::getBlockIntersection(Math::Vector3d *p1, Math::Vector3d *p2) {
-	// test blocks
-	for (uint i = 0; i < _blocks.size(); i++) {
-		if (!_blocks[i]->_active) {
-			continue;
-		}
-
-		for (int j = 0; j < _blocks[i]->_mesh->faceCount(); j++) {
-			uint16 *triangle = _blocks[i]->_mesh->getFace(j);
-			float *v0 = _blocks[i]->_mesh->getVertexPosition(triangle[0]);
-			float *v1 = _blocks[i]->_mesh->getVertexPosition(triangle[1]);
-			float *v2 = _blocks[i]->_mesh->getVertexPosition(triangle[2]);
-
-			Math::Vector3d intersection;
-			float dist;
+	// test blocks, the candidates come in the same order as the blocks and their faces
+	if (_bruteForceQueries) {
+		_blockTree.queryAll(_candidates);
+	} else {
+		_blockTree.querySegment(*p1, *p2, _candidates);
+	}
 
-			if (lineSegmentIntersectsTriangle(*p1, *p2, v0, v1, v2, intersection, dist)) {
-				if (lineIntersectsTriangle(*p1, *p1 - *p2, v0, v1, v2, intersection.x(), intersection.y(), intersection.z())) {
-					return intersection;
-				}
+	for (uint32 i = 0; i < _candidates.size(); i++) {
+		uint32 triangle = _candidates[i];
+		Math::Vector3d intersection;
 
-				if (lineIntersectsTriangle(*p2, *p2 - *p1, v0, v1, v2, intersection.x(), intersection.y(), intersection.z())) {
-					return intersection;
-				}
-			}
+		if (segmentIntersectsTriangle(*p1, *p2, _blockTree.getVertex(triangle, 0), _blockTree.getVertex(triangle, 1),
+		                              _blockTree.getVertex(triangle, 2), intersection)) {
+			return intersection;
 		}
 	}
 
@@ -645,29 +689,30 @@ bool AdSceneGeometry::convert2Dto3D(int x, int y, Math::Vector3d *pos) {
 
 	Math::Ray ray = _gameRef->_renderer3D->rayIntoScene(x, y);
 
-	for (uint32 i = 0; i < _planes.size(); i++) {
-		for (int j = 0; j < _planes[i]->_mesh->faceCount(); j++) {
-			uint16 *triangle = _planes[i]->_mesh->getFace(j);
-			float *v0 = _planes[i]->_mesh->getVertexPosition(triangle[0]);
-			float *v1 = _planes[i]->_mesh->getVertexPosition(triangle[1]);
-			float *v2 = _planes[i]->_mesh->getVertexPosition(triangle[2]);
-			Math::Vector3d intersection;
-
-			if (lineIntersectsTriangle(ray.getOrigin(), ray.getDirection(),
-			                           Math::Vector3d(v0[0], v0[1], v0[2]),
-			                           Math::Vector3d(v1[0], v1[1], v1[2]),
-			                           Math::Vector3d(v2[0], v2[1], v2[2]),
-			                           intersection.x(), intersection.y(), intersection.z())) {
-				Math::Vector3d lineSegement = intersection - getActiveCamera()->_position;
-				float dist = lineSegement.getMagnitude();
-
-				if (dist < minDist) {
-					*pos = intersection;
-					minDist = dist;
-				}
+	if (_bruteForceQueries) {
+		_planeTree.queryAll(_candidates);
+	} else {
+		_planeTree.queryLine(ray.getOrigin(), ray.getDirection(), _candidates);
+	}
+
+	for (uint32 i = 0; i < _candidates.size(); i++) {
+		uint32 triangle = _candidates[i];
+		Math::Vector3d intersection;
+
+		if (lineIntersectsTriangle(ray.getOrigin(), ray.getDirection(),
+		                           _planeTree.getVertex(triangle, 0),
+		                           _planeTree.getVertex(triangle, 1),
+		                           _planeTree.getVertex(triangle, 2),
+		                           intersection.x(), intersection.y(), intersection.z())) {
+			Math::Vector3d lineSegement = intersection - getActiveCamera()->_position;
+			float dist = lineSegement.getMagnitude();
 
-				intFound = true;
+			if (dist < minDist) {
+				*pos = intersection;
+				minDist = dist;
 			}
+
+			intFound = true;
 		}
 	}
 
@@ -1032,6 +1077,7 @@ bool AdSceneGeometry::enableNode(const char *nodeName, bool enable) {
 	for (i = 0; i < _blocks.size(); i++) {
 		if (scumm_stricmp(nodeName, _blocks[i]->getName()) == 0) {
 			_blocks[i]->_active = enable;
+			_blockTree.setOwnerActive(i, enable);
 			ret = true;
 		}
 	}
@@ -1229,6 +1275,10 @@ bool AdSceneGeometry::persist(BasePersistenceManager *persistMgr) {
 		}
 	}
 
+	if (!persistMgr->getIsSaving()) {
+		updateBlockTree();
+	}
+
 	//////////////////////////////////////////////////////////////////////////
 	int numPlanes = _planes.size();
 	persistMgr->transferSint32(TMEMBER(numPlanes));
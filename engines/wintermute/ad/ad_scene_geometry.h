@@ -29,6 +29,7 @@
 #ifndef WINTERMUTE_AD_SCENE_GEOMETRY_H
 #define WINTERMUTE_AD_SCENE_GEOMETRY_H
 
+#include "engines/wintermute/ad/ad_geometry_bvh.h"
 #include "engines/wintermute/base/base_object.h"
 #include "engines/wintermute/math/rect32.h"
 #include "math/matrix4.h"
@@ -116,7 +117,19 @@ public:
 	BaseArray<AdWaypointGroup3D *> _waypointGroups;
 	uint32 _PFMaxTime;
 
+	// Scan all triangles instead of using the trees, only for comparing the two
+	bool _bruteForceQueries;
+	// Record the positions getHeightAt() is called for, which are mostly
+	// actor positions. Recording clears the previous ones.
+	void setRecordPositions(bool record);
+	// The last recorded positions, oldest first
+	void getRecordedPositions(Common::Array<Math::Vector3d> &positions) const;
+
 private:
+	static const uint32 kMaxRecordedPositions = 1024;
+
+	void buildGeometryTrees();
+	void updateBlockTree();
 	AdGeomExt *getGeometryExtension(char *filename);
 	Math::Vector3d getBlockIntersection(Math::Vector3d *p1, Math::Vector3d *p2);
 	bool _PFReady;
@@ -127,6 +140,13 @@ private:
 	float _PFAlternateDist;
 	bool _PFRerun;
 	BaseArray<AdPathPoint3D *> _PFPath;
+
+	AdGeometryBVH _planeTree;
+	AdGeometryBVH _blockTree;
+	Common::Array<uint32> _candidates;
+	bool _recordPositions;
+	Common::Array<Math::Vector3d> _recordedPositions;
+	uint32 _nextRecordedPosition;
 };
 
 } // namespace Wintermute
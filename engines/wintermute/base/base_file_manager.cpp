@@ -59,6 +59,7 @@ BaseFileManager::BaseFileManager(Common::Language lang, bool detectionMode) {
 	_detectionMode = detectionMode;
 	_language = lang;
 	_resources = nullptr;
+	_packages.setMemberIndexEnabled(true);
 	initResources();
 	initPaths();
 	registerPackages();
@@ -41,6 +41,7 @@
 #endif
 #include "engines/wintermute/base/base_keyboard_state.h"
 #include "engines/wintermute/base/base_parser.h"
+#include "engines/wintermute/base/base_persistence_manager.h"
 #include "engines/wintermute/base/base_quick_msg.h"
 #include "engines/wintermute/base/sound/base_sound_manager.h"
 #include "engines/wintermute/base/base_sprite.h"
@@ -221,6 +222,7 @@ BaseGame::BaseGame(const Common::String &targetName) : BaseObject(this), _target
 	_miniUpdateEnabled = false;
 
 	_cachedThumbnail = nullptr;
+	_saveSnapshot = nullptr;
 
 	_autorunDisabled = false;
 
@@ -262,6 +264,7 @@ BaseGame::~BaseGame() {
 
 	cleanup();
 
+	delete _saveSnapshot;
 	delete _mathClass;
 	delete _directoryClass;
 
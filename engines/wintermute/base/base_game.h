@@ -67,6 +67,7 @@ class UIWindow;
 class VideoPlayer;
 class VideoTheoraPlayer;
 class SaveThumbHelper;
+class SaveSnapshot;
 
 #ifdef ENABLE_WME3D
 class BaseRenderer3D;
@@ -285,6 +286,7 @@ public:
 	void deleteSaveThumbnail();
 
 	SaveThumbHelper *_cachedThumbnail;
+	SaveSnapshot *_saveSnapshot; ///< Base of the incremental saves, see BasePersistenceManager::setIncremental()
 	void addMem(int32 bytes);
 	bool _touchInterface;
 	bool _constrainedMemory;
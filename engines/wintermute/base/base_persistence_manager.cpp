@@ -39,6 +39,7 @@
 #include "engines/wintermute/wintermute.h"
 #include "graphics/scaler.h"
 #include "image/bmp.h"
+#include "common/endian.h"
 #include "common/memstream.h"
 #include "common/str.h"
 #include "common/system.h"
@@ -59,6 +60,13 @@ namespace Wintermute {
 // in case we ever want to attempt to support original savegames, we
 // avoid those numbers, and use this instead:
 #define SAVE_MAGIC_3    0x12564154
+// Incremental saves have the same header, but their data is stored as
+// changes to the snapshot file kept next to them
+#define SAVE_MAGIC_INCREMENTAL 0x12564155
+#define SNAPSHOT_MAGIC  0x12564156
+
+// Marks a chunk of an incremental save which is stored in place
+#define CHUNK_LITERAL   0xFFFFFFFF
 
 //////////////////////////////////////////////////////////////////////////
 BasePersistenceManager::BasePersistenceManager(const Common::String &savePrefix, bool deleteSingleton) {
@@ -67,6 +75,16 @@ BasePersistenceManager::BasePersistenceManager(const Common::String &savePrefix,
 	_saveStream = nullptr;
 	_loadStream = nullptr;
 	_deleteSingleton = deleteSingleton;
+	_incremental = false;
+	_loadedIncremental = false;
+	_headerSize = 0;
+	_instanceStart = 0;
+	_instanceDataStart = 0;
+	_instanceDataEnd = 0;
+	_instanceClassID = 0;
+	_instanceID = 0;
+	_instanceGeneration = 0;
+	_instanceReused = false;
 	if (BaseEngine::instance().getGameRef()) {
 		_gameRef = BaseEngine::instance().getGameRef();
 	} else {
@@ -117,6 +135,9 @@ BasePersistenceManager::~BasePersistenceManager() {
 //////////////////////////////////////////////////////////////////////////
 void BasePersistenceManager::cleanup() {
 	_offset = 0;
+	_loadedIncremental = false;
+	_headerSize = 0;
+	_instanceBlocks.clear();
 
 	delete[] _richBuffer;
 	_richBuffer = nullptr;
@@ -194,6 +215,12 @@ void BasePersistenceManager::getSaveStateDesc(int slot, SaveStateDescriptor &des
 void BasePersistenceManager::deleteSaveSlot(int slot) {
 	Common::String filename = getFilenameForSlot(slot);
 	g_system->getSavefileManager()->removeSavefile(filename);
+
+	removeSnapshots(filename);
+	if (_gameRef && _gameRef->_saveSnapshot && _gameRef->_saveSnapshot->_filename == filename) {
+		delete _gameRef->_saveSnapshot;
+		_gameRef->_saveSnapshot = nullptr;
+	}
 }
 
 uint32 BasePersistenceManager::getMaxUsedSlot() {
@@ -310,6 +337,8 @@ bool BasePersistenceManager::initSave(const Common::String &desc) {
 		putTimeDate(_savedTimestamp);
 		_savedPlayTime = g_system->getMillis();
 		_saveStream->writeUint32LE(_savedPlayTime);
+
+		_headerSize = _saveStream->pos();
 	}
 	return STATUS_OK;
 }
@@ -332,7 +361,8 @@ bool BasePersistenceManager::readHeader(const Common::String &filename) {
 
 		magic = getDWORD();
 
-		if (magic == SAVE_MAGIC_3) {
+		if (magic == SAVE_MAGIC_3 || magic == SAVE_MAGIC_INCREMENTAL) {
+			_loadedIncremental = (magic == SAVE_MAGIC_INCREMENTAL);
 			_savedVerMajor = _loadStream->readByte();
 			_savedVerMinor = _loadStream->readByte();
 			_savedExtMajor = _loadStream->readByte();
@@ -414,27 +444,421 @@ bool BasePersistenceManager::initLoad(const Common::String &filename) {
 
 	}
 
+	if (_loadedIncremental && DID_FAIL(loadIncrementalData(filename))) {
+		cleanup();
+		return STATUS_FAILED;
+	}
+
 	return STATUS_OK;
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 bool BasePersistenceManager::saveFile(const Common::String &filename) {
-	byte *prefixBuffer = _richBuffer;
-	uint32 prefixSize = _richBufferSize;
+	if (_incremental && _richBufferSize == 0) {
+		return saveIncrementalFile(filename);
+	}
+
 	byte *buffer = ((Common::MemoryWriteStreamDynamic *)_saveStream)->getData();
 	uint32 bufferSize = ((Common::MemoryWriteStreamDynamic *)_saveStream)->size();
 
+	if (!writeSaveFile(filename, buffer, bufferSize)) {
+		return false;
+	}
+
+	// A snapshot left over from incremental saves to this file is of no use anymore
+	SaveSnapshot *&snapshot = _gameRef->_saveSnapshot;
+	if (snapshot && snapshot->_filename == filename) {
+		delete snapshot;
+		snapshot = nullptr;
+	}
+	removeSnapshots(filename);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool BasePersistenceManager::writeSaveFile(const Common::String &filename, const byte *data, uint32 size) {
 	Common::SaveFileManager *saveMan = ((WintermuteEngine *)g_engine)->getSaveFileMan();
 	Common::OutSaveFile *file = saveMan->openForSaving(filename);
-	file->write(prefixBuffer, prefixSize);
-	file->write(buffer, bufferSize);
+	if (!file) {
+		return false;
+	}
+	file->write(_richBuffer, _richBufferSize);
+	file->write(data, size);
 	bool retVal = !file->err();
 	file->finalize();
 	delete file;
 	return retVal;
 }
 
+//////////////////////////////////////////////////////////////////////////
+Common::String BasePersistenceManager::getSnapshotFilename(const Common::String &filename, uint32 version) {
+	// Must not match the pattern of the save slots
+	return Common::String::format("%s.snapshot%u", filename.c_str(), version);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void BasePersistenceManager::removeSnapshots(const Common::String &filename, int keepVersion) {
+	Common::SaveFileManager *saveMan = g_system->getSavefileManager();
+	Common::StringArray snapshots = saveMan->listSavefiles(filename + ".snapshot*");
+	for (Common::StringArray::iterator it = snapshots.begin(); it != snapshots.end(); ++it) {
+		if (keepVersion < 0 || *it != getSnapshotFilename(filename, keepVersion)) {
+			saveMan->removeSavefile(*it);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint32 BasePersistenceManager::getNewSnapshotVersion(const Common::String &filename) {
+	// Newer than any snapshot of the file, so the one the save refers to now stays intact
+	uint32 version = 0;
+	if (_gameRef->_saveSnapshot && _gameRef->_saveSnapshot->_filename == filename) {
+		version = _gameRef->_saveSnapshot->_version + 1;
+	}
+	Common::String prefix = filename + ".snapshot";
+	Common::StringArray snapshots = g_system->getSavefileManager()->listSavefiles(prefix + "*");
+	for (Common::StringArray::iterator it = snapshots.begin(); it != snapshots.end(); ++it) {
+		uint32 existing = (uint32)atoi(it->c_str() + prefix.size());
+		version = MAX(version, existing + 1);
+	}
+	return version;
+}
+
+//////////////////////////////////////////////////////////////////////////
+uint64 BasePersistenceManager::newDirtyGeneration() {
+	static uint64 lastGeneration = 0;
+	return ++lastGeneration;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void BasePersistenceManager::beginInstance(int classID, int instanceID) {
+	if (!_saving || !_incremental) {
+		return;
+	}
+	_instanceStart = _saveStream->pos();
+	_instanceClassID = classID;
+	_instanceID = instanceID;
+	_instanceGeneration = 0;
+	_instanceReused = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void BasePersistenceManager::beginInstanceData() {
+	if (!_saving || !_incremental) {
+		return;
+	}
+	_instanceDataStart = _saveStream->pos();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void BasePersistenceManager::endInstanceData() {
+	if (!_saving || !_incremental) {
+		return;
+	}
+	_instanceDataEnd = _saveStream->pos();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool BasePersistenceManager::reuseInstanceData(uint64 generation) {
+	if (!_saving || !_incremental) {
+		return false;
+	}
+	_instanceGeneration = generation;
+
+	const SaveSnapshot *snapshot = _gameRef->_saveSnapshot;
+	if (!snapshot || !generation) {
+		return false;
+	}
+	SaveSnapshot::BlockMap::const_iterator it = snapshot->_blocks.find(SaveSnapshot::blockKey(_instanceClassID, _instanceID));
+	if (it == snapshot->_blocks.end() || it->_value._generation != generation) {
+		return false;
+	}
+
+	// Unchanged since the snapshot was taken
+	_saveStream->write(snapshot->_data + it->_value._dataOffset, it->_value._dataSize);
+	_instanceReused = true;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void BasePersistenceManager::endInstance() {
+	if (!_saving || !_incremental) {
+		return;
+	}
+	SaveSnapshot::Block block;
+	block._key = SaveSnapshot::blockKey(_instanceClassID, _instanceID);
+	block._offset = _instanceStart - _headerSize;
+	block._size = _saveStream->pos() - _instanceStart;
+	block._dataOffset = _instanceDataStart - _headerSize;
+	block._dataSize = _instanceDataEnd - _instanceDataStart;
+	block._generation = _instanceGeneration;
+	block._reused = _instanceReused;
+	_instanceBlocks.push_back(block);
+}
+
+//////////////////////////////////////////////////////////////////////////
+static uint32 computeSnapshotChecksum(const byte *data, uint32 size) {
+	uint32 hash = 2166136261U;
+	for (uint32 i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 16777619U;
+	}
+	return hash ^ size;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool BasePersistenceManager::saveIncrementalFile(const Common::String &filename) {
+	Common::SaveFileManager *saveMan = ((WintermuteEngine *)g_engine)->getSaveFileMan();
+	const byte *data = ((Common::MemoryWriteStreamDynamic *)_saveStream)->getData();
+	const uint32 dataSize = ((Common::MemoryWriteStreamDynamic *)_saveStream)->size();
+	const byte *body = data + _headerSize;
+	const uint32 bodySize = dataSize - _headerSize;
+
+	// Store the instances which did not change since the snapshot as references into it
+	Common::MemoryWriteStreamDynamic chunks(DisposeAfterUse::YES);
+	uint32 numChunks = 0;
+	uint32 literalSize = 0;
+
+	SaveSnapshot *&snapshot = _gameRef->_saveSnapshot;
+	if (snapshot && snapshot->_filename == filename) {
+		uint32 pos = 0;
+		uint32 refOffset = 0, refSize = 0;
+
+		for (uint32 i = 0; i < _instanceBlocks.size(); i++) {
+			const SaveSnapshot::Block &block = _instanceBlocks[i];
+			SaveSnapshot::BlockMap::const_iterator it = snapshot->_blocks.find(block._key);
+			// A reused block is known to be unchanged, there is no need to compare it
+			if (it == snapshot->_blocks.end() || it->_value._size != block._size ||
+			        (!block._reused && memcmp(snapshot->_data + it->_value._offset, body + block._offset, block._size) != 0)) {
+				continue;
+			}
+
+			if (block._offset > pos) {
+				if (refSize) {
+					chunks.writeUint32LE(refOffset);
+					chunks.writeUint32LE(refSize);
+					numChunks++;
+					refSize = 0;
+				}
+				chunks.writeUint32LE(CHUNK_LITERAL);
+				chunks.writeUint32LE(block._offset - pos);
+				chunks.write(body + pos, block._offset - pos);
+				literalSize += block._offset - pos;
+				numChunks++;
+			}
+
+			// Merge references to consecutive blocks
+			if (refSize && refOffset + refSize == it->_value._offset) {
+				refSize += block._size;
+			} else {
+				if (refSize) {
+					chunks.writeUint32LE(refOffset);
+					chunks.writeUint32LE(refSize);
+					numChunks++;
+				}
+				refOffset = it->_value._offset;
+				refSize = block._size;
+			}
+			pos = block._offset + block._size;
+		}
+
+		if (refSize) {
+			chunks.writeUint32LE(refOffset);
+			chunks.writeUint32LE(refSize);
+			numChunks++;
+		}
+		if (bodySize > pos) {
+			chunks.writeUint32LE(CHUNK_LITERAL);
+			chunks.writeUint32LE(bodySize - pos);
+			chunks.write(body + pos, bodySize - pos);
+			literalSize += bodySize - pos;
+			numChunks++;
+		}
+	}
+
+	// Take a new snapshot if there is none yet, or too much has changed since.
+	// It gets a new version, so the current one stays valid until the save
+	// referring to the new one has been written.
+	SaveSnapshot *newSnapshot = nullptr;
+	if (!snapshot || snapshot->_filename != filename || literalSize > bodySize / 2) {
+		newSnapshot = new SaveSnapshot();
+		newSnapshot->_filename = filename;
+		newSnapshot->_version = getNewSnapshotVersion(filename);
+		newSnapshot->_size = bodySize;
+		newSnapshot->_data = (byte *)malloc(MAX<uint32>(bodySize, 1));
+		memcpy(newSnapshot->_data, body, bodySize);
+		newSnapshot->_checksum = computeSnapshotChecksum(body, bodySize);
+		for (uint32 i = 0; i < _instanceBlocks.size(); i++) {
+			newSnapshot->_blocks[_instanceBlocks[i]._key] = _instanceBlocks[i];
+		}
+
+		Common::String snapshotFilename = getSnapshotFilename(filename, newSnapshot->_version);
+		Common::OutSaveFile *file = saveMan->openForSaving(snapshotFilename);
+		bool written = false;
+		if (file) {
+			file->writeUint32LE(SNAPSHOT_MAGIC);
+			file->writeUint32LE(newSnapshot->_checksum);
+			file->writeUint32LE(newSnapshot->_size);
+			file->write(newSnapshot->_data, newSnapshot->_size);
+			written = !file->err();
+			file->finalize();
+			delete file;
+		}
+		if (!written) {
+			// Fall back to a standalone save
+			saveMan->removeSavefile(snapshotFilename);
+			delete newSnapshot;
+			_incremental = false;
+			return saveFile(filename);
+		}
+
+		numChunks = 1;
+		literalSize = 0;
+	}
+
+	const SaveSnapshot *current = newSnapshot ? newSnapshot : snapshot;
+	debugC(kWintermuteDebugSaveGame, "Incremental save of %s: %d of %d bytes changed", filename.c_str(), literalSize, bodySize);
+
+	Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+	out.write(data, _headerSize);
+	WRITE_LE_UINT32(out.getData() + 4, SAVE_MAGIC_INCREMENTAL);
+	out.writeUint32LE(current->_version);
+	out.writeUint32LE(current->_size);
+	out.writeUint32LE(current->_checksum);
+	out.writeUint32LE(bodySize);
+	out.writeUint32LE(numChunks);
+	if (newSnapshot) {
+		// Everything is in the snapshot
+		out.writeUint32LE(0);
+		out.writeUint32LE(bodySize);
+	} else {
+		out.write(chunks.getData(), chunks.size());
+	}
+
+	if (!writeSaveFile(filename, out.getData(), out.size())) {
+		// The save still refers to the old snapshot, if it was written at all
+		if (newSnapshot) {
+			saveMan->removeSavefile(getSnapshotFilename(filename, newSnapshot->_version));
+			delete newSnapshot;
+		}
+		return false;
+	}
+
+	if (newSnapshot) {
+		delete snapshot;
+		snapshot = newSnapshot;
+		removeSnapshots(filename, newSnapshot->_version);
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool BasePersistenceManager::loadIncrementalData(const Common::String &filename) {
+	uint32 version = getDWORD();
+	uint32 snapshotSize = getDWORD();
+	uint32 checksum = getDWORD();
+	uint32 bodySize = getDWORD();
+	uint32 numChunks = getDWORD();
+
+	Common::SaveFileManager *saveMan = g_system->getSavefileManager();
+	Common::InSaveFile *file = saveMan->openForLoading(getSnapshotFilename(filename, version));
+	if (!file) {
+		debugC(kWintermuteDebugSaveGame, "ERROR: Snapshot of incremental save %s is missing", filename.c_str());
+		return STATUS_FAILED;
+	}
+
+	byte *snapshot = nullptr;
+	if (file->readUint32LE() == SNAPSHOT_MAGIC && file->readUint32LE() == checksum && file->readUint32LE() == snapshotSize) {
+		snapshot = (byte *)malloc(MAX<uint32>(snapshotSize, 1));
+		if (file->read(snapshot, snapshotSize) != snapshotSize || computeSnapshotChecksum(snapshot, snapshotSize) != checksum) {
+			free(snapshot);
+			snapshot = nullptr;
+		}
+	}
+	delete file;
+	if (!snapshot) {
+		debugC(kWintermuteDebugSaveGame, "ERROR: Snapshot of incremental save %s does not match", filename.c_str());
+		return STATUS_FAILED;
+	}
+
+	// Put the instance data back together
+	byte *body = (byte *)malloc(MAX<uint32>(bodySize, 1));
+	uint32 pos = 0;
+	bool ok = true;
+	for (uint32 i = 0; i < numChunks && ok; i++) {
+		uint32 offset = getDWORD();
+		uint32 size = getDWORD();
+		if (size > bodySize - pos) {
+			ok = false;
+		} else if (offset == CHUNK_LITERAL) {
+			ok = getBytes(body + pos, size) == STATUS_OK;
+		} else if (offset > snapshotSize || size > snapshotSize - offset) {
+			ok = false;
+		} else {
+			memcpy(body + pos, snapshot + offset, size);
+		}
+		pos += size;
+	}
+	free(snapshot);
+
+	if (!ok || pos != bodySize) {
+		debugC(kWintermuteDebugSaveGame, "ERROR: Incremental save %s is corrupt", filename.c_str());
+		free(body);
+		return STATUS_FAILED;
+	}
+
+	delete _loadStream;
+	_loadStream = new Common::MemoryReadStream(body, bodySize, DisposeAfterUse::YES);
+	return STATUS_OK;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool BasePersistenceManager::compactSave(const Common::String &filename) {
+	if (DID_FAIL(readHeader(filename))) {
+		return STATUS_FAILED;
+	}
+	if (!_loadedIncremental) {
+		// Nothing to do
+		cleanup();
+		return STATUS_OK;
+	}
+
+	uint32 headerSize = _loadStream->pos();
+	if (DID_FAIL(loadIncrementalData(filename))) {
+		cleanup();
+		return STATUS_FAILED;
+	}
+
+	// Read the header again, now to copy it
+	Common::InSaveFile *file = g_system->getSavefileManager()->openForLoading(filename);
+	if (!file) {
+		cleanup();
+		return STATUS_FAILED;
+	}
+	uint32 bodySize = _loadStream->size();
+	byte *data = (byte *)malloc(headerSize + bodySize);
+	bool ok = file->read(data, headerSize) == headerSize;
+	delete file;
+	ok = ok && _loadStream->read(data + headerSize, bodySize) == bodySize;
+	WRITE_LE_UINT32(data + 4, SAVE_MAGIC_3);
+
+	cleanup();
+	_saving = true;
+	ok = ok && writeSaveFile(filename, data, headerSize + bodySize);
+	_saving = false;
+	free(data);
+	if (!ok) {
+		return STATUS_FAILED;
+	}
+
+	removeSnapshots(filename);
+
+	if (_gameRef && _gameRef->_saveSnapshot && _gameRef->_saveSnapshot->_filename == filename) {
+		delete _gameRef->_saveSnapshot;
+		_gameRef->_saveSnapshot = nullptr;
+	}
+	return STATUS_OK;
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 bool BasePersistenceManager::putBytes(byte *buffer, uint32 size) {
@@ -37,6 +37,8 @@
 #include "common/str.h"
 #include "common/system.h"
 #include "common/rect.h"
+#include "common/array.h"
+#include "common/hashmap.h"
 
 #ifdef ENABLE_WME3D
 namespace Math {
@@ -53,12 +55,69 @@ namespace Wintermute {
 
 class Vector2;
 class BaseGame;
+
+/**
+ * The saved data of all persistent instances, as written by the last full
+ * save to a file. Incremental saves to the same file only store what changed
+ * since then, and refer to this for the rest.
+ */
+class SaveSnapshot {
+public:
+	struct Block {
+		uint64 _key;
+		uint32 _offset;
+		uint32 _size;
+		uint32 _dataOffset;  ///< What the instance persisted itself, without the instance header
+		uint32 _dataSize;
+		uint64 _generation;  ///< The dirty generation of the instance, 0 if it has none
+		bool _reused;        ///< The data was copied from the snapshot
+	};
+
+	struct BlockKey_Hash {
+		uint operator()(uint64 key) const { return (uint)(key ^ (key >> 32)); }
+	};
+	typedef Common::HashMap<uint64, Block, BlockKey_Hash> BlockMap;
+
+	SaveSnapshot() : _data(nullptr), _size(0), _checksum(0), _version(0) {}
+	~SaveSnapshot() { free(_data); }
+
+	static uint64 blockKey(int classID, int instanceID) { return ((uint64)(uint32)classID << 32) | (uint32)instanceID; }
+
+	Common::String _filename; ///< The save file which refers to this snapshot
+	byte *_data;
+	uint32 _size;
+	uint32 _checksum;
+	uint32 _version;          ///< Part of the file name, so a new snapshot never overwrites the one in use
+	BlockMap _blocks;         ///< Where the data of every instance is
+};
+
 class BasePersistenceManager {
 public:
 	char *_savedDescription;
 	Common::String _savePrefix;
 	Common::String _savedName;
 	bool saveFile(const Common::String &filename);
+	/**
+	 * Make incremental saves: only the instances that changed since the
+	 * last full save to the same file are stored, the rest refers to a copy
+	 * of that full save kept next to it. Must be set before initSave().
+	 */
+	void setIncremental(bool incremental) { _incremental = incremental; }
+	void beginInstance(int classID, int instanceID);
+	void beginInstanceData();
+	void endInstanceData();
+	void endInstance();
+	/**
+	 * For persist() of objects which keep a dirty generation. When making an
+	 * incremental save, the data of an object which did not change since the
+	 * snapshot is copied from it and true is returned; the object must not
+	 * persist anything itself then.
+	 */
+	bool reuseInstanceData(uint64 generation);
+	/** A new dirty generation for an object which changed, never 0. */
+	static uint64 newDirtyGeneration();
+	/** Turn an incremental save into a standalone one. */
+	bool compactSave(const Common::String &filename);
 	uint32 getDWORD();
 	void putDWORD(uint32 val);
 	char *getString();
@@ -115,6 +174,23 @@ public:
 private:
 	bool _deleteSingleton;
 	bool readHeader(const Common::String &filename);
+	bool loadIncrementalData(const Common::String &filename);
+	bool saveIncrementalFile(const Common::String &filename);
+	bool writeSaveFile(const Common::String &filename, const byte *data, uint32 size);
+	static Common::String getSnapshotFilename(const Common::String &filename, uint32 version);
+	static void removeSnapshots(const Common::String &filename, int keepVersion = -1);
+	uint32 getNewSnapshotVersion(const Common::String &filename);
+	bool _incremental;
+	bool _loadedIncremental;
+	uint32 _headerSize;
+	uint32 _instanceStart;
+	uint32 _instanceDataStart;
+	uint32 _instanceDataEnd;
+	int _instanceClassID;
+	int _instanceID;
+	uint64 _instanceGeneration;
+	bool _instanceReused;
+	Common::Array<SaveSnapshot::Block> _instanceBlocks; ///< In the order they were saved
 	TimeDate getTimeDate();
 	bool putTimeDate(const TimeDate &t);
 	Common::WriteStream *_saveStream;
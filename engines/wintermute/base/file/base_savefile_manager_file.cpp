@@ -73,4 +73,9 @@ Common::StringArray sfmFileList(const Common::String &mask) {
 	return array;
 }
 
+bool sfmFileRemove(const Common::String &filename) {
+	Common::String smFilename = makeSfmFilename(filename);
+	return g_system->getSavefileManager()->removeSavefile(smFilename);
+}
+
 } // End of namespace Wintermute
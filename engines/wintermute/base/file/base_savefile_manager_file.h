@@ -38,6 +38,7 @@ Common::SeekableReadStream *openSfmFile(const Common::String &filename);
 Common::WriteStream *openSfmFileForWrite(const Common::String &filename);
 bool sfmFileExists(const Common::String &filename);
 Common::StringArray sfmFileList(const Common::String &mask);
+bool sfmFileRemove(const Common::String &filename);
 
 } // End of namespace Wintermute
 
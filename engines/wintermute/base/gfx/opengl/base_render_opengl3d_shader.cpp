@@ -254,7 +254,7 @@ bool BaseRenderOpenGL3DShader::drawLine(int x1, int y1, int x2, int y2, uint32 c
 
 	_lineShader->use();
 	_lineShader->setUniform("color", colorValue);
-	_fadeShader->setUniform("projMatrix", _projectionMatrix2d);
+	_lineShader->setUniform("projMatrix", _projectionMatrix2d);
 
 	glDrawArrays(GL_LINES, 0, 2);
 
@@ -417,6 +417,7 @@ bool BaseRenderOpenGL3DShader::initRenderer(int width, int height, bool windowed
 
 bool Wintermute::BaseRenderOpenGL3DShader::flip() {
 	g_system->updateScreen();
+	OpenGL::Shader::endFrame();
 	return true;
 }
 
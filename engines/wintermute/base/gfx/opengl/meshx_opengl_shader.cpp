@@ -60,6 +60,21 @@ bool MeshXOpenGLShader::loadFromX(const Common::String &filename, XFileLexer &le
 	return false;
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool MeshXOpenGLShader::loadCooked(Common::SeekableReadStream &stream, const Common::String &filename, Common::Array<MaterialReference> &materialReferences) {
+	if (MeshX::loadCooked(stream, filename, materialReferences)) {
+		glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, 4 * kVertexComponentCount * _vertexCount, _vertexData, GL_DYNAMIC_DRAW);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, 2 * _indexData.size(), _indexData.data(), GL_STATIC_DRAW);
+
+		return true;
+	}
+
+	return false;
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool MeshXOpenGLShader::render(ModelX *model) {
 	if (_vertexData == nullptr) {
@@ -40,6 +40,7 @@ public:
 	~MeshXOpenGLShader() override;
 
 	bool loadFromX(const Common::String &filename, XFileLexer &lexer, Common::Array<MaterialReference> &materialReferences) override;
+	bool loadCooked(Common::SeekableReadStream &stream, const Common::String &filename, Common::Array<MaterialReference> &materialReferences) override;
 	bool render(ModelX *model) override;
 	bool update(FrameNode *parentFrame) override;
 
@@ -29,6 +29,7 @@
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/gfx/x/animation.h"
 #include "engines/wintermute/base/gfx/x/animation_set.h"
+#include "engines/wintermute/base/gfx/x/cooked_x.h"
 #include "engines/wintermute/base/gfx/x/frame_node.h"
 #include "engines/wintermute/base/gfx/x/modelx.h"
 #include "engines/wintermute/base/gfx/x/loader_x.h"
@@ -135,6 +136,81 @@ bool Animation::loadFromX(XFileLexer &lexer, AnimationSet *parentAnimSet) {
 	return ret;
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool Animation::loadCooked(Common::SeekableReadStream &stream) {
+	_targetName = CookedX::readString(stream);
+
+	uint32 count;
+	if (!CookedX::readCount(stream, count, 4 + 3 * 4)) {
+		return false;
+	}
+	for (uint32 i = 0; i < count; i++) {
+		BonePositionKey *key = new BonePositionKey;
+		key->_time = stream.readUint32LE();
+		for (int j = 0; j < 3; j++) {
+			key->_pos.setValue(j, stream.readFloatLE());
+		}
+		_posKeys.push_back(key);
+	}
+
+	if (!CookedX::readCount(stream, count, 4 + 4 * 4)) {
+		return false;
+	}
+	for (uint32 i = 0; i < count; i++) {
+		BoneRotationKey *key = new BoneRotationKey;
+		key->_time = stream.readUint32LE();
+		key->_rotation.x() = stream.readFloatLE();
+		key->_rotation.y() = stream.readFloatLE();
+		key->_rotation.z() = stream.readFloatLE();
+		key->_rotation.w() = stream.readFloatLE();
+		_rotKeys.push_back(key);
+	}
+
+	if (!CookedX::readCount(stream, count, 4 + 3 * 4)) {
+		return false;
+	}
+	for (uint32 i = 0; i < count; i++) {
+		BoneScaleKey *key = new BoneScaleKey;
+		key->_time = stream.readUint32LE();
+		for (int j = 0; j < 3; j++) {
+			key->_scale.setValue(j, stream.readFloatLE());
+		}
+		_scaleKeys.push_back(key);
+	}
+
+	return CookedX::isValid(stream);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void Animation::saveCooked(Common::WriteStream &stream) {
+	CookedX::writeString(stream, _targetName);
+
+	stream.writeUint32LE(_posKeys.size());
+	for (uint32 i = 0; i < _posKeys.size(); i++) {
+		stream.writeUint32LE(_posKeys[i]->_time);
+		for (int j = 0; j < 3; j++) {
+			stream.writeFloatLE(_posKeys[i]->_pos.getValue(j));
+		}
+	}
+
+	stream.writeUint32LE(_rotKeys.size());
+	for (uint32 i = 0; i < _rotKeys.size(); i++) {
+		stream.writeUint32LE(_rotKeys[i]->_time);
+		stream.writeFloatLE(_rotKeys[i]->_rotation.x());
+		stream.writeFloatLE(_rotKeys[i]->_rotation.y());
+		stream.writeFloatLE(_rotKeys[i]->_rotation.z());
+		stream.writeFloatLE(_rotKeys[i]->_rotation.w());
+	}
+
+	stream.writeUint32LE(_scaleKeys.size());
+	for (uint32 i = 0; i < _scaleKeys.size(); i++) {
+		stream.writeUint32LE(_scaleKeys[i]->_time);
+		for (int j = 0; j < 3; j++) {
+			stream.writeFloatLE(_scaleKeys[i]->_scale.getValue(j));
+		}
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool Animation::update(int slot, uint32 localTime, float animLerpValue) {
 	// no target frame = no animation keys
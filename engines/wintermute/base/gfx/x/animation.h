@@ -34,6 +34,11 @@
 #include "math/quat.h"
 #include "math/vector3d.h"
 
+namespace Common {
+class SeekableReadStream;
+class WriteStream;
+}
+
 namespace Wintermute {
 
 class FrameNode;
@@ -46,6 +51,8 @@ public:
 	virtual ~Animation();
 
 	bool loadFromX(XFileLexer &lexer, AnimationSet *parentAnimationSet);
+	bool loadCooked(Common::SeekableReadStream &stream);
+	void saveCooked(Common::WriteStream &stream);
 
 	bool findBone(FrameNode *rootFrame);
 	bool update(int slot, uint32 localTime, float animLerpValue);
@@ -28,6 +28,7 @@
 
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/gfx/x/animation_set.h"
+#include "engines/wintermute/base/gfx/x/cooked_x.h"
 #include "engines/wintermute/base/gfx/x/modelx.h"
 #include "engines/wintermute/base/gfx/x/loader_x.h"
 #include "engines/wintermute/dcgf.h"
@@ -87,6 +88,45 @@ bool AnimationSet::loadFromX(XFileLexer &lexer, const Common::String &filename)
 	return ret;
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool AnimationSet::loadCooked(Common::SeekableReadStream &stream, const Common::String &filename) {
+	// unnamed animation sets are named after the file
+	Common::String name;
+	if (CookedX::readName(stream, name)) {
+		setName(name.c_str());
+	} else {
+		name = filename + "_animation";
+		setName(name.c_str());
+	}
+
+	uint32 count;
+	if (!CookedX::readCount(stream, count, 16)) {
+		return false;
+	}
+
+	for (uint32 i = 0; i < count; i++) {
+		Animation *animation = new Animation(_gameRef);
+		_animations.add(animation);
+
+		if (!animation->loadCooked(stream)) {
+			return false;
+		}
+	}
+
+	return CookedX::isValid(stream);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void AnimationSet::saveCooked(Common::WriteStream &stream, const Common::String &filename) {
+	Common::String defaultName = filename + "_animation";
+	CookedX::writeName(stream, getName() && defaultName != getName() ? getName() : nullptr);
+
+	stream.writeUint32LE(_animations.size());
+	for (uint32 i = 0; i < _animations.size(); i++) {
+		_animations[i]->saveCooked(stream);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool AnimationSet::findBones(FrameNode *rootFrame) {
 	for (uint32 i = 0; i < _animations.size(); i++) {
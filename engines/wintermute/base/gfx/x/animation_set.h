@@ -78,6 +78,8 @@ public:
 	virtual ~AnimationSet();
 
 	bool loadFromX(XFileLexer &lexer, const Common::String &filename);
+	bool loadCooked(Common::SeekableReadStream &stream, const Common::String &filename);
+	void saveCooked(Common::WriteStream &stream, const Common::String &filename);
 	bool findBones(FrameNode *rootFrame);
 	bool addAnimation(Animation *anim);
 	bool addEvent(AnimationEvent *event);
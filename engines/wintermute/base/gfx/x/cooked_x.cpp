@@ -0,0 +1,185 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/md5.h"
+#include "common/savefile.h"
+#include "engines/wintermute/base/file/base_savefile_manager_file.h"
+#include "engines/wintermute/base/gfx/x/cooked_x.h"
+
+namespace Wintermute {
+
+//////////////////////////////////////////////////////////////////////////
+bool CookedX::isEnabled() {
+	return ConfMan.getBool("cache_models");
+}
+
+//////////////////////////////////////////////////////////////////////////
+Common::String CookedX::getKey(const byte *buffer, uint32 size) {
+	Common::MemoryReadStream stream(buffer, size);
+	return Common::computeStreamMD5AsString(stream);
+}
+
+//////////////////////////////////////////////////////////////////////////
+Common::String CookedX::getFilename(const Common::String &key, Kind kind) {
+	return Common::String::format("xcache/%s.%s", key.c_str(), kind == kModel ? "xmodel" : "xanim");
+}
+
+//////////////////////////////////////////////////////////////////////////
+Common::SeekableReadStream *CookedX::open(const Common::String &key, Kind kind) {
+	Common::SeekableReadStream *file = openSfmFile(getFilename(key, kind));
+	if (!file) {
+		return nullptr;
+	}
+
+	uint32 size = file->size();
+	byte *buffer = nullptr;
+	if (size >= 16) {
+		buffer = (byte *)malloc(size);
+	}
+
+	if (!buffer || file->read(buffer, size) != size) {
+		free(buffer);
+		delete file;
+		return nullptr;
+	}
+	delete file;
+
+	Common::SeekableReadStream *stream = new Common::MemoryReadStream(buffer, size, DisposeAfterUse::YES);
+	if (stream->readUint32BE() != kMagic || stream->readUint32LE() != kVersion ||
+	    stream->readUint32LE() != (uint32)kind || stream->readUint32LE() != size - 16) {
+		debug(2, "CookedX::open ignoring outdated cooked file for %s", key.c_str());
+		delete stream;
+		return nullptr;
+	}
+
+	return stream;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CookedX::save(const Common::String &key, Kind kind, Common::MemoryWriteStreamDynamic &data) {
+	evict(key);
+
+	Common::WriteStream *file = openSfmFileForWrite(getFilename(key, kind));
+	if (!file) {
+		return false;
+	}
+
+	file->writeUint32BE(kMagic);
+	file->writeUint32LE(kVersion);
+	file->writeUint32LE(kind);
+	file->writeUint32LE(data.size());
+	file->write(data.getData(), data.size());
+	file->finalize();
+
+	bool ret = !file->err();
+	delete file;
+
+	return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CookedX::evict(const Common::String &key) {
+	// Keep the number of cooked files of this game bounded, so that they
+	// don't pile up in the save path when models change. Their names are
+	// hashes, so this drops arbitrary ones, but never the one about to be
+	// written.
+	Common::StringArray files = sfmFileList("xcache/*");
+	uint count = files.size();
+	for (uint i = 0; i < files.size() && count >= kMaxCookedFiles; i++) {
+		if (!files[i].contains(key) && sfmFileRemove(files[i])) {
+			count--;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CookedX::writeString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint32LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
+//////////////////////////////////////////////////////////////////////////
+Common::String CookedX::readString(Common::SeekableReadStream &stream) {
+	uint32 size;
+	if (!readCount(stream, size, 1)) {
+		return Common::String();
+	}
+
+	Common::String str;
+	for (uint32 i = 0; i < size; i++) {
+		str += (char)stream.readByte();
+	}
+
+	return str;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CookedX::writeName(Common::WriteStream &stream, const char *name) {
+	stream.writeByte(name != nullptr);
+	if (name) {
+		writeString(stream, name);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CookedX::readName(Common::SeekableReadStream &stream, Common::String &name) {
+	if (stream.readByte()) {
+		name = readString(stream);
+		return true;
+	}
+
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CookedX::writeMatrix(Common::WriteStream &stream, const Math::Matrix4 &matrix) {
+	for (int i = 0; i < 16; i++) {
+		stream.writeFloatLE(matrix.getData()[i]);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+void CookedX::readMatrix(Common::SeekableReadStream &stream, Math::Matrix4 &matrix) {
+	for (int i = 0; i < 16; i++) {
+		matrix.getData()[i] = stream.readFloatLE();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool CookedX::readCount(Common::SeekableReadStream &stream, uint32 &count, uint32 elementSize) {
+	count = stream.readUint32LE();
+	if (!isValid(stream)) {
+		count = 0;
+		return false;
+	}
+
+	if (count > (uint32)(stream.size() - stream.pos()) / elementSize) {
+		count = 0;
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace Wintermute
@@ -0,0 +1,96 @@
+/* ResidualVM - A 3D game interpreter
+ *
+ * ResidualVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WINTERMUTE_COOKED_X_H
+#define WINTERMUTE_COOKED_X_H
+
+#include "common/memstream.h"
+#include "common/str.h"
+#include "math/matrix4.h"
+
+namespace Wintermute {
+
+/**
+ * Stores the parsed contents of .X files in the save path, so that loading
+ * the same model again only needs to read the result back instead of going
+ * through XFileLexer and generating the mesh adjacency again.
+ *
+ * Cooked files are named after the MD5 of the .X file they were made from,
+ * so a changed model never uses an old cooked file. Everything that depends
+ * on the name of the .X file, like the paths of textures, is stored relative
+ * to it. Cooked files which are damaged or come from an older version of
+ * this code are ignored, and the model is parsed as usual. At most
+ * kMaxCookedFiles are kept for a game, older ones are removed when a new
+ * one is written.
+ */
+class CookedX {
+public:
+	enum Kind {
+		kModel = 0,     ///< the result of ModelX::loadFromFile()
+		kAnimations = 1 ///< the animation sets of ModelX::mergeFromFile()
+	};
+
+	static bool isEnabled();
+
+	/** The key of a .X file, to look up its cooked version. */
+	static Common::String getKey(const byte *buffer, uint32 size);
+
+	/**
+	 * Read the whole cooked file for the key with a single read. Returns
+	 * nullptr if there is none, or if it is not usable.
+	 */
+	static Common::SeekableReadStream *open(const Common::String &key, Kind kind);
+	static bool save(const Common::String &key, Kind kind, Common::MemoryWriteStreamDynamic &data);
+
+	static void writeString(Common::WriteStream &stream, const Common::String &str);
+	static Common::String readString(Common::SeekableReadStream &stream);
+
+	/** Names of named objects can also be missing. */
+	static void writeName(Common::WriteStream &stream, const char *name);
+	static bool readName(Common::SeekableReadStream &stream, Common::String &name);
+
+	static void writeMatrix(Common::WriteStream &stream, const Math::Matrix4 &matrix);
+	static void readMatrix(Common::SeekableReadStream &stream, Math::Matrix4 &matrix);
+
+	/**
+	 * Read the size of an array with elements of at least elementSize bytes,
+	 * failing if the rest of the stream could not hold it.
+	 */
+	static bool readCount(Common::SeekableReadStream &stream, uint32 &count, uint32 elementSize);
+
+	static bool isValid(Common::SeekableReadStream &stream) { return !stream.err() && !stream.eos(); }
+
+private:
+	static const uint32 kMagic = MKTAG('W', 'X', 'C', 'K');
+	// Increase this whenever the cooked format or the parsing of .X files changes
+	static const uint32 kVersion = 1;
+	// The most cooked files kept for a game, models and animations together
+	static const uint kMaxCookedFiles = 256;
+
+	static Common::String getFilename(const Common::String &key, Kind kind);
+	/** Remove cooked files other than those of key while there are too many. */
+	static void evict(const Common::String &key);
+};
+
+} // namespace Wintermute
+
+#endif
@@ -28,6 +28,7 @@
 
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/gfx/base_renderer3d.h"
+#include "engines/wintermute/base/gfx/x/cooked_x.h"
 #include "engines/wintermute/base/gfx/x/material.h"
 #include "engines/wintermute/base/gfx/x/frame_node.h"
 #include "engines/wintermute/base/gfx/x/modelx.h"
@@ -230,6 +231,64 @@ bool FrameNode::loadFromXAsRoot(const Common::String &filename, XFileLexer &lexe
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool FrameNode::loadCooked(Common::SeekableReadStream &stream, const Common::String &filename, Common::Array<MaterialReference> &materialReferences) {
+	Common::String name;
+	if (CookedX::readName(stream, name)) {
+		setName(name.c_str());
+	}
+
+	CookedX::readMatrix(stream, _transformationMatrix);
+	CookedX::readMatrix(stream, _originalMatrix);
+
+	uint32 count;
+	if (!CookedX::readCount(stream, count, 4)) {
+		return false;
+	}
+
+	for (uint32 i = 0; i < count; i++) {
+		MeshX *mesh = _gameRef->_renderer3D->createMeshX();
+		_meshes.add(mesh);
+
+		if (!mesh->loadCooked(stream, filename, materialReferences)) {
+			return false;
+		}
+	}
+
+	if (!CookedX::readCount(stream, count, 1 + 2 * 16 * 4)) {
+		return false;
+	}
+
+	for (uint32 i = 0; i < count; i++) {
+		FrameNode *child = new FrameNode(_gameRef);
+		_frames.add(child);
+
+		if (!child->loadCooked(stream, filename, materialReferences)) {
+			return false;
+		}
+	}
+
+	return CookedX::isValid(stream);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void FrameNode::saveCooked(Common::WriteStream &stream, const Common::String &filename, const Common::Array<MaterialReference> &materialReferences) {
+	CookedX::writeName(stream, getName());
+
+	CookedX::writeMatrix(stream, _transformationMatrix);
+	CookedX::writeMatrix(stream, _originalMatrix);
+
+	stream.writeUint32LE(_meshes.size());
+	for (uint32 i = 0; i < _meshes.size(); i++) {
+		_meshes[i]->saveCooked(stream, filename, materialReferences);
+	}
+
+	stream.writeUint32LE(_frames.size());
+	for (uint32 i = 0; i < _frames.size(); i++) {
+		_frames[i]->saveCooked(stream, filename, materialReferences);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool FrameNode::findBones(FrameNode *rootFrame) {
 	// find the bones of the meshes
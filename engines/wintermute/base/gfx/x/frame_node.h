@@ -56,6 +56,8 @@ public:
 
 	bool loadFromX(const Common::String &filename, XFileLexer &lexer, ModelX *model, Common::Array<MaterialReference> &materialReferences);
 	bool loadFromXAsRoot(const Common::String &filename, XFileLexer &lexer, ModelX *model, Common::Array<MaterialReference> &materialReferences);
+	bool loadCooked(Common::SeekableReadStream &stream, const Common::String &filename, Common::Array<MaterialReference> &materialReferences);
+	void saveCooked(Common::WriteStream &stream, const Common::String &filename, const Common::Array<MaterialReference> &materialReferences);
 	bool findBones(FrameNode *rootFrame);
 	FrameNode *findFrame(const char *frameName);
 	Math::Matrix4 *getCombinedMatrix();
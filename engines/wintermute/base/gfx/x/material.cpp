@@ -30,6 +30,7 @@
 #include "engines/wintermute/base/base_sprite.h"
 #include "engines/wintermute/base/base_surface_storage.h"
 #include "engines/wintermute/base/gfx/base_surface.h"
+#include "engines/wintermute/base/gfx/x/cooked_x.h"
 #include "engines/wintermute/base/gfx/x/material.h"
 #include "engines/wintermute/base/gfx/x/loader_x.h"
 #include "engines/wintermute/dcgf.h"
@@ -188,4 +189,42 @@ bool Material::loadFromX(XFileLexer &lexer, const Common::String &filename) {
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool Material::loadCooked(Common::SeekableReadStream &stream, const Common::String &filename) {
+	// .X files have no ambient color
+	ColorValue *colors[] = { &_diffuse, &_specular, &_emissive };
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 4; j++) {
+			colors[i]->data[j] = stream.readFloatLE();
+		}
+	}
+	_shininess = stream.readFloatLE();
+
+	if (stream.readByte()) {
+		Common::String textureFilename = CookedX::readString(stream);
+		setTexture(PathUtil::getDirectoryName(filename) + textureFilename);
+	}
+
+	return CookedX::isValid(stream);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void Material::saveCooked(Common::WriteStream &stream, const Common::String &filename) {
+	const ColorValue *colors[] = { &_diffuse, &_specular, &_emissive };
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 4; j++) {
+			stream.writeFloatLE(colors[i]->data[j]);
+		}
+	}
+	stream.writeFloatLE(_shininess);
+
+	// textures are stored relative to the model, like in the .X file
+	Common::String directory = PathUtil::getDirectoryName(filename);
+	bool hasTexture = !_textureFilename.empty() && _textureFilename.hasPrefix(directory);
+	stream.writeByte(hasTexture);
+	if (hasTexture) {
+		CookedX::writeString(stream, Common::String(_textureFilename.c_str() + directory.size()));
+	}
+}
+
 } // namespace Wintermute
@@ -31,6 +31,11 @@
 
 #include "engines/wintermute/base/base_named_object.h"
 
+namespace Common {
+class SeekableReadStream;
+class WriteStream;
+}
+
 namespace Wintermute {
 
 class BaseSprite;
@@ -91,6 +96,8 @@ public:
 	BaseSurface *getSurface();
 
 	bool loadFromX(XFileLexer &lexer, const Common::String &filename);
+	bool loadCooked(Common::SeekableReadStream &stream, const Common::String &filename);
+	void saveCooked(Common::WriteStream &stream, const Common::String &filename);
 
 	bool invalidateDeviceObjects();
 	bool restoreDeviceObjects();
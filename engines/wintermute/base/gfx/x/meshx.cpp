@@ -27,6 +27,7 @@
  */
 
 #include "engines/wintermute/base/gfx/shadow_volume.h"
+#include "engines/wintermute/base/gfx/x/cooked_x.h"
 #include "engines/wintermute/base/gfx/x/material.h"
 #include "engines/wintermute/base/gfx/x/meshx.h"
 #include "engines/wintermute/base/gfx/x/frame_node.h"
@@ -34,6 +35,8 @@
 #include "engines/wintermute/base/gfx/x/modelx.h"
 #include "engines/wintermute/math/math_util.h"
 
+#include "math/simd.h"
+
 namespace Wintermute {
 
 // define constant to make it available to the linker
@@ -42,13 +45,17 @@ const uint32 MeshX::kNullIndex;
 MeshX::MeshX(Wintermute::BaseGame *inGame) : BaseNamedObject(inGame),
 	_BBoxStart(0.0f, 0.0f, 0.0f), _BBoxEnd(0.0f, 0.0f, 0.0f),
 	_vertexData(nullptr), _vertexPositionData(nullptr), _vertexNormalData(nullptr),
-	_vertexCount(0), _numAttrs(0), _skinnedMesh(false) {
+	_vertexCount(0), _skinBoneIndices(nullptr), _skinBoneWeights(nullptr), _skinPalette(nullptr),
+	_numAttrs(0), _skinnedMesh(false) {
 }
 
 MeshX::~MeshX() {
 	delete[] _vertexData;
 	delete[] _vertexPositionData;
 	delete[] _vertexNormalData;
+	delete[] _skinBoneIndices;
+	delete[] _skinBoneWeights;
+	delete[] _skinPalette;
 
 	_materials.clear();
 }
@@ -144,6 +151,181 @@ bool MeshX::loadFromX(const Common::String &filename, XFileLexer &lexer, Common:
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////
+bool MeshX::loadCooked(Common::SeekableReadStream &stream, const Common::String &filename, Common::Array<MaterialReference> &materialReferences) {
+	if (!CookedX::readCount(stream, _vertexCount, 4 * (kVertexComponentCount + 6))) {
+		return false;
+	}
+
+	_vertexData = new float[kVertexComponentCount * _vertexCount];
+	_vertexPositionData = new float[3 * _vertexCount];
+	_vertexNormalData = new float[3 * _vertexCount];
+
+	for (uint32 i = 0; i < kVertexComponentCount * _vertexCount; i++) {
+		_vertexData[i] = stream.readFloatLE();
+	}
+	for (uint32 i = 0; i < 3 * _vertexCount; i++) {
+		_vertexPositionData[i] = stream.readFloatLE();
+	}
+	for (uint32 i = 0; i < 3 * _vertexCount; i++) {
+		_vertexNormalData[i] = stream.readFloatLE();
+	}
+
+	uint32 count;
+	if (!CookedX::readCount(stream, count, 2)) {
+		return false;
+	}
+	_indexData.resize(count);
+	for (uint32 i = 0; i < count; i++) {
+		_indexData[i] = stream.readUint16LE();
+	}
+
+	// the adjacency is what takes longest to compute when parsing
+	if (!CookedX::readCount(stream, count, 4)) {
+		return false;
+	}
+	_adjacency.resize(count);
+	for (uint32 i = 0; i < count; i++) {
+		_adjacency[i] = stream.readUint32LE();
+	}
+
+	_skinnedMesh = stream.readByte() != 0;
+
+	if (!CookedX::readCount(stream, count, 4 + 16 * 4 + 4)) {
+		return false;
+	}
+	skinWeightsList.resize(count);
+	for (uint32 i = 0; i < count; i++) {
+		SkinWeights &skinWeights = skinWeightsList[i];
+		skinWeights._boneName = CookedX::readString(stream);
+		CookedX::readMatrix(stream, skinWeights._offsetMatrix);
+
+		uint32 weightCount;
+		if (!CookedX::readCount(stream, weightCount, 8)) {
+			return false;
+		}
+		skinWeights._vertexIndices.resize(weightCount);
+		skinWeights._vertexWeights.resize(weightCount);
+		for (uint32 j = 0; j < weightCount; j++) {
+			skinWeights._vertexIndices[j] = stream.readUint32LE();
+		}
+		for (uint32 j = 0; j < weightCount; j++) {
+			skinWeights._vertexWeights[j] = stream.readFloatLE();
+		}
+	}
+
+	// materials refer to the ones of the model where possible, the
+	// others belong to this mesh only
+	if (!CookedX::readCount(stream, count, 4)) {
+		return false;
+	}
+	for (uint32 i = 0; i < count; i++) {
+		int32 reference = stream.readSint32LE();
+
+		if (reference >= 0 && reference < (int32)materialReferences.size()) {
+			_materials.add(materialReferences[reference]._material);
+		} else if (reference == -1) {
+			Material *mat = new Material(_gameRef);
+			_materials.add(mat);
+
+			if (!mat->loadCooked(stream, filename)) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+
+	if (!CookedX::readCount(stream, count, 4)) {
+		return false;
+	}
+	_indexRanges.resize(count);
+	for (uint32 i = 0; i < count; i++) {
+		_indexRanges[i] = stream.readSint32LE();
+	}
+
+	if (!CookedX::readCount(stream, count, 4)) {
+		return false;
+	}
+	_materialIndices.resize(count);
+	for (uint32 i = 0; i < count; i++) {
+		_materialIndices[i] = stream.readSint32LE();
+	}
+
+	_numAttrs = stream.readUint32LE();
+
+	return CookedX::isValid(stream);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MeshX::saveCooked(Common::WriteStream &stream, const Common::String &filename, const Common::Array<MaterialReference> &materialReferences) {
+	stream.writeUint32LE(_vertexCount);
+	for (uint32 i = 0; i < kVertexComponentCount * _vertexCount; i++) {
+		stream.writeFloatLE(_vertexData[i]);
+	}
+	for (uint32 i = 0; i < 3 * _vertexCount; i++) {
+		stream.writeFloatLE(_vertexPositionData[i]);
+	}
+	for (uint32 i = 0; i < 3 * _vertexCount; i++) {
+		stream.writeFloatLE(_vertexNormalData[i]);
+	}
+
+	stream.writeUint32LE(_indexData.size());
+	for (uint32 i = 0; i < _indexData.size(); i++) {
+		stream.writeUint16LE(_indexData[i]);
+	}
+
+	stream.writeUint32LE(_adjacency.size());
+	for (uint32 i = 0; i < _adjacency.size(); i++) {
+		stream.writeUint32LE(_adjacency[i]);
+	}
+
+	stream.writeByte(_skinnedMesh);
+
+	stream.writeUint32LE(skinWeightsList.size());
+	for (uint32 i = 0; i < skinWeightsList.size(); i++) {
+		const SkinWeights &skinWeights = skinWeightsList[i];
+		CookedX::writeString(stream, skinWeights._boneName);
+		CookedX::writeMatrix(stream, skinWeights._offsetMatrix);
+
+		stream.writeUint32LE(skinWeights._vertexIndices.size());
+		for (uint32 j = 0; j < skinWeights._vertexIndices.size(); j++) {
+			stream.writeUint32LE(skinWeights._vertexIndices[j]);
+		}
+		for (uint32 j = 0; j < skinWeights._vertexWeights.size(); j++) {
+			stream.writeFloatLE(skinWeights._vertexWeights[j]);
+		}
+	}
+
+	stream.writeUint32LE(_materials.size());
+	for (uint32 i = 0; i < _materials.size(); i++) {
+		int32 reference = -1;
+		for (uint32 j = 0; j < materialReferences.size(); j++) {
+			if (materialReferences[j]._material == _materials[i]) {
+				reference = j;
+				break;
+			}
+		}
+
+		stream.writeSint32LE(reference);
+		if (reference == -1) {
+			_materials[i]->saveCooked(stream, filename);
+		}
+	}
+
+	stream.writeUint32LE(_indexRanges.size());
+	for (uint32 i = 0; i < _indexRanges.size(); i++) {
+		stream.writeSint32LE(_indexRanges[i]);
+	}
+
+	stream.writeUint32LE(_materialIndices.size());
+	for (uint32 i = 0; i < _materialIndices.size(); i++) {
+		stream.writeSint32LE(_materialIndices[i]);
+	}
+
+	stream.writeUint32LE(_numAttrs);
+}
+
 //////////////////////////////////////////////////////////////////////////
 bool MeshX::generateAdjacency() {
 	_adjacency = Common::Array<uint32>(_indexData.size(), kNullIndex);
@@ -205,9 +387,95 @@ bool MeshX::findBones(FrameNode *rootFrame) {
 			_boneMatrices[i] = frame->getCombinedMatrix();
 		} else {
 			warning("MeshXOpenGL::findBones could not find bone %s", skinWeightsList[i]._boneName.c_str());
+			_boneMatrices[i] = nullptr;
+		}
+	}
+
+	// turn the bone-major skin weights into a fixed number of influences
+	// per vertex, so that update() can skin one vertex after the other
+	delete[] _skinBoneIndices;
+	delete[] _skinBoneWeights;
+	delete[] _skinPalette;
+	_skinBoneIndices = new uint16[_vertexCount * kMaxBoneInfluences]();
+	_skinBoneWeights = new float[_vertexCount * kMaxBoneInfluences]();
+	_skinPalette = new float[skinWeightsList.size() * kSkinPaletteStride]();
+
+	// counts all influences of each vertex, including the dropped ones
+	uint16 *influenceCounts = new uint16[_vertexCount]();
+	float *droppedWeights = new float[_vertexCount]();
+
+	for (uint boneIndex = 0; boneIndex < skinWeightsList.size(); ++boneIndex) {
+		if (!_boneMatrices[boneIndex]) {
+			continue;
+		}
+
+		const SkinWeights &skinWeights = skinWeightsList[boneIndex];
+		for (uint i = 0; i < skinWeights._vertexIndices.size(); ++i) {
+			uint32 vertexIndex = skinWeights._vertexIndices[i];
+			float weight = skinWeights._vertexWeights[i];
+			if (vertexIndex >= _vertexCount || weight == 0.0f) {
+				continue;
+			}
+
+			uint16 *bones = _skinBoneIndices + vertexIndex * kMaxBoneInfluences;
+			float *weights = _skinBoneWeights + vertexIndex * kMaxBoneInfluences;
+			int slot = influenceCounts[vertexIndex];
+			if (influenceCounts[vertexIndex] < 0xFFFF) {
+				influenceCounts[vertexIndex]++;
+			}
+
+			if (slot >= kMaxBoneInfluences) {
+				// keep the strongest influences
+				slot = 0;
+				for (int j = 1; j < kMaxBoneInfluences; ++j) {
+					if (fabs(weights[j]) < fabs(weights[slot])) {
+						slot = j;
+					}
+				}
+
+				if (fabs(weight) <= fabs(weights[slot])) {
+					droppedWeights[vertexIndex] += weight;
+					continue;
+				}
+
+				droppedWeights[vertexIndex] += weights[slot];
+			}
+
+			bones[slot] = boneIndex;
+			weights[slot] = weight;
 		}
 	}
 
+	// scale the remaining weights of the vertices which lost influences,
+	// so that they add up to the same
+	uint32 droppedCount = 0;
+	for (uint32 i = 0; i < _vertexCount; ++i) {
+		if (influenceCounts[i] <= kMaxBoneInfluences) {
+			continue;
+		}
+
+		droppedCount++;
+		float *weights = _skinBoneWeights + i * kMaxBoneInfluences;
+		float sum = 0.0f;
+		for (int j = 0; j < kMaxBoneInfluences; ++j) {
+			sum += weights[j];
+		}
+
+		if (sum != 0.0f) {
+			float scale = (sum + droppedWeights[i]) / sum;
+			for (int j = 0; j < kMaxBoneInfluences; ++j) {
+				weights[j] *= scale;
+			}
+		}
+	}
+
+	if (droppedCount > 0) {
+		warning("MeshX::findBones: %d vertices of mesh %s have more than %d bones", droppedCount, getName(), kMaxBoneInfluences);
+	}
+
+	delete[] influenceCounts;
+	delete[] droppedWeights;
+
 	return true;
 }
 
@@ -219,82 +487,127 @@ bool MeshX::update(FrameNode *parentFrame) {
 
 	// update skinned mesh
 	if (_skinnedMesh) {
-		BaseArray<Math::Matrix4> finalBoneMatrices;
-		finalBoneMatrices.resize(_boneMatrices.size());
-
-		for (uint i = 0; i < skinWeightsList.size(); ++i) {
-			finalBoneMatrices[i] = *_boneMatrices[i] * skinWeightsList[i]._offsetMatrix;
+		// the skinning data is set up by findBones()
+		if (_skinPalette) {
+			updateSkinPalette();
+			skinVertices();
 		}
-
-		// the new vertex coordinates are the weighted sum of the product
-		// of the combined bone transformation matrices and the static pose coordinates
-		// to be able too add the weighted summands together, we reset everything to zero first
+	} else { // update static
 		for (uint32 i = 0; i < _vertexCount; ++i) {
-			for (int j = 0; j < 3; ++j) {
-				_vertexData[i * kVertexComponentCount + kPositionOffset + j] = 0.0f;
-			}
-		}
+			Math::Vector3d pos(_vertexPositionData + 3 * i);
+			parentFrame->getCombinedMatrix()->transform(&pos, true);
 
-		for (uint boneIndex = 0; boneIndex < skinWeightsList.size(); ++boneIndex) {
-			// to every vertex which is affected by the bone, we add the product
-			// of the bone transformation with the coordinates of the static pose,
-			// weighted by the weight for the particular vertex
-			// repeating this procedure for all bones gives the new pose
-			for (uint i = 0; i < skinWeightsList[boneIndex]._vertexIndices.size(); ++i) {
-				uint32 vertexIndex = skinWeightsList[boneIndex]._vertexIndices[i];
-				Math::Vector3d pos;
-				pos.setData(_vertexPositionData + vertexIndex * 3);
-				finalBoneMatrices[boneIndex].transform(&pos, true);
-				pos *= skinWeightsList[boneIndex]._vertexWeights[i];
-
-				for (uint j = 0; j < 3; ++j) {
-					_vertexData[vertexIndex * kVertexComponentCount + kPositionOffset + j] += pos.getData()[j];
-				}
+			for (uint j = 0; j < 3; ++j) {
+				_vertexData[i * kVertexComponentCount + kPositionOffset + j] = pos.getData()[j];
 			}
 		}
+	}
+
+	updateBoundingBox();
 
-		// now we have to update the vertex normals as well, so prepare the bone transformations
-		for (uint i = 0; i < skinWeightsList.size(); ++i) {
-			finalBoneMatrices[i].transpose();
-			finalBoneMatrices[i].inverse();
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MeshX::updateSkinPalette() {
+	// the palette is kept between updates, so nothing is allocated per frame
+	for (uint boneIndex = 0; boneIndex < skinWeightsList.size(); ++boneIndex) {
+		if (!_boneMatrices[boneIndex]) {
+			continue;
 		}
 
-		// reset so we can form the weighted sums
-		for (uint32 i = 0; i < _vertexCount; ++i) {
-			for (int j = 0; j < 3; ++j) {
-				_vertexData[i * kVertexComponentCount + kNormalOffset + j] = 0.0f;
+		Math::Matrix4 m = *_boneMatrices[boneIndex] * skinWeightsList[boneIndex]._offsetMatrix;
+		float *position = _skinPalette + boneIndex * kSkinPaletteStride;
+		float *normal = position + 16;
+
+		for (int c = 0; c < 4; ++c) {
+			for (int r = 0; r < 3; ++r) {
+				position[c * 4 + r] = m(r, c);
 			}
+			position[c * 4 + 3] = c == 3 ? 1.0f : 0.0f;
 		}
 
-		for (uint boneIndex = 0; boneIndex < skinWeightsList.size(); ++boneIndex) {
-			for (uint i = 0; i < skinWeightsList[boneIndex]._vertexIndices.size(); ++i) {
-				uint32 vertexIndex = skinWeightsList[boneIndex]._vertexIndices[i];
-				Math::Vector3d pos;
-				pos.setData(_vertexNormalData + vertexIndex * 3);
-				finalBoneMatrices[boneIndex].transform(&pos, true);
-				pos *= skinWeightsList[boneIndex]._vertexWeights[i];
-
-				for (uint j = 0; j < 3; ++j) {
-					_vertexData[vertexIndex * kVertexComponentCount + kNormalOffset + j] += pos.getData()[j];
-				}
+		// normals are transformed by the inverse transpose of the upper
+		// 3x3 part, which is its cofactor matrix divided by its determinant
+		float cof[3][3];
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) {
+				int r1 = (r + 1) % 3, r2 = (r + 2) % 3;
+				int c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+				cof[r][c] = m(r1, c1) * m(r2, c2) - m(r1, c2) * m(r2, c1);
 			}
 		}
 
-//		updateNormals();
-	} else { // update static
-		for (uint32 i = 0; i < _vertexCount; ++i) {
-			Math::Vector3d pos(_vertexPositionData + 3 * i);
-			parentFrame->getCombinedMatrix()->transform(&pos, true);
+		float det = m(0, 0) * cof[0][0] + m(0, 1) * cof[0][1] + m(0, 2) * cof[0][2];
+		float invDet = det != 0.0f ? 1.0f / det : 0.0f;
 
-			for (uint j = 0; j < 3; ++j) {
-				_vertexData[i * kVertexComponentCount + kPositionOffset + j] = pos.getData()[j];
+		for (int c = 0; c < 3; ++c) {
+			for (int r = 0; r < 3; ++r) {
+				normal[c * 4 + r] = cof[r][c] * invDet;
 			}
+			normal[c * 4 + 3] = 0.0f;
 		}
 	}
+}
 
-	updateBoundingBox();
+//////////////////////////////////////////////////////////////////////////
+void MeshX::skinVertices() {
+	// the new vertex coordinates are the weighted sum of the product
+	// of the combined bone transformation matrices and the static pose coordinates,
+	// going through the vertices in order and writing each of them once
+	for (uint32 i = 0; i < _vertexCount; ++i) {
+		const uint16 *bones = _skinBoneIndices + i * kMaxBoneInfluences;
+		const float *weights = _skinBoneWeights + i * kMaxBoneInfluences;
+		const float *pos = _vertexPositionData + i * 3;
+		const float *norm = _vertexNormalData + i * 3;
+		float *dest = _vertexData + i * kVertexComponentCount;
+
+#ifdef MATH_USE_SSE2
+		const __m128 px = _mm_set1_ps(pos[0]), py = _mm_set1_ps(pos[1]), pz = _mm_set1_ps(pos[2]);
+		const __m128 nx = _mm_set1_ps(norm[0]), ny = _mm_set1_ps(norm[1]), nz = _mm_set1_ps(norm[2]);
+		__m128 posSum = _mm_setzero_ps();
+		__m128 normSum = _mm_setzero_ps();
+
+		for (int j = 0; j < kMaxBoneInfluences; ++j) {
+			const float *m = _skinPalette + bones[j] * kSkinPaletteStride;
+			const __m128 w = _mm_set1_ps(weights[j]);
+
+			__m128 p = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m), px), _mm_mul_ps(_mm_loadu_ps(m + 4), py));
+			p = _mm_add_ps(p, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), pz), _mm_loadu_ps(m + 12)));
+			posSum = _mm_add_ps(posSum, _mm_mul_ps(p, w));
+
+			__m128 n = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 16), nx), _mm_mul_ps(_mm_loadu_ps(m + 20), ny));
+			n = _mm_add_ps(n, _mm_mul_ps(_mm_loadu_ps(m + 24), nz));
+			normSum = _mm_add_ps(normSum, _mm_mul_ps(n, w));
+		}
 
-	return true;
+		float result[8];
+		_mm_storeu_ps(result, posSum);
+		_mm_storeu_ps(result + 4, normSum);
+		for (int j = 0; j < 3; ++j) {
+			dest[kPositionOffset + j] = result[j];
+			dest[kNormalOffset + j] = result[4 + j];
+		}
+#else
+		float posSum[3] = { 0.0f, 0.0f, 0.0f };
+		float normSum[3] = { 0.0f, 0.0f, 0.0f };
+
+		for (int j = 0; j < kMaxBoneInfluences; ++j) {
+			const float *m = _skinPalette + bones[j] * kSkinPaletteStride;
+			const float w = weights[j];
+
+			for (int r = 0; r < 3; ++r) {
+				posSum[r] += (m[r] * pos[0] + m[4 + r] * pos[1] + m[8 + r] * pos[2] + m[12 + r]) * w;
+				normSum[r] += (m[16 + r] * norm[0] + m[20 + r] * norm[1] + m[24 + r] * norm[2]) * w;
+			}
+		}
+
+		for (int j = 0; j < 3; ++j) {
+			dest[kPositionOffset + j] = posSum[j];
+			dest[kNormalOffset + j] = normSum[j];
+		}
+#endif
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -58,6 +58,8 @@ public:
 	virtual ~MeshX();
 
 	virtual bool loadFromX(const Common::String &filename, XFileLexer &lexer, Common::Array<MaterialReference> &materialReferences);
+	virtual bool loadCooked(Common::SeekableReadStream &stream, const Common::String &filename, Common::Array<MaterialReference> &materialReferences);
+	void saveCooked(Common::WriteStream &stream, const Common::String &filename, const Common::Array<MaterialReference> &materialReferences);
 	bool findBones(FrameNode *rootFrame);
 	virtual bool update(FrameNode *parentFrame);
 	virtual bool render(ModelX *model) = 0;
@@ -83,6 +85,12 @@ protected:
 	// anything which does not fit into 16 bits would we fine
 	static const uint32 kNullIndex = 0xFFFFFFFF;
 
+	// skinning works on up to this many bones per vertex
+	static const int kMaxBoneInfluences = 4;
+	// the palette holds the position matrix of each bone, followed by its
+	// normal matrix, column by column with four floats each
+	static const int kSkinPaletteStride = 28;
+
 	bool parsePositionCoords(XFileLexer &lexer);
 	bool parseFaces(XFileLexer &lexer, int faceCount, Common::Array<int> &indexCountPerFace);
 	bool parseTextureCoords(XFileLexer &lexer);
@@ -92,6 +100,8 @@ protected:
 	bool parseVertexDeclaration(XFileLexer &lexer);
 
 	void updateBoundingBox();
+	void updateSkinPalette();
+	void skinVertices();
 
 	bool generateAdjacency();
 	bool adjacentEdge(uint16 index1, uint16 index2, uint16 index3, uint16 index4);
@@ -105,6 +115,12 @@ protected:
 	BaseArray<Math::Matrix4 *> _boneMatrices;
 	BaseArray<SkinWeights> skinWeightsList;
 
+	// the skin weights in vertex order, kMaxBoneInfluences per vertex,
+	// with unused influences having zero weight, built by findBones()
+	uint16 *_skinBoneIndices;
+	float *_skinBoneWeights;
+	float *_skinPalette;
+
 	Common::Array<uint32> _adjacency;
 
 	BaseArray<Material *> _materials;
@@ -35,6 +35,7 @@
 #include "engines/wintermute/base/gfx/x/active_animation.h"
 #include "engines/wintermute/base/gfx/x/animation_channel.h"
 #include "engines/wintermute/base/gfx/x/animation_set.h"
+#include "engines/wintermute/base/gfx/x/cooked_x.h"
 #include "engines/wintermute/base/gfx/x/frame_node.h"
 #include "engines/wintermute/base/gfx/x/material.h"
 #include "engines/wintermute/base/gfx/x/modelx.h"
@@ -222,13 +223,29 @@ bool ModelX::loadFromFile(const Common::String &filename, ModelX *parentModel) {
 
 	uint32 fileSize = 0;
 	byte *buffer = BaseFileManager::getEngineInstance()->getEngineInstance()->readWholeFile(filename, &fileSize);
-	XFileLexer lexer = createXFileLexer(buffer, fileSize);
+	if (!buffer) {
+		return false;
+	}
 
 	bool res = true;
 
 	_parentModel = parentModel;
 	_rootFrame = new FrameNode(_gameRef);
-	res = _rootFrame->loadFromXAsRoot(filename, lexer, this, _materialReferences);
+
+	Common::String key;
+	if (CookedX::isEnabled()) {
+		key = CookedX::getKey(buffer, fileSize);
+	}
+
+	if (key.empty() || !loadCooked(filename, key)) {
+		XFileLexer lexer = createXFileLexer(buffer, fileSize);
+		res = _rootFrame->loadFromXAsRoot(filename, lexer, this, _materialReferences);
+
+		if (res && !key.empty()) {
+			saveCooked(filename, key);
+		}
+	}
+
 	setFilename(filename.c_str());
 
 	for (int i = 0; i < X_NUM_ANIMATION_CHANNELS; ++i) {
@@ -247,10 +264,28 @@ bool ModelX::loadFromFile(const Common::String &filename, ModelX *parentModel) {
 bool ModelX::mergeFromFile(const Common::String &filename) {
 	uint32 fileSize = 0;
 	byte *buffer = BaseFileManager::getEngineInstance()->getEngineInstance()->readWholeFile(filename, &fileSize);
-	XFileLexer lexer = createXFileLexer(buffer, fileSize);
+	if (!buffer) {
+		return false;
+	}
+
+	Common::String key;
+	if (CookedX::isEnabled()) {
+		key = CookedX::getKey(buffer, fileSize);
+	}
+
+	if (key.empty() || !loadCookedAnimations(filename, key)) {
+		uint32 firstSet = _animationSets.size();
+
+		XFileLexer lexer = createXFileLexer(buffer, fileSize);
+		lexer.advanceToNextToken();
+		bool res = parseFrameDuringMerge(lexer, filename);
 
-	lexer.advanceToNextToken();
-	parseFrameDuringMerge(lexer, filename);
+		// A cooked file would make the sets which failed to load go missing
+		// for good, so only write it when they all loaded
+		if (res && !key.empty()) {
+			saveCookedAnimations(filename, key, firstSet);
+		}
+	}
 
 	findBones(false, nullptr);
 
@@ -335,20 +370,145 @@ bool ModelX::findBones(bool animOnly, ModelX *parentModel) {
 	return true;
 }
 
-void ModelX::parseFrameDuringMerge(XFileLexer &lexer, const Common::String &filename) {
+bool ModelX::parseFrameDuringMerge(XFileLexer &lexer, const Common::String &filename) {
+	bool res = true;
+
 	while (!lexer.eof()) {
 		if (lexer.tokenIsIdentifier("Frame")) {
 			lexer.advanceToNextToken();
-			parseFrameDuringMerge(lexer, filename);
+			res = parseFrameDuringMerge(lexer, filename) && res;
 		} else if (lexer.tokenIsIdentifier("AnimationSet")) {
 			lexer.advanceToNextToken();
-			loadAnimationSet(lexer, filename);
+			res = loadAnimationSet(lexer, filename) && res;
 		} else if (lexer.tokenIsOfType(IDENTIFIER)) {
 			lexer.skipObject();
 		} else {
 			lexer.advanceToNextToken(); // we ignore anything else here
 		}
 	}
+
+	return res;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool ModelX::loadCooked(const Common::String &filename, const Common::String &key) {
+	Common::SeekableReadStream *stream = CookedX::open(key, CookedX::kModel);
+	if (!stream) {
+		return false;
+	}
+
+	bool res = true;
+
+	_ticksPerSecond = stream->readUint32LE();
+
+	// the materials come first, the meshes refer to them by index
+	uint32 count;
+	res = CookedX::readCount(*stream, count, 4);
+	for (uint32 i = 0; res && i < count; i++) {
+		MaterialReference materialReference;
+		materialReference._name = CookedX::readString(*stream);
+		materialReference._material = new Material(_gameRef);
+		_materialReferences.push_back(materialReference);
+
+		res = materialReference._material->loadCooked(*stream, filename);
+	}
+
+	res = res && _rootFrame->loadCooked(*stream, filename, _materialReferences);
+
+	res = res && CookedX::readCount(*stream, count, 1);
+	for (uint32 i = 0; res && i < count; i++) {
+		AnimationSet *animSet = new AnimationSet(_gameRef, this);
+		_animationSets.add(animSet);
+
+		res = animSet->loadCooked(*stream, filename);
+	}
+
+	delete stream;
+
+	if (!res) {
+		warning("ModelX::loadCooked damaged cooked file for '%s', parsing it again", filename.c_str());
+
+		ModelX *parentModel = _parentModel;
+		cleanup(false);
+		_parentModel = parentModel;
+		_rootFrame = new FrameNode(_gameRef);
+	}
+
+	return res;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ModelX::saveCooked(const Common::String &filename, const Common::String &key) {
+	Common::MemoryWriteStreamDynamic stream(DisposeAfterUse::YES);
+
+	stream.writeUint32LE(_ticksPerSecond);
+
+	stream.writeUint32LE(_materialReferences.size());
+	for (uint32 i = 0; i < _materialReferences.size(); i++) {
+		CookedX::writeString(stream, _materialReferences[i]._name);
+		_materialReferences[i]._material->saveCooked(stream, filename);
+	}
+
+	_rootFrame->saveCooked(stream, filename, _materialReferences);
+
+	stream.writeUint32LE(_animationSets.size());
+	for (uint32 i = 0; i < _animationSets.size(); i++) {
+		_animationSets[i]->saveCooked(stream, filename);
+	}
+
+	if (!CookedX::save(key, CookedX::kModel, stream)) {
+		debug(2, "ModelX::saveCooked could not write cooked file for '%s'", filename.c_str());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool ModelX::loadCookedAnimations(const Common::String &filename, const Common::String &key) {
+	Common::SeekableReadStream *stream = CookedX::open(key, CookedX::kAnimations);
+	if (!stream) {
+		return false;
+	}
+
+	BaseArray<AnimationSet *> animationSets;
+
+	uint32 count;
+	bool res = CookedX::readCount(*stream, count, 1);
+	for (uint32 i = 0; res && i < count; i++) {
+		AnimationSet *animSet = new AnimationSet(_gameRef, this);
+		animationSets.add(animSet);
+
+		res = animSet->loadCooked(*stream, filename);
+	}
+
+	delete stream;
+
+	// only add them when all could be read, otherwise parse the file again
+	for (uint32 i = 0; i < animationSets.size(); i++) {
+		if (res) {
+			_animationSets.add(animationSets[i]);
+		} else {
+			delete animationSets[i];
+		}
+	}
+
+	if (!res) {
+		warning("ModelX::loadCookedAnimations damaged cooked file for '%s', parsing it again", filename.c_str());
+	}
+
+	return res;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ModelX::saveCookedAnimations(const Common::String &filename, const Common::String &key, uint32 firstSet) {
+	Common::MemoryWriteStreamDynamic stream(DisposeAfterUse::YES);
+
+	stream.writeUint32LE(_animationSets.size() - firstSet);
+	for (uint32 i = firstSet; i < _animationSets.size(); i++) {
+		_animationSets[i]->saveCooked(stream, filename);
+	}
+
+	if (!CookedX::save(key, CookedX::kAnimations, stream)) {
+		debug(2, "ModelX::saveCookedAnimations could not write cooked file for '%s'", filename.c_str());
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
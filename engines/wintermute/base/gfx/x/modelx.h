@@ -190,7 +190,12 @@ private:
 	void cleanup(bool complete = true);
 	bool findBones(bool animOnly = false, ModelX *parentModel = nullptr);
 
-	void parseFrameDuringMerge(XFileLexer &lexer, const Common::String &filename);
+	bool parseFrameDuringMerge(XFileLexer &lexer, const Common::String &filename);
+
+	bool loadCooked(const Common::String &filename, const Common::String &key);
+	void saveCooked(const Common::String &filename, const Common::String &key);
+	bool loadCookedAnimations(const Common::String &filename, const Common::String &key);
+	void saveCookedAnimations(const Common::String &filename, const Common::String &key, uint32 firstSet);
 
 	void updateBoundingRect();
 	void static inline updateRect(Rect32 *rc, int x, int y);
@@ -94,6 +94,8 @@ bool SaveLoad::saveGame(int slot, const char *desc, bool quickSave, BaseGame *ga
 	bool ret;
 
 	BasePersistenceManager *pm = new BasePersistenceManager();
+	// Quick saves happen often and mostly change little, so only store the changes
+	pm->setIncremental(quickSave);
 	if (DID_SUCCEED(ret = pm->initSave(desc))) {
 		gameRef->_renderer->initSaveLoad(true, quickSave); // TODO: The original code inited the indicator before the conditionals
 		if (DID_SUCCEED(ret = SystemClassRegistry::getInstance()->saveTable(gameRef,  pm, quickSave))) {
@@ -201,7 +203,7 @@ bool SaveLoad::isSaveSlotUsed(int slot) {
 bool SaveLoad::emptySaveSlot(int slot) {
 	Common::String filename = getSaveSlotFilename(slot);
 	BasePersistenceManager *pm = new BasePersistenceManager();
-	((WintermuteEngine *)g_engine)->getSaveFileMan()->removeSavefile(pm->getFilenameForSlot(slot));
+	pm->deleteSaveSlot(slot);
 	delete pm;
 	return true;
 }
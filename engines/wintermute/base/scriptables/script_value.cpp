@@ -54,6 +54,7 @@ ScValue::ScValue(BaseGame *inGame) : BaseClass(inGame) {
 	_valRef = nullptr;
 	_persistent = false;
 	_isConstVar = false;
+	markDirty();
 }
 
 
@@ -69,6 +70,7 @@ ScValue::ScValue(BaseGame *inGame, bool val) : BaseClass(inGame) {
 	_valRef = nullptr;
 	_persistent = false;
 	_isConstVar = false;
+	markDirty();
 }
 
 
@@ -84,6 +86,7 @@ ScValue::ScValue(BaseGame *inGame, int32 val) : BaseClass(inGame) {
 	_valRef = nullptr;
 	_persistent = false;
 	_isConstVar = false;
+	markDirty();
 }
 
 
@@ -99,6 +102,7 @@ ScValue::ScValue(BaseGame *inGame, double val) : BaseClass(inGame) {
 	_valRef = nullptr;
 	_persistent = false;
 	_isConstVar = false;
+	markDirty();
 }
 
 
@@ -115,6 +119,7 @@ ScValue::ScValue(BaseGame *inGame, const char *val) : BaseClass(inGame) {
 	_valRef = nullptr;
 	_persistent = false;
 	_isConstVar = false;
+	markDirty();
 }
 
 
@@ -147,6 +152,7 @@ void ScValue::cleanup(bool ignoreNatives) {
 	_valRef = nullptr;
 	_persistent = false;
 	_isConstVar = false;
+	markDirty();
 }
 
 
@@ -157,6 +163,12 @@ ScValue::~ScValue() {
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+void ScValue::markDirty() {
+	_dirtyGeneration = BasePersistenceManager::newDirtyGeneration();
+}
+
+
 //////////////////////////////////////////////////////////////////////////
 ScValue *ScValue::getProp(const char *name) {
 	if (_type == VAL_VARIABLE_REF) {
@@ -193,6 +205,7 @@ ScValue *ScValue::getProp(const char *name) {
 
 //////////////////////////////////////////////////////////////////////////
 bool ScValue::deleteProp(const char *name) {
+	markDirty();
 	if (_type == VAL_VARIABLE_REF) {
 		return _valRef->deleteProp(name);
 	}
@@ -210,6 +223,7 @@ bool ScValue::deleteProp(const char *name) {
 
 //////////////////////////////////////////////////////////////////////////
 bool ScValue::setProp(const char *name, ScValue *val, bool copyWhole, bool setAsConst) {
+	markDirty();
 	if (_type == VAL_VARIABLE_REF) {
 		return _valRef->setProp(name, val);
 	}
@@ -272,6 +286,7 @@ bool ScValue::propExists(const char *name) {
 
 //////////////////////////////////////////////////////////////////////////
 void ScValue::deleteProps() {
+	markDirty();
 	_valIter = _valObject.begin();
 	while (_valIter != _valObject.end()) {
 		delete(ScValue *)_valIter->_value;
@@ -384,6 +399,7 @@ void ScValue::setBool(bool val) {
 		return;
 	}
 
+	markDirty();
 	_valBool = val;
 	_type = VAL_BOOL;
 }
@@ -401,6 +417,7 @@ void ScValue::setInt(int val) {
 		return;
 	}
 
+	markDirty();
 	_valInt = val;
 	_type = VAL_INT;
 }
@@ -418,6 +435,7 @@ void ScValue::setFloat(double val) {
 		return;
 	}
 
+	markDirty();
 	_valFloat = val;
 	_type = VAL_FLOAT;
 }
@@ -449,6 +467,7 @@ void ScValue::setString(const Common::String &val) {
 
 //////////////////////////////////////////////////////////////////////////
 void ScValue::setStringVal(const char *val) {
+	markDirty();
 	if (_valString) {
 		delete[] _valString;
 		_valString = nullptr;
@@ -479,6 +498,7 @@ void ScValue::setNULL() {
 			delete _valNative;
 		}
 	}
+	markDirty();
 	_valNative = nullptr;
 	deleteProps();
 
@@ -506,6 +526,7 @@ void ScValue::setNative(BaseScriptable *val, bool persistent) {
 			}
 		}
 
+		markDirty();
 		_type = VAL_NATIVE;
 		_persistent = persistent;
 
@@ -524,6 +545,7 @@ void ScValue::setObject() {
 		return;
 	}
 
+	markDirty();
 	deleteProps();
 	_type = VAL_OBJECT;
 }
@@ -531,6 +553,7 @@ void ScValue::setObject() {
 
 //////////////////////////////////////////////////////////////////////////
 void ScValue::setReference(ScValue *val) {
+	markDirty();
 	_valRef = val;
 	_type = VAL_VARIABLE_REF;
 }
@@ -789,6 +812,14 @@ void ScValue::setValue(ScValue *val) {
 
 //////////////////////////////////////////////////////////////////////////
 bool ScValue::persist(BasePersistenceManager *persistMgr) {
+	if (persistMgr->getIsSaving()) {
+		if (persistMgr->reuseInstanceData(_dirtyGeneration)) {
+			return STATUS_OK;
+		}
+	} else {
+		markDirty();
+	}
+
 	persistMgr->transferPtr(TMEMBER_PTR(_gameRef));
 
 	persistMgr->transferBool(TMEMBER(_persistent));
@@ -90,6 +90,9 @@ private:
 	int32 _valInt;
 	double _valFloat;
 	char *_valString;
+	/** Changes whenever the persisted state does, see BasePersistenceManager::reuseInstanceData() */
+	uint64 _dirtyGeneration;
+	void markDirty();
 public:
 	TValType _type;
 	ScValue(BaseGame *inGame);
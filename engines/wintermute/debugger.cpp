@@ -21,8 +21,14 @@
  */
 
 #include "engines/wintermute/debugger.h"
+#ifdef ENABLE_WME3D
+#include "engines/wintermute/ad/ad_game.h"
+#include "engines/wintermute/ad/ad_scene.h"
+#include "engines/wintermute/ad/ad_scene_geometry.h"
+#endif
 #include "engines/wintermute/base/base_engine.h"
 #include "engines/wintermute/base/base_file_manager.h"
+#include "engines/wintermute/base/base_persistence_manager.h"
 #include "engines/wintermute/base/scriptables/script_value.h"
 #include "engines/wintermute/debugger/debugger_controller.h"
 #include "engines/wintermute/wintermute.h"
@@ -36,6 +42,10 @@ Console::Console(WintermuteEngine *vm) : GUI::Debugger(), _engineRef(vm) {
 	registerCmd("dump_file", WRAP_METHOD(Console, Cmd_DumpFile));
 	registerCmd("show_fps", WRAP_METHOD(Console, Cmd_ShowFps));
 	registerCmd("dump_file", WRAP_METHOD(Console, Cmd_DumpFile));
+	registerCmd("compact_save", WRAP_METHOD(Console, Cmd_CompactSave));
+#ifdef ENABLE_WME3D
+	registerCmd("geometry_bench", WRAP_METHOD(Console, Cmd_GeometryBenchmark));
+#endif
 	registerCmd("help", WRAP_METHOD(Console, Cmd_Help));
 	// Actual (script) debugger commands
 	registerCmd(STEP_CMD, WRAP_METHOD(Console, Cmd_Step));
@@ -341,6 +351,87 @@ bool Console::Cmd_DumpFile(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::Cmd_CompactSave(int argc, const char **argv) {
+	if (argc != 2) {
+		debugPrintf("Usage: %s <save slot>\n", argv[0]);
+		return true;
+	}
+
+	BasePersistenceManager *pm = new BasePersistenceManager();
+	Common::String filename = pm->getFilenameForSlot(atoi(argv[1]));
+	if (DID_SUCCEED(pm->compactSave(filename))) {
+		debugPrintf("Save file '%s' no longer depends on a snapshot\n", filename.c_str());
+	} else {
+		debugPrintf("Could not compact save file '%s'\n", filename.c_str());
+	}
+	delete pm;
+	return true;
+}
+
+#ifdef ENABLE_WME3D
+bool Console::Cmd_GeometryBenchmark(int argc, const char **argv) {
+	if (argc > 2) {
+		debugPrintf("Usage: %s [record | rounds]\n", argv[0]);
+		debugPrintf("Records the actor positions of the current scene, or replays them\n");
+		return true;
+	}
+
+	AdGame *adGame = (AdGame *)_engineRef->_game;
+	if (!adGame || !adGame->_scene || !adGame->_scene->_sceneGeometry) {
+		debugPrintf("The current scene has no 3D geometry\n");
+		return true;
+	}
+
+	AdSceneGeometry *geometry = adGame->_scene->_sceneGeometry;
+	if (argc == 2 && !strcmp(argv[1], "record")) {
+		geometry->setRecordPositions(true);
+		debugPrintf("Recording actor positions, run %s again to replay them\n", argv[0]);
+		return true;
+	}
+
+	// Stop recording, so the replay does not record its own queries
+	geometry->setRecordPositions(false);
+	Common::Array<Math::Vector3d> positions;
+	geometry->getRecordedPositions(positions);
+	if (positions.size() < 2) {
+		debugPrintf("No actor positions recorded, run \"%s record\" first\n", argv[0]);
+		return true;
+	}
+
+	// Replay the height and walk queries of the recorded positions, first
+	// scanning all triangles and then with the trees
+	const int rounds = argc == 2 ? MAX(atoi(argv[1]), 1) : 20;
+	uint32 ms[2];
+	Common::Array<float> heights[2];
+	Common::Array<bool> paths[2];
+	for (int mode = 0; mode < 2; mode++) {
+		geometry->_bruteForceQueries = mode == 0;
+		uint32 start = g_system->getMillis();
+		for (int round = 0; round < rounds; round++) {
+			heights[mode].clear();
+			paths[mode].clear();
+			for (uint i = 1; i < positions.size(); i++) {
+				heights[mode].push_back(geometry->getHeightAt(positions[i], geometry->_waypointHeight));
+				paths[mode].push_back(geometry->directPathExists(&positions[i - 1], &positions[i]));
+			}
+		}
+		ms[mode] = g_system->getMillis() - start;
+	}
+	geometry->_bruteForceQueries = false;
+
+	uint mismatches = 0;
+	for (uint i = 0; i < heights[0].size(); i++) {
+		if (heights[0][i] != heights[1][i] || paths[0][i] != paths[1][i]) {
+			mismatches++;
+		}
+	}
+
+	debugPrintf("%d rounds of %d positions: brute force %d ms, BVH %d ms, %d mismatches\n",
+	            rounds, positions.size() - 1, ms[0], ms[1], mismatches);
+	return true;
+}
+#endif
+
 
 bool Console::Cmd_SourcePath(int argc, const char **argv) {
 	if (argc != 2) {
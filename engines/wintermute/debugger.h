@@ -70,6 +70,10 @@ public:
 	bool Cmd_Help(int argc, const char **argv);
 	bool Cmd_ShowFps(int argc, const char **argv);
 	bool Cmd_DumpFile(int argc, const char **argv);
+	bool Cmd_CompactSave(int argc, const char **argv);
+#ifdef ENABLE_WME3D
+	bool Cmd_GeometryBenchmark(int argc, const char **argv);
+#endif
 
 #if EXTENDED_DEBUGGER_ENABLED
 	/**
@@ -10,6 +10,7 @@ MODULE_OBJS := \
 	ad/ad_generic.o \
 	ad/ad_geom_ext.o \
 	ad/ad_geom_ext_node.o \
+	ad/ad_geometry_bvh.o \
 	ad/ad_inventory.o \
 	ad/ad_inventory_box.o \
 	ad/ad_item.o \
@@ -87,6 +88,7 @@ MODULE_OBJS := \
 	base/gfx/x/animation.o \
 	base/gfx/x/animation_channel.o \
 	base/gfx/x/animation_set.o \
+	base/gfx/x/cooked_x.o \
 	base/gfx/x/frame_node.o \
 	base/gfx/x/material.o \
 	base/gfx/x/meshx.o \
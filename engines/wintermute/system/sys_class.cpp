@@ -186,12 +186,16 @@ void SystemClass::saveInstances(BaseGame *Game, BasePersistenceManager *persistM
 	Instances::iterator it;
 	for (it = _instances.begin(); it != _instances.end(); ++it) {
 		// write instace header
+		persistMgr->beginInstance(_iD, (it->_value)->getID());
 		persistMgr->putString("<INSTANCE_HEAD>");
 		persistMgr->putDWORD(_iD);
 		persistMgr->putDWORD((it->_value)->getID());
 		persistMgr->putString("</INSTANCE_HEAD>");
+		persistMgr->beginInstanceData();
 		_load((it->_value)->getInstance(), persistMgr);
+		persistMgr->endInstanceData();
 		persistMgr->putString("</INSTANCE>");
+		persistMgr->endInstance();
 	}
 }
 
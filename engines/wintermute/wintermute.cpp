@@ -64,6 +64,7 @@ WintermuteEngine::WintermuteEngine(OSystem *syst, const WMEGameDescription *desc
 	// in particular, do not load data from files; rather, if you
 	// need to do such things, do them from init().
 	ConfMan.registerDefault("show_fps","false");
+	ConfMan.registerDefault("cache_models", true);
 
 	// Do not initialize graphics here
 
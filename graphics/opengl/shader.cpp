@@ -122,6 +122,8 @@ struct SharedPtrProgramDeleter {
 };
 
 Shader* Shader::_previousShader = nullptr;
+Shader::Stats Shader::_frameStats;
+Shader::Stats Shader::_lastFrameStats;
 
 Shader::Shader(const Common::String &name, GLuint vertexShader, GLuint fragmentShader, const char **attributes)
 	: _name(name) {
@@ -144,6 +146,7 @@ Shader::Shader(const Common::String &name, GLuint vertexShader, GLuint fragmentS
 
 	_shaderNo = Common::SharedPtr<GLuint>(new GLuint(shaderProgram), SharedPtrProgramDeleter());
 	_uniforms = Common::SharedPtr<UniformsMap>(new UniformsMap());
+	_uniformValues = Common::SharedPtr<UniformsArray>(new UniformsArray());
 }
 
 Shader *Shader::fromStrings(const Common::String &name, const char *vertex, const char *fragment, const char **attributes) {
@@ -175,6 +178,7 @@ void Shader::use(bool forceReload) {
 
 	_previousShader = this;
 	previousNumAttributes = _attributes.size();
+	_frameStats._programChanges++;
 
 	glUseProgram(*_shaderNo);
 	for (uint32 i = 0; i < _attributes.size(); ++i) {
@@ -200,6 +204,23 @@ void Shader::use(bool forceReload) {
 	}
 }
 
+Shader::UniformHandle Shader::getUniformHandle(const char *uniform) const {
+	UniformsMap::iterator kv = _uniforms->find(uniform);
+	if (kv != _uniforms->end())
+		return UniformHandle(kv->_value);
+
+	Uniform u;
+	u._location = glGetUniformLocation(*_shaderNo, uniform);
+	_uniformValues->push_back(u);
+	_uniforms->setVal(uniform, _uniformValues->size() - 1);
+	return UniformHandle(_uniformValues->size() - 1);
+}
+
+void Shader::endFrame() {
+	_lastFrameStats = _frameStats;
+	_frameStats = Stats();
+}
+
 GLuint Shader::createBuffer(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage) {
 	GLuint vbo;
 	glGenBuffers(1, &vbo);
@@ -244,6 +265,24 @@ void Shader::disableVertexAttribute(const char *attrib, int size, const float *d
 		va._const[i] = data[i];
 }
 
+GLint Shader::updateUnboundUniform(Uniform &u) {
+	static bool warned = false;
+	if (!warned) {
+		warning("Shader::setUniform: Setting a uniform of %s while it is not in use", _name.c_str());
+		warned = true;
+	}
+
+	u._size = 0;
+	if (_previousShader) {
+		UniformsArray &values = *_previousShader->_uniformValues;
+		for (uint i = 0; i < values.size(); ++i)
+			values[i]._size = 0;
+	}
+
+	_frameStats._uniformUploads++;
+	return u._location;
+}
+
 void Shader::unbind() {
 	glUseProgram(0);
 	_previousShader = nullptr;
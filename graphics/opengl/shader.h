@@ -60,9 +60,47 @@ struct VertexAttrib {
 };
 
 class Shader {
-	typedef Common::HashMap<Common::String, GLint> UniformsMap;
+	struct Uniform {
+		Uniform() : _location(-1), _size(0) {}
+
+		GLint _location;
+		uint32 _size; ///< Size of the last value set, 0 while it is unknown
+		float _value[16];
+	};
+
+	typedef Common::HashMap<Common::String, uint> UniformsMap;
+	typedef Common::Array<Uniform> UniformsArray;
 
 public:
+	/**
+	 * A uniform looked up by getUniformHandle(). Setting a uniform through
+	 * its handle saves looking up its name every time. The handle is valid
+	 * for the shader it was returned by and all of its clones.
+	 */
+	class UniformHandle {
+	public:
+		UniformHandle() : _index(-1) {}
+		bool isValid() const { return _index >= 0; }
+
+	private:
+		explicit UniformHandle(int index) : _index(index) {}
+
+		int _index;
+
+		friend class Shader;
+	};
+
+	/**
+	 * Counters of the OpenGL state changes made through shaders.
+	 */
+	struct Stats {
+		Stats() : _programChanges(0), _uniformUploads(0), _redundantUniforms(0) {}
+
+		uint32 _programChanges;    ///< Programs made current, with their attributes
+		uint32 _uniformUploads;    ///< Uniforms uploaded to OpenGL
+		uint32 _redundantUniforms; ///< Uniforms not uploaded because they did not change
+	};
+
 	~Shader();
 	Shader* clone() {
 		return new Shader(*this);
@@ -70,61 +108,98 @@ public:
 
 	void use(bool forceReload = false);
 
-	void setUniform(const char *uniform, const Math::Matrix4 &m) {
-		GLint pos = getUniformLocation(uniform);
+	UniformHandle getUniformHandle(const char *uniform) const;
+
+	void setUniform(UniformHandle uniform, const Math::Matrix4 &m) {
+		GLint pos = updateUniform(uniform, m.getData(), 16);
 		if (pos != -1)
 			glUniformMatrix4fv(pos, 1, GL_FALSE, m.getData());
 	}
 
-	void setUniform(const char* uniform, const Math::Matrix3 &m) {
-		GLint pos = getUniformLocation(uniform);
+	void setUniform(UniformHandle uniform, const Math::Matrix3 &m) {
+		GLint pos = updateUniform(uniform, m.getData(), 9);
 		if (pos != -1)
 			glUniformMatrix3fv(pos, 1, GL_FALSE, m.getData());
 	}
 
-	void setUniform(const char *uniform, const Math::Vector4d &v) {
-		GLint pos = getUniformLocation(uniform);
+	void setUniform(UniformHandle uniform, const Math::Vector4d &v) {
+		GLint pos = updateUniform(uniform, v.getData(), 4);
 		if (pos != -1)
 			glUniform4fv(pos, 1, v.getData());
 	}
 
-	void setUniform(const char *uniform, const Math::Vector3d &v) {
-		GLint pos = getUniformLocation(uniform);
+	void setUniform(UniformHandle uniform, const Math::Vector3d &v) {
+		GLint pos = updateUniform(uniform, v.getData(), 3);
 		if (pos != -1)
 			glUniform3fv(pos, 1, v.getData());
 	}
 
-	void setUniform(const char *uniform, const Math::Vector2d &v) {
-		GLint pos = getUniformLocation(uniform);
+	void setUniform(UniformHandle uniform, const Math::Vector2d &v) {
+		GLint pos = updateUniform(uniform, v.getData(), 2);
 		if (pos != -1)
 			glUniform2fv(pos, 1, v.getData());
 	}
 
-	void setUniform(const char *uniform, unsigned int x) {
-		GLint pos = getUniformLocation(uniform);
+	void setUniform(UniformHandle uniform, unsigned int x) {
+		// Integers are kept bit for bit, as the float comparison is only
+		// used to find out whether the value changed
+		float value;
+		memcpy(&value, &x, sizeof(value));
+		GLint pos = updateUniform(uniform, &value, 1);
 		if (pos != -1)
 			glUniform1i(pos, x);
 	}
 
 	// Different name to avoid overload ambiguity
-	void setUniform1f(const char *uniform, float f) {
-		GLint pos = getUniformLocation(uniform);
+	void setUniform1f(UniformHandle uniform, float f) {
+		GLint pos = updateUniform(uniform, &f, 1);
 		if (pos != -1)
 			glUniform1f(pos, f);
 	}
 
+	void setUniform(const char *uniform, const Math::Matrix4 &m) {
+		setUniform(getUniformHandle(uniform), m);
+	}
+
+	void setUniform(const char* uniform, const Math::Matrix3 &m) {
+		setUniform(getUniformHandle(uniform), m);
+	}
+
+	void setUniform(const char *uniform, const Math::Vector4d &v) {
+		setUniform(getUniformHandle(uniform), v);
+	}
 
+	void setUniform(const char *uniform, const Math::Vector3d &v) {
+		setUniform(getUniformHandle(uniform), v);
+	}
+
+	void setUniform(const char *uniform, const Math::Vector2d &v) {
+		setUniform(getUniformHandle(uniform), v);
+	}
+
+	void setUniform(const char *uniform, unsigned int x) {
+		setUniform(getUniformHandle(uniform), x);
+	}
+
+	void setUniform1f(const char *uniform, float f) {
+		setUniform1f(getUniformHandle(uniform), f);
+	}
+
+	/**
+	 * Returns the location of a uniform, for setting it directly. Values set
+	 * that way are not known to setUniform(), so do not mix both for the
+	 * same uniform.
+	 */
 	GLint getUniformLocation(const char *uniform) const {
-		UniformsMap::iterator kv = _uniforms->find(uniform);
-		if (kv == _uniforms->end()) {
-			GLint ret = glGetUniformLocation(*_shaderNo, uniform);
-			_uniforms->setVal(uniform, ret);
-			return ret;
-		} else {
-			return kv->_value;
-		}
+		UniformHandle handle = getUniformHandle(uniform);
+		return (*_uniformValues)[handle._index]._location;
 	}
 
+	/** Returns the counters of the last frame finished with endFrame(). */
+	static const Stats &getFrameStats() { return _lastFrameStats; }
+	/** Finishes counting the state changes of a frame. */
+	static void endFrame();
+
 	void enableVertexAttribute(const char *attrib, GLuint vbo, GLint size, GLenum type, GLboolean normalized, GLsizei stride, uint32 offset);
 	void disableVertexAttribute(const char *attrib, int size, const float *data);
 	template <int r>
@@ -156,10 +231,48 @@ private:
 
 	Common::String _name;
 
+	/**
+	 * Remembers the new value of the uniform, and returns its location if
+	 * it has to be uploaded, or -1 if not.
+	 */
+	GLint updateUniform(UniformHandle uniform, const float *value, uint32 size) {
+		if (!uniform.isValid())
+			return -1;
+
+		Uniform &u = (*_uniformValues)[uniform._index];
+		if (u._location == -1)
+			return -1;
+
+		if (!_previousShader || _previousShader->_shaderNo != _shaderNo)
+			return updateUnboundUniform(u);
+
+		if (u._size == size && memcmp(u._value, value, size * sizeof(float)) == 0) {
+			_frameStats._redundantUniforms++;
+			return -1;
+		}
+
+		u._size = size;
+		memcpy(u._value, value, size * sizeof(float));
+		_frameStats._uniformUploads++;
+		return u._location;
+	}
+
+	/**
+	 * Setting a uniform of a program which is not in use uploads it to the
+	 * one in use instead, so neither of their cached values can be trusted.
+	 */
+	GLint updateUnboundUniform(Uniform &u);
+
 	Common::Array<VertexAttrib> _attributes;
+
+	// The uniform values belong to the OpenGL program, so they are shared
+	// with the clones like the program itself.
 	Common::SharedPtr<UniformsMap> _uniforms;
+	Common::SharedPtr<UniformsArray> _uniformValues;
 
 	static Shader *_previousShader;
+	static Stats _frameStats;
+	static Stats _lastFrameStats;
 };
 
 } // End of namespace OpenGL
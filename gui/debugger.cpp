@@ -26,6 +26,7 @@
 #include "common/debug.h"
 #include "common/debug-channels.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #ifndef DISABLE_MD5
 #include "common/md5.h"
@@ -77,6 +78,7 @@ Debugger::Debugger() {
 	registerCmd("debugflag_list",		WRAP_METHOD(Debugger, cmdDebugFlagsList));
 	registerCmd("debugflag_enable",	WRAP_METHOD(Debugger, cmdDebugFlagEnable));
 	registerCmd("debugflag_disable",	WRAP_METHOD(Debugger, cmdDebugFlagDisable));
+	registerCmd("timer_stats",		WRAP_METHOD(Debugger, cmdTimerStats));
 }
 
 Debugger::~Debugger() {
@@ -748,6 +750,24 @@ bool Debugger::cmdDebugFlagsList(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmdTimerStats(int argc, const char **argv) {
+	Common::Array<Common::TimerManager::TimerStats> stats;
+	g_system->getTimerManager()->getTimerStats(stats);
+
+	if (stats.empty()) {
+		debugPrintf("No timer statistics available\n");
+		return true;
+	}
+	debugPrintf("Timer callback            Interval    Calls   Avg ms   Max ms Max late\n");
+	debugPrintf("--------------------------------------------------------------------\n");
+	for (uint i = 0; i < stats.size(); ++i) {
+		const Common::TimerManager::TimerStats &s = stats[i];
+		debugPrintf("%-24s %7dus %8d %8.2f %8d %8d\n", s.id.c_str(), s.interval, s.calls,
+		            s.calls ? (double)s.totalTime / s.calls : 0.0, s.maxTime, s.maxDelay);
+	}
+	return true;
+}
+
 bool Debugger::cmdDebugFlagEnable(int argc, const char **argv) {
 	if (argc < 2) {
 		debugPrintf("debugflag_enable [<flag> | all]\n");
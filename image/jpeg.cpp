@@ -71,6 +71,12 @@ void JPEGDecoder::destroy() {
 	_surface.free();
 }
 
+Graphics::Surface *JPEGDecoder::releaseSurface() {
+	Graphics::Surface *surface = new Graphics::Surface(_surface);
+	_surface = Graphics::Surface();
+	return surface;
+}
+
 const Graphics::Surface *JPEGDecoder::decodeFrame(Common::SeekableReadStream &stream) {
 	if (!loadStream(stream))
 		return 0;
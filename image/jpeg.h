@@ -99,6 +99,13 @@ public:
 	 */
 	void setOutputPixelFormat(const Graphics::PixelFormat &format) { _requestedPixelFormat = format; }
 
+	/**
+	 * Hand the decoded surface over to the caller, avoiding a copy of the pixels.
+	 * The caller is responsible for freeing and deleting it. The decoder is left
+	 * without a surface.
+	 */
+	Graphics::Surface *releaseSurface();
+
 private:
 	Graphics::Surface _surface;
 	ColorSpace _colorSpace;
@@ -36,6 +36,7 @@
 #include "math/matrix4.h"
 #include "math/vector4d.h"
 #include "math/squarematrix.h"
+#include "math/simd.h"
 
 namespace Math {
 
@@ -49,16 +50,129 @@ Matrix<4, 4>::Matrix(const MatrixBase<4, 4> &m) :
 
 }
 
+Matrix<4, 4> Matrix<4, 4>::operator*(const Matrix<4, 4> &m2) const {
+	Matrix<4, 4> result;
+	const float *d1 = getData();
+	const float *d2 = m2.getData();
+	float *r = result.getData();
+
+	// Every row of the result is a combination of the rows of m2. The
+	// vector versions add the products in the same order as the plain one,
+	// so all of them give the same results.
+#if defined(MATH_USE_SSE2)
+	const __m128 row0 = _mm_loadu_ps(d2);
+	const __m128 row1 = _mm_loadu_ps(d2 + 4);
+	const __m128 row2 = _mm_loadu_ps(d2 + 8);
+	const __m128 row3 = _mm_loadu_ps(d2 + 12);
+	for (int i = 0; i < 16; i += 4) {
+		__m128 sum = _mm_mul_ps(_mm_set1_ps(d1[i + 0]), row0);
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(d1[i + 1]), row1));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(d1[i + 2]), row2));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(d1[i + 3]), row3));
+		_mm_storeu_ps(r + i, sum);
+	}
+#elif defined(MATH_USE_NEON)
+	const float32x4_t row0 = vld1q_f32(d2);
+	const float32x4_t row1 = vld1q_f32(d2 + 4);
+	const float32x4_t row2 = vld1q_f32(d2 + 8);
+	const float32x4_t row3 = vld1q_f32(d2 + 12);
+	for (int i = 0; i < 16; i += 4) {
+		float32x4_t sum = vmulq_n_f32(row0, d1[i + 0]);
+		sum = vaddq_f32(sum, vmulq_n_f32(row1, d1[i + 1]));
+		sum = vaddq_f32(sum, vmulq_n_f32(row2, d1[i + 2]));
+		sum = vaddq_f32(sum, vmulq_n_f32(row3, d1[i + 3]));
+		vst1q_f32(r + i, sum);
+	}
+#else
+	for (int i = 0; i < 16; i += 4) {
+		for (int j = 0; j < 4; ++j) {
+			r[i + j] = (d1[i + 0] * d2[j + 0])
+				+ (d1[i + 1] * d2[j + 4])
+				+ (d1[i + 2] * d2[j + 8])
+				+ (d1[i + 3] * d2[j + 12]);
+		}
+	}
+#endif
+
+	return result;
+}
+
 void Matrix<4, 4>::transform(Vector3d *v, bool trans) const {
-	Vector4d m;
-	m(0, 0) = v->x();
-	m(1, 0) = v->y();
-	m(2, 0) = v->z();
-	m(3, 0) = (trans ? 1.f : 0.f);
+	const float *m = getData();
+	const float x = v->x(), y = v->y(), z = v->z();
+
+	if (trans) {
+		v->set(m[0] * x + m[1] * y + m[2] * z + m[3],
+		       m[4] * x + m[5] * y + m[6] * z + m[7],
+		       m[8] * x + m[9] * y + m[10] * z + m[11]);
+	} else {
+		v->set(m[0] * x + m[1] * y + m[2] * z,
+		       m[4] * x + m[5] * y + m[6] * z,
+		       m[8] * x + m[9] * y + m[10] * z);
+	}
+}
+
+void Matrix<4, 4>::transform(const Vector3d *src, Vector3d *dst, int count, bool trans) const {
+	const float *m = getData();
 
-	m = *this * m;
+#if defined(MATH_USE_SSE2) || defined(MATH_USE_NEON)
+	// Work on the columns, so that each vector takes three multiplications
+	// and additions of whole columns
+	float columns[16];
+	for (int col = 0; col < 4; ++col) {
+		for (int row = 0; row < 3; ++row) {
+			columns[col * 4 + row] = m[row * 4 + col];
+		}
+		columns[col * 4 + 3] = 0.0f;
+	}
+	if (!trans) {
+		columns[12] = columns[13] = columns[14] = 0.0f;
+	}
 
-	v->set(m(0, 0), m(1, 0), m(2, 0));
+	float result[4];
+#if defined(MATH_USE_SSE2)
+	const __m128 col0 = _mm_loadu_ps(columns);
+	const __m128 col1 = _mm_loadu_ps(columns + 4);
+	const __m128 col2 = _mm_loadu_ps(columns + 8);
+	const __m128 col3 = _mm_loadu_ps(columns + 12);
+	for (int i = 0; i < count; ++i) {
+		const float *v = src[i].getData();
+		__m128 sum = _mm_mul_ps(col0, _mm_set1_ps(v[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(col1, _mm_set1_ps(v[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(col2, _mm_set1_ps(v[2])));
+		sum = _mm_add_ps(sum, col3);
+		_mm_storeu_ps(result, sum);
+		dst[i].set(result[0], result[1], result[2]);
+	}
+#else
+	const float32x4_t col0 = vld1q_f32(columns);
+	const float32x4_t col1 = vld1q_f32(columns + 4);
+	const float32x4_t col2 = vld1q_f32(columns + 8);
+	const float32x4_t col3 = vld1q_f32(columns + 12);
+	for (int i = 0; i < count; ++i) {
+		const float *v = src[i].getData();
+		float32x4_t sum = vmulq_n_f32(col0, v[0]);
+		sum = vaddq_f32(sum, vmulq_n_f32(col1, v[1]));
+		sum = vaddq_f32(sum, vmulq_n_f32(col2, v[2]));
+		sum = vaddq_f32(sum, col3);
+		vst1q_f32(result, sum);
+		dst[i].set(result[0], result[1], result[2]);
+	}
+#endif
+#else
+	for (int i = 0; i < count; ++i) {
+		const float x = src[i].x(), y = src[i].y(), z = src[i].z();
+		if (trans) {
+			dst[i].set(m[0] * x + m[1] * y + m[2] * z + m[3],
+			           m[4] * x + m[5] * y + m[6] * z + m[7],
+			           m[8] * x + m[9] * y + m[10] * z + m[11]);
+		} else {
+			dst[i].set(m[0] * x + m[1] * y + m[2] * z,
+			           m[4] * x + m[5] * y + m[6] * z,
+			           m[8] * x + m[9] * y + m[10] * z);
+		}
+	}
+#endif
 }
 
 Vector3d Matrix<4, 4>::getPosition() const {
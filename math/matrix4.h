@@ -40,6 +40,11 @@ public:
 	Matrix(const Angle &first, const Angle &second, const Angle &third, EulerOrder order) { buildFromEuler(first, second, third, order); }
 
 	void transform(Vector3d *v, bool translate) const;
+	/**
+	 * Transforms count vectors, like calling transform(Vector3d *, bool) on
+	 * each of them would. The source and destination may be the same array.
+	 */
+	void transform(const Vector3d *src, Vector3d *dst, int count, bool translate) const;
 	void inverseTranslate(Vector3d *v) const;
 	void inverseRotate(Vector3d *v) const;
 	
@@ -77,23 +82,7 @@ public:
 
 	void transpose();
 
-	inline Matrix<4, 4> operator*(const Matrix<4, 4> &m2) const {
-		Matrix<4, 4> result;
-		const float *d1 = getData();
-		const float *d2 = m2.getData();
-		float *r = result.getData();
-
-		for (int i = 0; i < 16; i += 4) {
-			for (int j = 0; j < 4; ++j) {
-				r[i + j] = (d1[i + 0] * d2[j + 0])
-					+ (d1[i + 1] * d2[j + 4])
-					+ (d1[i + 2] * d2[j + 8])
-					+ (d1[i + 3] * d2[j + 12]);
-			}
-		}
-
-		return result;
-	}
+	Matrix<4, 4> operator*(const Matrix<4, 4> &m2) const;
 
 	inline Vector4d transform(const Vector4d &v) const {
 		Vector4d result;
@@ -40,6 +40,7 @@
 
 #include "common/math.h"
 #include "math/quat.h"
+#include "math/simd.h"
 
 namespace Math {
 
@@ -100,7 +101,19 @@ Quaternion Quaternion::slerpQuat(const Quaternion& to, const float t) const {
 	}
 
 	// Apply the interpolation
-	dst = (*this * scale0) + (to * scale1);
+	const float *q0 = getData();
+	const float *q1 = to.getData();
+	float *r = dst.getData();
+#if defined(MATH_USE_SSE2)
+	_mm_storeu_ps(r, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(q0), _mm_set1_ps(scale0)),
+	                            _mm_mul_ps(_mm_loadu_ps(q1), _mm_set1_ps(scale1))));
+#elif defined(MATH_USE_NEON)
+	vst1q_f32(r, vaddq_f32(vmulq_n_f32(vld1q_f32(q0), scale0), vmulq_n_f32(vld1q_f32(q1), scale1)));
+#else
+	for (int i = 0; i < 4; ++i) {
+		r[i] = q0[i] * scale0 + q1[i] * scale1;
+	}
+#endif
 	return dst;
 }
 
@@ -108,8 +121,16 @@ Quaternion& Quaternion::normalize() {
 	const float scale = sqrtf(square(x()) + square(y()) + square(z()) + square(w()));
 
 	// Already normalized if the scale is 1.0
-	if (scale != 1.0f && scale != 0.0f)
+	if (scale != 1.0f && scale != 0.0f) {
+		float *q = getData();
+#if defined(MATH_USE_SSE2)
+		_mm_storeu_ps(q, _mm_div_ps(_mm_loadu_ps(q), _mm_set1_ps(scale)));
+#elif defined(MATH_USE_NEON) && defined(__aarch64__)
+		vst1q_f32(q, vdivq_f32(vld1q_f32(q), vdupq_n_f32(scale)));
+#else
 		set(x() / scale, y() / scale, z() / scale, w() / scale);
+#endif
+	}
 
 	return *this;
 }
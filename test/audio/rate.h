@@ -0,0 +1,247 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/raw.h"
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+#include "common/memstream.h"
+#include "common/endian.h"
+
+#include <math.h>
+#if __cplusplus >= 201103L
+#include <chrono>
+#endif
+
+// Creates a 16 bit stream of a sine wave, or of two in the stereo case
+static Audio::AudioStream *createRateTestStream(int rate, double freq, double freqRight, double amplitude, int samples, bool stereo) {
+	const int channels = stereo ? 2 : 1;
+	int16 *data = (int16 *)malloc(samples * channels * sizeof(int16));
+	for (int i = 0; i < samples; ++i) {
+		WRITE_LE_UINT16(&data[i * channels], (int16)floor(sin(2 * M_PI * freq * i / rate) * amplitude + 0.5));
+		if (stereo)
+			WRITE_LE_UINT16(&data[i * channels + 1], (int16)floor(sin(2 * M_PI * freqRight * i / rate) * amplitude + 0.5));
+	}
+
+	Common::SeekableReadStream *stream = new Common::MemoryReadStream((const byte *)data, samples * channels * sizeof(int16), DisposeAfterUse::YES);
+	return Audio::makeRawStream(stream, rate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (stereo ? Audio::FLAG_STEREO : 0));
+}
+
+// Runs a whole stream through a converter, returns the number of output sample pairs
+static int convertRateTestStream(Audio::AudioStream &input, Audio::RateConverter &converter, int16 *out, int outSamples) {
+	memset(out, 0, outSamples * 2 * sizeof(int16));
+	int total = 0;
+	while (total < outSamples) {
+		int len = converter.flow(input, out + total * 2, MIN(outSamples - total, 1000), Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		if (len <= 0)
+			break;
+		total += len;
+	}
+	return total;
+}
+
+// Amplitude of the given frequency in one channel of the output, relative
+// to full scale. Exact for whole numbers of periods.
+static double rateTestAmplitude(const int16 *out, int channel, int start, int count, int rate, double freq) {
+	double re = 0.0, im = 0.0;
+	for (int i = 0; i < count; ++i) {
+		const double x = out[(start + i) * 2 + channel] / 32768.0;
+		re += x * cos(2 * M_PI * freq * i / rate);
+		im += x * sin(2 * M_PI * freq * i / rate);
+	}
+	return 2 * sqrt(re * re + im * im) / count;
+}
+
+// Ratio of everything that is not the given frequency to that frequency
+static double rateTestDistortion(const int16 *out, int channel, int start, int count, int rate, double freq) {
+	double re = 0.0, im = 0.0;
+	for (int i = 0; i < count; ++i) {
+		const double x = out[(start + i) * 2 + channel];
+		re += x * cos(2 * M_PI * freq * i / rate);
+		im += x * sin(2 * M_PI * freq * i / rate);
+	}
+	re *= 2.0 / count;
+	im *= 2.0 / count;
+
+	double signal = 0.0, residual = 0.0;
+	for (int i = 0; i < count; ++i) {
+		const double fit = re * cos(2 * M_PI * freq * i / rate) + im * sin(2 * M_PI * freq * i / rate);
+		const double x = out[(start + i) * 2 + channel];
+		signal += fit * fit;
+		residual += (x - fit) * (x - fit);
+	}
+	return sqrt(residual / signal);
+}
+
+static double rateTestDecibels(double ratio) {
+	return 20 * log10(MAX(ratio, 1e-10));
+}
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_length() {
+		// The output has the expected length
+		static const int rates[][2] = { { 22050, 44100 }, { 22050, 48000 }, { 11025, 44100 }, { 48000, 44100 }, { 44100, 22050 } };
+		for (int i = 0; i < ARRAYSIZE(rates); ++i) {
+			const int inRate = rates[i][0], outRate = rates[i][1];
+			Audio::AudioStream *input = createRateTestStream(inRate, 440, 440, 8000, inRate, true);
+			Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, true, false, Audio::kRateConverterQualityMedium);
+
+			int16 *out = new int16[(outRate + 100) * 2];
+			const int len = convertRateTestStream(*input, *converter, out, outRate + 100);
+			TS_ASSERT_LESS_THAN_EQUALS(outRate - 1, len);
+			TS_ASSERT_LESS_THAN_EQUALS(len, outRate + 1);
+
+			delete[] out;
+			delete converter;
+			delete input;
+		}
+	}
+
+	void test_dc() {
+		// Constant input stays constant
+		int16 *data = (int16 *)malloc(4000 * sizeof(int16));
+		for (int i = 0; i < 4000; ++i)
+			WRITE_LE_UINT16(&data[i], 12345);
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream((const byte *)data, 4000 * sizeof(int16), DisposeAfterUse::YES);
+		Audio::AudioStream *input = Audio::makeRawStream(stream, 22050, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 48000, false, false, Audio::kRateConverterQualityMedium);
+
+		int16 *out = new int16[8000 * 2];
+		const int len = convertRateTestStream(*input, *converter, out, 8000);
+		TS_ASSERT_EQUALS(len, 8000);
+		for (int i = 100; i < 8000; ++i) {
+			TS_ASSERT_EQUALS(out[i * 2], 12345);
+			TS_ASSERT_EQUALS(out[i * 2 + 1], 12345);
+		}
+
+		delete[] out;
+		delete converter;
+		delete input;
+	}
+
+	void test_drain() {
+		// The output for the last input samples comes from drain(), which
+		// fills the rest of the history with silence
+		int16 *data = (int16 *)malloc(4000 * sizeof(int16));
+		for (int i = 0; i < 4000; ++i)
+			WRITE_LE_UINT16(&data[i], 12345);
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream((const byte *)data, 4000 * sizeof(int16), DisposeAfterUse::YES);
+		Audio::AudioStream *input = Audio::makeRawStream(stream, 22050, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, false, false, Audio::kRateConverterQualityMedium);
+
+		int16 *out = new int16[8100 * 2];
+		const int len = convertRateTestStream(*input, *converter, out, 8100);
+		TS_ASSERT_EQUALS(len, 8000);
+
+		// Half of the 16 taps, at twice the rate, in two calls
+		int drained = converter->drain(out + len * 2, 10, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_EQUALS(drained, 10);
+		drained += converter->drain(out + (len + drained) * 2, 100, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_EQUALS(drained, 16);
+		TS_ASSERT_EQUALS(converter->drain(out, 100, Audio::Mixer::kMaxMixerVolume), 0);
+
+		// The drained output continues the signal up to the last input
+		// sample, ringing a bit towards the step into silence. The very last
+		// output lies halfway into that step.
+		for (int i = len; i < len + 15; ++i)
+			TS_ASSERT_DELTA(out[i * 2], 12345, 12345 / (i < len + 6 ? 100 : 8));
+		TS_ASSERT_DELTA(out[(len + 15) * 2], 12345 / 2, 12345 / 8);
+
+		delete[] out;
+		delete converter;
+		delete input;
+	}
+
+	void test_stereo_channels() {
+		// Both channels are filtered separately, and reverse stereo swaps them
+		Audio::AudioStream *input = createRateTestStream(22050, 1000, 3000, 16000, 22050, true);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, true, true, Audio::kRateConverterQualityMedium);
+
+		int16 *out = new int16[44100 * 2];
+		TS_ASSERT_EQUALS(convertRateTestStream(*input, *converter, out, 44100), 44100);
+		TS_ASSERT_DELTA(rateTestAmplitude(out, 1, 100, 43218, 44100, 1000), 16000 / 32768.0, 0.005);
+		TS_ASSERT_DELTA(rateTestAmplitude(out, 0, 100, 43218, 44100, 3000), 16000 / 32768.0, 0.005);
+		TS_ASSERT_LESS_THAN(rateTestAmplitude(out, 0, 100, 43218, 44100, 1000), 0.0001);
+
+		delete[] out;
+		delete converter;
+		delete input;
+	}
+
+	void test_aliasing() {
+		// Upsampling a 5 kHz tone from 22050 Hz also creates images of it
+		// at 22050 - 5000 Hz, which the filter has to remove
+		double image[2];
+		for (int quality = 0; quality < 2; ++quality) {
+			Audio::AudioStream *input = createRateTestStream(22050, 5000, 5000, 16000, 22050, false);
+			Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, false, false,
+			                                  quality ? Audio::kRateConverterQualityMedium : Audio::kRateConverterQualityLow);
+
+			int16 *out = new int16[44100 * 2];
+			convertRateTestStream(*input, *converter, out, 44100);
+			image[quality] = rateTestAmplitude(out, 0, 100, 43218, 44100, 17050) / rateTestAmplitude(out, 0, 100, 43218, 44100, 5000);
+
+			delete[] out;
+			delete converter;
+			delete input;
+		}
+
+		TS_TRACE(Common::String::format("Image at 17050 Hz: linear %.1f dB, polyphase %.1f dB",
+		                                rateTestDecibels(image[0]), rateTestDecibels(image[1])).c_str());
+		TS_ASSERT_LESS_THAN(rateTestDecibels(image[1]), -60.0);
+		TS_ASSERT_LESS_THAN(image[1], image[0]);
+	}
+
+	void test_distortion() {
+		// Total harmonic distortion and noise of a 1 kHz tone
+		static const Audio::RateConverterQuality qualities[] = { Audio::kRateConverterQualityLow, Audio::kRateConverterQualityMedium, Audio::kRateConverterQualityHigh };
+		double distortion[3];
+		for (int i = 0; i < 3; ++i) {
+			Audio::AudioStream *input = createRateTestStream(22050, 1000, 1000, 16000, 22050, false);
+			Audio::RateConverter *converter = Audio::makeRateConverter(22050, 48000, false, false, qualities[i]);
+
+			int16 *out = new int16[48000 * 2];
+			convertRateTestStream(*input, *converter, out, 48000);
+			distortion[i] = rateTestDistortion(out, 0, 100, 47856, 48000, 1000);
+
+			delete[] out;
+			delete converter;
+			delete input;
+		}
+
+		TS_TRACE(Common::String::format("THD+N at 22050 -> 48000 Hz: low %.1f dB, medium %.1f dB, high %.1f dB",
+		                                rateTestDecibels(distortion[0]), rateTestDecibels(distortion[1]), rateTestDecibels(distortion[2])).c_str());
+		TS_ASSERT_LESS_THAN(rateTestDecibels(distortion[1]), -70.0);
+		TS_ASSERT_LESS_THAN(rateTestDecibels(distortion[2]), -80.0);
+		TS_ASSERT_LESS_THAN(distortion[1], distortion[0]);
+	}
+
+	void test_benchmark() {
+		// Compare the time of the linear and the medium converter for ten
+		// seconds of stereo audio. Timings are not reliable enough to check,
+		// and the SIMD code is much slower in unoptimized builds.
+#if __cplusplus >= 201103L
+		const int seconds = 10;
+		double ms[2];
+		for (int quality = 0; quality < 2; ++quality) {
+			Audio::AudioStream *input = createRateTestStream(22050, 440, 660, 16000, 22050 * seconds, true);
+			Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, true, false,
+			                                  quality ? Audio::kRateConverterQualityMedium : Audio::kRateConverterQualityLow);
+
+			int16 *out = new int16[44100 * seconds * 2];
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			convertRateTestStream(*input, *converter, out, 44100 * seconds);
+			ms[quality] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			delete[] out;
+			delete converter;
+			delete input;
+		}
+
+		TS_TRACE(Common::String::format("22050 -> 44100 Hz stereo, %d s: linear %.2f ms, polyphase %.2f ms", seconds,
+		                                ms[0], ms[1]).c_str());
+#endif
+	}
+};
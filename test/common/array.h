@@ -4,6 +4,22 @@
 #include "common/noncopyable.h"
 #include "common/str.h"
 
+// Counts how often instances get copied, to check that moves avoid it
+struct ArrayCopyCounter {
+	static int _copies;
+	int _value;
+
+	ArrayCopyCounter(int value = 0) : _value(value) {}
+	ArrayCopyCounter(const ArrayCopyCounter &other) : _value(other._value) { _copies++; }
+	ArrayCopyCounter &operator=(const ArrayCopyCounter &other) { _value = other._value; _copies++; return *this; }
+#if __cplusplus >= 201103L
+	ArrayCopyCounter(ArrayCopyCounter &&other) : _value(other._value) { other._value = -1; }
+	ArrayCopyCounter &operator=(ArrayCopyCounter &&other) { _value = other._value; other._value = -1; return *this; }
+#endif
+};
+
+int ArrayCopyCounter::_copies = 0;
+
 class ArrayTestSuite : public CxxTest::TestSuite
 {
 	public:
@@ -410,6 +426,47 @@ class ArrayTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(array[1], 163);
 	}
 
+	void test_move() {
+#if __cplusplus >= 201103L
+		Common::Array<ArrayCopyCounter> array;
+		ArrayCopyCounter::_copies = 0;
+
+		// Growing the storage moves the existing elements over
+		for (int i = 0; i < 100; ++i)
+			array.emplace_back(i);
+		ArrayCopyCounter element(100);
+		array.push_back(Common::move(element));
+		array.reserve(1000);
+		TS_ASSERT_EQUALS(ArrayCopyCounter::_copies, 0);
+		TS_ASSERT_EQUALS(array.size(), 101U);
+		TS_ASSERT_EQUALS(array[0]._value, 0);
+		TS_ASSERT_EQUALS(array[100]._value, 100);
+
+		// Moving the array takes over its storage
+		const ArrayCopyCounter *data = array.data();
+		Common::Array<ArrayCopyCounter> array2(Common::move(array));
+		TS_ASSERT(array.empty());
+		TS_ASSERT_EQUALS(array2.data(), data);
+
+		Common::Array<ArrayCopyCounter> array3;
+		array3.push_back(ArrayCopyCounter(-5));
+		array3 = Common::move(array2);
+		TS_ASSERT(array2.empty());
+		TS_ASSERT_EQUALS(array3.data(), data);
+		TS_ASSERT_EQUALS(ArrayCopyCounter::_copies, 0);
+
+		// Inserting an element of the array itself has to work when growing
+		Common::Array<Common::String> strings;
+		strings.push_back("A string long enough to need storage on the heap");
+		while (strings.size() < 8)
+			strings.push_back("x");
+		strings.emplace_back(strings[0]);
+		TS_ASSERT_EQUALS(strings[8], strings[0]);
+		strings.push_back(strings[8]);
+		TS_ASSERT_EQUALS(strings[9], "A string long enough to need storage on the heap");
+#endif
+	}
+
 };
 
 struct ListElement {
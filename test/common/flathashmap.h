@@ -0,0 +1,224 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+// Counts how often keys get compared, to measure the probing work
+struct FlatHashMapCountingEqualTo {
+	static uint _comparisons;
+	bool operator()(int x, int y) const { _comparisons++; return x == y; }
+};
+
+uint FlatHashMapCountingEqualTo::_comparisons = 0;
+
+// Sends every key to the same slot and control byte
+struct FlatHashMapCollidingHash {
+	uint operator()(int) const { return 5; }
+};
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		Common::FlatHashMap<Common::String, Common::String> container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		TS_ASSERT_EQUALS(container2["foo"], "bar");
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("FOO"));
+		TS_ASSERT(container2.contains("Quux"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		container.erase(0);
+		TS_ASSERT(!container.empty());
+		container.erase(1);
+		container.erase(2);
+		container.erase(3);
+		TS_ASSERT(!container.empty());
+		container.erase(4);
+		TS_ASSERT(container.empty());
+		container[1] = 33;
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 1U);
+		container.erase(container.find(1));
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container[2] = 45;
+
+		// We take a const ref now to ensure that the map
+		// is not modified by getVal.
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef[1], -1);
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(container.size(), 3U);
+	}
+
+	void test_collision() {
+		// These keys all hash to the same value, so they share a probe chain
+		Common::FlatHashMap<int, int, FlatHashMapCollidingHash> h;
+		h[5] = 1;
+		h[32+5] = 2;
+		h[64+5] = 3;
+		h[128+5] = 4;
+		h.erase(32+5);
+		TS_ASSERT(h.contains(5));
+		TS_ASSERT(h.contains(64+5));
+		TS_ASSERT(h.contains(128+5));
+		h.erase(5);
+		TS_ASSERT_EQUALS(h[64+5], 3);
+		TS_ASSERT_EQUALS(h[128+5], 4);
+		h[32+5] = 5;
+		TS_ASSERT_EQUALS(h.size(), 3U);
+		TS_ASSERT_EQUALS(h[32+5], 5);
+		h.erase(64+5);
+		h.erase(128+5);
+		h.erase(32+5);
+		TS_ASSERT(h.empty());
+	}
+
+	void test_iterator_erase() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 100; ++i)
+			container[i] = i * 2;
+
+		// Erasing the current entry must not disturb the iteration
+		int visited = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			TS_ASSERT_EQUALS(i->_value, i->_key * 2);
+			if (i->_key & 1)
+				container.erase(i);
+			visited++;
+		}
+		TS_ASSERT_EQUALS(visited, 100);
+		TS_ASSERT_EQUALS(container.size(), 50U);
+
+		int found = 0;
+		Common::FlatHashMap<int, int>::const_iterator j;
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		for (j = containerRef.begin(); j != containerRef.end(); ++j) {
+			TS_ASSERT(!(j->_key & 1));
+			found++;
+		}
+		TS_ASSERT_EQUALS(found, 50);
+
+		container.clear();
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_grow_and_churn() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5000; ++i)
+			container[i * 7919] = i;
+		TS_ASSERT_EQUALS(container.size(), 5000U);
+		for (int i = 0; i < 5000; ++i)
+			TS_ASSERT_EQUALS(container.getVal(i * 7919, -1), i);
+
+		// Repeatedly adding and removing leaves erased markers behind,
+		// which have to be cleaned up without losing entries
+		for (int i = 0; i < 20000; ++i) {
+			container.erase(i * 7919);
+			container[(i + 5000) * 7919] = i + 5000;
+		}
+		TS_ASSERT_EQUALS(container.size(), 5000U);
+		TS_ASSERT(!container.contains(0));
+		for (int i = 20000; i < 25000; ++i)
+			TS_ASSERT_EQUALS(container.getVal(i * 7919, -1), i);
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<Common::String, int> map1;
+		map1["one"] = 1;
+		map1["two"] = 2;
+		map1.erase("one");
+
+		Common::FlatHashMap<Common::String, int> map2(map1), map3;
+		map3["three"] = 3;
+		map3 = map1;
+		map1["two"] = 22;
+
+		TS_ASSERT_EQUALS(map2.size(), 1U);
+		TS_ASSERT_EQUALS(map2["two"], 2);
+		TS_ASSERT(!map3.contains("one"));
+		TS_ASSERT(!map3.contains("three"));
+		TS_ASSERT_EQUALS(map3["two"], 2);
+	}
+
+	void test_probe_count() {
+		// Compare how many key comparisons both maps need for the same
+		// workload, which is what dominates lookups of expensive keys
+		// such as strings. This checks probing work, not time.
+		const int kCount = 10000;
+		Common::HashMap<int, int, Common::Hash<int>, FlatHashMapCountingEqualTo> hashMap;
+		Common::FlatHashMap<int, int, Common::Hash<int>, FlatHashMapCountingEqualTo> flatMap;
+
+		FlatHashMapCountingEqualTo::_comparisons = 0;
+		for (int i = 0; i < kCount; ++i)
+			hashMap[i * 16] = i;
+		for (int i = 0; i < 2 * kCount; ++i)
+			hashMap.contains(i * 8);
+		const uint hashMapComparisons = FlatHashMapCountingEqualTo::_comparisons;
+
+		FlatHashMapCountingEqualTo::_comparisons = 0;
+		for (int i = 0; i < kCount; ++i)
+			flatMap[i * 16] = i;
+		for (int i = 0; i < 2 * kCount; ++i)
+			flatMap.contains(i * 8);
+		const uint flatMapComparisons = FlatHashMapCountingEqualTo::_comparisons;
+
+		TS_TRACE(Common::String::format("HashMap: %u key comparisons, FlatHashMap: %u key comparisons",
+		                                hashMapComparisons, flatMapComparisons).c_str());
+		TS_ASSERT_EQUALS(hashMap.size(), flatMap.size());
+		TS_ASSERT(flatMapComparisons <= hashMapComparisons);
+	}
+};
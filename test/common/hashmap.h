@@ -230,5 +230,36 @@ class HashMapTestSuite : public CxxTest::TestSuite
 		TS_ASSERT(found == 16+8+4);
 }
 
+	void test_move() {
+#if __cplusplus >= 201103L
+		Common::HashMap<Common::String, Common::String> map1;
+		map1["one"] = "A value long enough to need storage on the heap, one";
+		map1["two"] = "A value long enough to need storage on the heap, two";
+		map1.erase("one");
+		map1["three"] = "A value long enough to need storage on the heap, three";
+		const char *storage = map1["two"].c_str();
+
+		// The values are moved over, not copied
+		Common::HashMap<Common::String, Common::String> map2(Common::move(map1));
+		TS_ASSERT(map1.empty());
+		TS_ASSERT_EQUALS(map2.size(), 2U);
+		TS_ASSERT_EQUALS(map2["two"].c_str(), storage);
+		TS_ASSERT(!map2.contains("one"));
+
+		Common::HashMap<Common::String, Common::String> map3;
+		map3["four"] = "4";
+		map3 = Common::move(map2);
+		TS_ASSERT(map2.empty());
+		TS_ASSERT(!map3.contains("four"));
+		TS_ASSERT_EQUALS(map3["two"].c_str(), storage);
+		TS_ASSERT_EQUALS(map3["three"], "A value long enough to need storage on the heap, three");
+
+		Common::String value("A value long enough to need storage on the heap, five");
+		storage = value.c_str();
+		map1.setVal("five", Common::move(value));
+		TS_ASSERT_EQUALS(map1["five"].c_str(), storage);
+#endif
+	}
+
 	// TODO: Add test cases for iterators, find, ...
 };
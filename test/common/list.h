@@ -2,6 +2,21 @@
 
 #include "common/list.h"
 
+// Counts how often instances get copied, to check that moves avoid it
+struct ListCopyCounter {
+	static int _copies;
+	int _value;
+
+	ListCopyCounter(int value = 0) : _value(value) {}
+	ListCopyCounter(const ListCopyCounter &other) : _value(other._value) { _copies++; }
+	ListCopyCounter &operator=(const ListCopyCounter &other) { _value = other._value; _copies++; return *this; }
+#if __cplusplus >= 201103L
+	ListCopyCounter(ListCopyCounter &&other) : _value(other._value) { other._value = -1; }
+#endif
+};
+
+int ListCopyCounter::_copies = 0;
+
 class ListTestSuite : public CxxTest::TestSuite
 {
 	public:
@@ -272,4 +287,41 @@ class ListTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(container.front(), 99);
 		TS_ASSERT_EQUALS(container.back(),  99);
 	}
+
+	void test_move() {
+#if __cplusplus >= 201103L
+		Common::List<ListCopyCounter> container;
+		ListCopyCounter::_copies = 0;
+
+		container.emplace_back(2);
+		container.emplace_front(1);
+		ListCopyCounter element(3);
+		container.push_back(Common::move(element));
+		container.push_front(ListCopyCounter(0));
+		TS_ASSERT_EQUALS(container.size(), 4U);
+		TS_ASSERT_EQUALS(container.front()._value, 0);
+		TS_ASSERT_EQUALS(container.back()._value, 3);
+
+		// Moving the list relinks its nodes
+		Common::List<ListCopyCounter> container2(Common::move(container));
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container2.size(), 4U);
+
+		Common::List<ListCopyCounter> container3;
+		container3.emplace_back(-1);
+		container3 = Common::move(container2);
+		TS_ASSERT(container2.empty());
+		TS_ASSERT_EQUALS(ListCopyCounter::_copies, 0);
+
+		int expected = 0;
+		for (Common::List<ListCopyCounter>::const_iterator i = container3.begin(); i != container3.end(); ++i)
+			TS_ASSERT_EQUALS(i->_value, expected++);
+		TS_ASSERT_EQUALS(expected, 4);
+
+		// Both lists must still be usable
+		container2.push_back(ListCopyCounter(5));
+		TS_ASSERT_EQUALS(container2.size(), 1U);
+		TS_ASSERT_EQUALS(container3.reverse_begin()->_value, 3);
+#endif
+	}
 };
@@ -0,0 +1,90 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/str-intern.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+
+class InternedStringTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_empty() {
+		Common::InternedString str;
+		TS_ASSERT(str.empty());
+		TS_ASSERT_EQUALS(str.size(), 0U);
+		TS_ASSERT_EQUALS(str, Common::InternedString(""));
+		TS_ASSERT_EQUALS(str.str(), "");
+	}
+
+	void test_interning() {
+		Common::InternedString str1("intern_test.lab");
+		const uint poolSize = Common::InternedString::poolSize();
+
+		// The same string is only stored once
+		Common::String source("intern_test.lab");
+		Common::InternedString str2(source);
+		TS_ASSERT_EQUALS(str1, str2);
+		TS_ASSERT_EQUALS(str1.c_str(), str2.c_str());
+		TS_ASSERT_EQUALS(Common::InternedString::poolSize(), poolSize);
+
+		Common::InternedString str3("intern_test.lua");
+		TS_ASSERT_DIFFERS(str1, str3);
+		TS_ASSERT(str1 < str3);
+		TS_ASSERT(!(str3 < str1));
+		TS_ASSERT_EQUALS(str3.str(), "intern_test.lua");
+	}
+
+	void test_hashes() {
+		Common::InternedString str("Intern_Test.BM");
+
+		TS_ASSERT_EQUALS(str.hash(), Common::hashit("Intern_Test.BM"));
+		TS_ASSERT_EQUALS(str.hashIgnoreCase(), Common::hashit_lower("Intern_Test.BM"));
+		TS_ASSERT_EQUALS(str.hashIgnoreCase(), Common::InternedString("INTERN_TEST.bm").hashIgnoreCase());
+	}
+
+	void test_ignore_case() {
+		Common::InternedString str1("Intern_Test.SET");
+		Common::InternedString str2("intern_test.set");
+		Common::InternedString str3("INTERN_TEST.SET");
+
+		TS_ASSERT_DIFFERS(str1, str2);
+		TS_ASSERT(str1.equalsIgnoreCase(str2));
+		TS_ASSERT(str3.equalsIgnoreCase(str1));
+		TS_ASSERT(!str1.equalsIgnoreCase(Common::InternedString("intern_test.sed")));
+
+		TS_ASSERT_EQUALS(str1.toLowercase(), str2);
+		TS_ASSERT_EQUALS(str2.toLowercase(), str2);
+	}
+
+	void test_find() {
+		Common::InternedString str("Intern_Find.LAB");
+		const uint poolSize = Common::InternedString::poolSize();
+
+		Common::InternedString found;
+		TS_ASSERT(Common::InternedString::find("Intern_Find.LAB", found));
+		TS_ASSERT_EQUALS(found, str);
+
+		// Only the lowercase version was interned along with it
+		TS_ASSERT(!Common::InternedString::find("INTERN_FIND.LAB", found));
+		TS_ASSERT(Common::InternedString::find("INTERN_FIND.LAB", found, true));
+		TS_ASSERT_EQUALS(found, str.toLowercase());
+
+		// Strings which are not found are not added to the pool
+		TS_ASSERT(!Common::InternedString::find("intern_find.lua", found, true));
+		TS_ASSERT_EQUALS(Common::InternedString::poolSize(), poolSize);
+	}
+
+	void test_map_keys() {
+		Common::HashMap<Common::InternedString, int> map;
+		map["Intern_Key"] = 1;
+		map["intern_key"] = 2;
+		TS_ASSERT_EQUALS(map.size(), 2U);
+		TS_ASSERT_EQUALS(map[Common::InternedString("Intern_Key")], 1);
+
+		Common::HashMap<Common::InternedString, int, Common::InternedString_IgnoreCase_Hash, Common::InternedString_IgnoreCase_EqualTo> map2;
+		map2["Intern_Key"] = 1;
+		map2["INTERN_KEY"] = 2;
+		TS_ASSERT_EQUALS(map2.size(), 1U);
+		TS_ASSERT_EQUALS(map2["intern_key"], 2);
+		TS_ASSERT(!map2.contains("intern_key2"));
+	}
+};
@@ -270,6 +270,38 @@ class StringTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(str2, "01234567890123456789012345678901");
 	}
 
+	void test_move() {
+#if __cplusplus >= 201103L
+		// Moving a string takes over its heap storage instead of sharing it
+		Common::String str("01234567890123456789012345678901");
+		const char *storage = str.c_str();
+		Common::String str2(Common::move(str));
+		TS_ASSERT_EQUALS(str2.c_str(), storage);
+		TS_ASSERT(str.empty());
+
+		Common::String str3("short");
+		str3 = Common::move(str2);
+		TS_ASSERT_EQUALS(str3.c_str(), storage);
+		TS_ASSERT_EQUALS(str3, "01234567890123456789012345678901");
+		TS_ASSERT(str2.empty());
+
+		// Which still is unique, so it can be modified in place
+		str3.setChar('x', 0);
+		TS_ASSERT_EQUALS(str3.c_str(), storage);
+
+		// Short strings are stored internally and just get copied
+		Common::String str4("short");
+		Common::String str5(Common::move(str4));
+		TS_ASSERT_EQUALS(str5, "short");
+		TS_ASSERT(str4.empty());
+
+		// Moved from strings can be reused
+		str4 = "again";
+		str2 += "again";
+		TS_ASSERT_EQUALS(str4, str2);
+#endif
+	}
+
 	void test_lastPathComponent() {
 		TS_ASSERT_EQUALS(Common::lastPathComponent("/", '/'), "");
 		TS_ASSERT_EQUALS(Common::lastPathComponent("/foo/bar", '/'), "bar");
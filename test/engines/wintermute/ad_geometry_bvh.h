@@ -0,0 +1,199 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef ENABLE_WME3D
+#include "engines/wintermute/ad/ad_geometry_bvh.h"
+#include "engines/wintermute/base/gfx/3ds/mesh3ds.h"
+#include "engines/wintermute/math/math_util.h"
+
+// A bumpy square grid of triangles, n by n cells of the given size
+class BVHGridMesh : public Wintermute::Mesh3DS {
+public:
+	BVHGridMesh(int n, float x0, float z0, float size, uint32 &seed) {
+		_vertexCount = (n + 1) * (n + 1);
+		_vertexData = new Wintermute::GeometryVertex[_vertexCount];
+		for (int i = 0; i <= n; i++) {
+			for (int j = 0; j <= n; j++) {
+				Wintermute::GeometryVertex &v = _vertexData[i * (n + 1) + j];
+				v.x = x0 + i * size / n;
+				v.y = nextRandom(seed) * 2.0f;
+				v.z = z0 + j * size / n;
+			}
+		}
+
+		_indexCount = n * n * 6;
+		_indexData = new uint16[_indexCount];
+		int k = 0;
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < n; j++) {
+				int a = i * (n + 1) + j;
+				_indexData[k++] = a;
+				_indexData[k++] = a + 1;
+				_indexData[k++] = a + n + 1;
+				_indexData[k++] = a + 1;
+				_indexData[k++] = a + n + 2;
+				_indexData[k++] = a + n + 1;
+			}
+		}
+	}
+
+	void fillVertexBuffer(uint32 color) override {}
+	void render() override {}
+
+	// A number in [0, 1), the same on every platform
+	static float nextRandom(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		return ((seed >> 8) & 0xffff) / 65536.0f;
+	}
+};
+
+#endif
+
+class AdGeometryBVHTestSuite : public CxxTest::TestSuite {
+#ifdef ENABLE_WME3D
+	enum QueryKind {
+		kVerticalLine,
+		kSegment,
+		kLine
+	};
+
+	static const int kMeshes = 6;
+
+	Wintermute::AdGeometryBVH _tree;
+	BVHGridMesh *_meshes[kMeshes];
+	uint32 _seed;
+
+	// The candidates which really are hit, like AdSceneGeometry tests them
+	void exactHits(QueryKind kind, const Math::Vector3d &start, const Math::Vector3d &end,
+	               const Common::Array<uint32> &candidates, Common::Array<uint32> &hits) {
+		Math::Vector3d direction = end - start;
+		direction.normalize();
+
+		hits.clear();
+		for (uint i = 0; i < candidates.size(); i++) {
+			uint32 t = candidates[i];
+			const Math::Vector3d &v0 = _tree.getVertex(t, 0);
+			const Math::Vector3d &v1 = _tree.getVertex(t, 1);
+			const Math::Vector3d &v2 = _tree.getVertex(t, 2);
+			Math::Vector3d intersection;
+			float distance;
+			bool hit;
+
+			switch (kind) {
+			case kVerticalLine:
+				hit = Wintermute::lineIntersectsTriangle(start, Math::Vector3d(0, -1, 0), v0, v1, v2,
+				                                         intersection.x(), intersection.y(), intersection.z()) &&
+				      intersection.y() <= start.y();
+				break;
+			case kSegment:
+				// Crosses the plane between the ends, and the line hits the triangle
+				hit = Wintermute::lineSegmentIntersectsTriangle(start, end, v0, v1, v2, intersection, distance) &&
+				      Wintermute::lineIntersectsTriangle(start, start - end, v0, v1, v2,
+				                                         intersection.x(), intersection.y(), intersection.z());
+				break;
+			default:
+				hit = Wintermute::lineIntersectsTriangle(start, direction, v0, v1, v2,
+				                                         intersection.x(), intersection.y(), intersection.z());
+				break;
+			}
+
+			if (hit)
+				hits.push_back(t);
+		}
+	}
+
+	// Run random queries of every kind and compare the hits among the tree's
+	// candidates with those among all active triangles
+	void checkAgainstBruteForce(int queries) {
+		Common::Array<uint32> all, candidates, expected, hits;
+		_tree.queryAll(all);
+
+		for (int q = 0; q < queries; q++) {
+			Math::Vector3d start(BVHGridMesh::nextRandom(_seed) * 300, BVHGridMesh::nextRandom(_seed) * 3, BVHGridMesh::nextRandom(_seed) * 200);
+			Math::Vector3d end(BVHGridMesh::nextRandom(_seed) * 300, BVHGridMesh::nextRandom(_seed) * 3, BVHGridMesh::nextRandom(_seed) * 200);
+			Math::Vector3d direction = end - start;
+			direction.normalize();
+
+			for (int kind = kVerticalLine; kind <= kLine; kind++) {
+				switch (kind) {
+				case kVerticalLine:
+					_tree.queryVerticalLine(start.x(), start.z(), start.y(), candidates);
+					break;
+				case kSegment:
+					_tree.querySegment(start, end, candidates);
+					break;
+				default:
+					_tree.queryLine(start, direction, candidates);
+					break;
+				}
+
+				// The candidates come in the order the triangles were added
+				for (uint i = 1; i < candidates.size(); i++)
+					TS_ASSERT_LESS_THAN(candidates[i - 1], candidates[i]);
+
+				exactHits((QueryKind)kind, start, end, all, expected);
+				exactHits((QueryKind)kind, start, end, candidates, hits);
+				TS_ASSERT_EQUALS(hits, expected);
+			}
+		}
+	}
+
+	bool hasOwner(const Common::Array<uint32> &triangles, int owner) {
+		for (uint i = 0; i < triangles.size(); i++) {
+			if (_tree.getOwner(triangles[i]) == owner)
+				return true;
+		}
+		return false;
+	}
+#endif
+
+public:
+	void setUp() {
+#ifdef ENABLE_WME3D
+		_seed = 1;
+		for (int m = 0; m < kMeshes; m++) {
+			_meshes[m] = new BVHGridMesh(16, (m % 3) * 100.0f, (m / 3) * 100.0f, 100.0f, _seed);
+			_tree.addMesh(_meshes[m], m);
+		}
+		_tree.build();
+#endif
+	}
+
+	void tearDown() {
+#ifdef ENABLE_WME3D
+		_tree.clear();
+		for (int m = 0; m < kMeshes; m++)
+			delete _meshes[m];
+#endif
+	}
+
+	void test_queries_match_brute_force() {
+#ifdef ENABLE_WME3D
+		TS_ASSERT_EQUALS(_tree.triangleCount(), (uint32)(kMeshes * 16 * 16 * 2));
+		checkAgainstBruteForce(200);
+#endif
+	}
+
+	void test_refit_after_enable() {
+#ifdef ENABLE_WME3D
+		// A vertical line through the middle of the grid of mesh 4
+		Common::Array<uint32> candidates;
+		_tree.queryVerticalLine(150.5f, 150.5f, 10.0f, candidates);
+		TS_ASSERT(hasOwner(candidates, 4));
+
+		_tree.setOwnerActive(4, false);
+		_tree.queryVerticalLine(150.5f, 150.5f, 10.0f, candidates);
+		TS_ASSERT(!hasOwner(candidates, 4));
+		_tree.queryAll(candidates);
+		TS_ASSERT(!hasOwner(candidates, 4));
+		checkAgainstBruteForce(50);
+
+		// Enabling the owner again refits the boxes it was left out of
+		_tree.setOwnerActive(4, true);
+		_tree.queryVerticalLine(150.5f, 150.5f, 10.0f, candidates);
+		TS_ASSERT(hasOwner(candidates, 4));
+		checkAgainstBruteForce(50);
+#endif
+	}
+};
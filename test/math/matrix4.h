@@ -0,0 +1,231 @@
+#include <cxxtest/TestSuite.h>
+
+#include "math/matrix4.h"
+#include "math/quat.h"
+
+#include "common/str.h"
+
+#if __cplusplus >= 201103L
+#include <chrono>
+#endif
+
+// A fixed sequence of values in [-range, range), so that failures repeat
+static float matrix4TestValue(uint32 &seed, float range) {
+	seed = seed * 1103515245 + 12345;
+	return ((seed >> 8) & 0xFFFF) / 32768.0f * range - range;
+}
+
+static Math::Matrix4 matrix4TestMatrix(uint32 &seed) {
+	Math::Matrix4 m;
+	for (int row = 0; row < 4; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			m(row, col) = matrix4TestValue(seed, 10.0f);
+		}
+	}
+	return m;
+}
+
+// The plain triple loop, which the optimized versions have to match
+static Math::Matrix4 matrix4TestMultiply(const Math::Matrix4 &m1, const Math::Matrix4 &m2) {
+	Math::Matrix4 result;
+	for (int row = 0; row < 4; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			float sum = 0.0f;
+			for (int j = 0; j < 4; ++j) {
+				sum += m1(row, j) * m2(j, col);
+			}
+			result(row, col) = sum;
+		}
+	}
+	return result;
+}
+
+static Math::Vector3d matrix4TestTransform(const Math::Matrix4 &m, const Math::Vector3d &v, bool translate) {
+	Math::Vector3d result;
+	for (int row = 0; row < 3; ++row) {
+		float sum = 0.0f;
+		for (int j = 0; j < 3; ++j) {
+			sum += m(row, j) * v.getValue(j);
+		}
+		if (translate) {
+			sum += m(row, 3);
+		}
+		result.setValue(row, sum);
+	}
+	return result;
+}
+
+class Matrix4TestSuite : public CxxTest::TestSuite {
+public:
+	void test_multiply() {
+		uint32 seed = 1;
+		for (int i = 0; i < 100; ++i) {
+			Math::Matrix4 m1 = matrix4TestMatrix(seed);
+			Math::Matrix4 m2 = matrix4TestMatrix(seed);
+			Math::Matrix4 result = m1 * m2;
+			Math::Matrix4 expected = matrix4TestMultiply(m1, m2);
+
+			for (int j = 0; j < 16; ++j) {
+				TS_ASSERT_DELTA(result.getData()[j], expected.getData()[j], 1e-4f);
+			}
+		}
+
+		// Multiplying with the identity changes nothing
+		Math::Matrix4 m = matrix4TestMatrix(seed);
+		Math::Matrix4 identity;
+		TS_ASSERT(m * identity == m);
+		TS_ASSERT(identity * m == m);
+	}
+
+	void test_transform() {
+		uint32 seed = 2;
+		Math::Matrix4 m = matrix4TestMatrix(seed);
+		for (int i = 0; i < 100; ++i) {
+			Math::Vector3d v(matrix4TestValue(seed, 100.0f), matrix4TestValue(seed, 100.0f), matrix4TestValue(seed, 100.0f));
+
+			Math::Vector3d point = v;
+			m.transform(&point, true);
+			TS_ASSERT((point - matrix4TestTransform(m, v, true)).getMagnitude() < 1e-3f);
+
+			Math::Vector3d vector = v;
+			m.transform(&vector, false);
+			TS_ASSERT((vector - matrix4TestTransform(m, v, false)).getMagnitude() < 1e-3f);
+		}
+	}
+
+	void test_transform_array() {
+		// Transforming arrays gives the same as transforming one vector
+		// after the other, also when working in place
+		uint32 seed = 3;
+		Math::Matrix4 m = matrix4TestMatrix(seed);
+		const int count = 37;
+		Math::Vector3d src[count], dst[count];
+		for (int i = 0; i < count; ++i) {
+			src[i].set(matrix4TestValue(seed, 100.0f), matrix4TestValue(seed, 100.0f), matrix4TestValue(seed, 100.0f));
+		}
+
+		for (int translate = 0; translate < 2; ++translate) {
+			m.transform(src, dst, count, translate != 0);
+			for (int i = 0; i < count; ++i) {
+				Math::Vector3d expected = src[i];
+				m.transform(&expected, translate != 0);
+				TS_ASSERT((dst[i] - expected).getMagnitude() < 1e-3f);
+			}
+		}
+
+		Math::Vector3d inPlace[count];
+		for (int i = 0; i < count; ++i) {
+			inPlace[i] = src[i];
+		}
+		m.transform(inPlace, inPlace, count, true);
+		m.transform(src, dst, count, true);
+		for (int i = 0; i < count; ++i) {
+			TS_ASSERT(inPlace[i] == dst[i]);
+		}
+	}
+
+	void test_slerp() {
+		uint32 seed = 4;
+		for (int i = 0; i < 100; ++i) {
+			Math::Quaternion q1(matrix4TestValue(seed, 1.0f), matrix4TestValue(seed, 1.0f), matrix4TestValue(seed, 1.0f), matrix4TestValue(seed, 1.0f));
+			Math::Quaternion q2(matrix4TestValue(seed, 1.0f), matrix4TestValue(seed, 1.0f), matrix4TestValue(seed, 1.0f), matrix4TestValue(seed, 1.0f));
+			q1.normalize();
+			q2.normalize();
+			const float t = (i % 11) / 10.0f;
+
+			// Compare with the spherical interpolation along the shorter arc
+			float cosTheta = q1.dotProduct(q2);
+			Math::Quaternion to = q2;
+			if (cosTheta < 0.0f) {
+				cosTheta = -cosTheta;
+				to = Math::Quaternion(-q2.x(), -q2.y(), -q2.z(), -q2.w());
+			}
+			const float theta = acosf(MIN(cosTheta, 1.0f));
+			Math::Quaternion expected;
+			if (theta > 0.001f) {
+				const float s0 = sinf((1.0f - t) * theta) / sinf(theta);
+				const float s1 = sinf(t * theta) / sinf(theta);
+				expected = Math::Quaternion(q1.x() * s0 + to.x() * s1, q1.y() * s0 + to.y() * s1,
+				                            q1.z() * s0 + to.z() * s1, q1.w() * s0 + to.w() * s1);
+			} else {
+				expected = q1;
+			}
+
+			Math::Quaternion result = q1.slerpQuat(q2, t);
+			TS_ASSERT_DELTA(result.x(), expected.x(), 1e-4f);
+			TS_ASSERT_DELTA(result.y(), expected.y(), 1e-4f);
+			TS_ASSERT_DELTA(result.z(), expected.z(), 1e-4f);
+			TS_ASSERT_DELTA(result.w(), expected.w(), 1e-4f);
+			TS_ASSERT_DELTA(result.getMagnitude(), 1.0f, 1e-4f);
+		}
+
+		// The end points are reproduced
+		Math::Quaternion a(0.0f, 0.0f, 0.0f, 1.0f);
+		Math::Quaternion b = Math::Quaternion::xAxis(90);
+		Math::Quaternion start = a.slerpQuat(b, 0.0f);
+		Math::Quaternion end = a.slerpQuat(b, 1.0f);
+		TS_ASSERT_DELTA(start.w(), 1.0f, 1e-6f);
+		TS_ASSERT_DELTA(end.x(), b.x(), 1e-6f);
+		TS_ASSERT_DELTA(end.w(), b.w(), 1e-6f);
+	}
+
+	void test_normalize_zero() {
+		// A zero quaternion can not be normalized and stays as it is
+		Math::Quaternion q(0.0f, 0.0f, 0.0f, 0.0f);
+		q.normalize();
+		TS_ASSERT(q.x() == 0.0f && q.y() == 0.0f && q.z() == 0.0f && q.w() == 0.0f);
+	}
+
+	void test_benchmark() {
+		// Compare the plain loops with the optimized functions. Timings
+		// are not reliable enough to check.
+#if __cplusplus >= 201103L
+		const int count = 4096;
+		const int rounds = 100;
+		uint32 seed = 5;
+		Math::Matrix4 *matrices = new Math::Matrix4[count];
+		Math::Vector3d *vectors = new Math::Vector3d[count];
+		Math::Vector3d *results = new Math::Vector3d[count];
+		for (int i = 0; i < count; ++i) {
+			matrices[i] = matrix4TestMatrix(seed);
+			vectors[i].set(matrix4TestValue(seed, 100.0f), matrix4TestValue(seed, 100.0f), matrix4TestValue(seed, 100.0f));
+		}
+
+		double ms[4];
+		float check = 0.0f;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r) {
+			for (int i = 1; i < count; ++i)
+				check += matrix4TestMultiply(matrices[i - 1], matrices[i])(0, 0);
+		}
+		ms[0] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r) {
+			for (int i = 1; i < count; ++i)
+				check += (matrices[i - 1] * matrices[i])(0, 0);
+		}
+		ms[1] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r) {
+			for (int i = 0; i < count; ++i)
+				results[i] = matrix4TestTransform(matrices[r], vectors[i], true);
+		}
+		ms[2] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r) {
+			matrices[r].transform(vectors, results, count, true);
+		}
+		ms[3] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		TS_TRACE(Common::String::format("%d matrix products: loops %.2f ms, Matrix4 %.2f ms; %d transforms: loops %.2f ms, Matrix4 %.2f ms (%g)",
+		                                rounds * (count - 1), ms[0], ms[1], rounds * count, ms[2], ms[3], check + results[0].x()).c_str());
+
+		delete[] matrices;
+		delete[] vectors;
+		delete[] results;
+#endif
+	}
+};